@@ -47,6 +47,7 @@
 #  include <numa.h>
 #endif
 #include "utils.h"
+#include "bench.h"
 #include "atomic_ops.h"
 
 #define XSTR(s) #s
@@ -84,37 +85,6 @@ typedef union {
 
 __attribute__((aligned(CACHE_LINE_SIZE))) volatile data_t * the_data;
 
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 typedef struct thread_data {
     barrier_t *barrier;
     unsigned long num_operations;
@@ -122,7 +92,7 @@ typedef struct thread_data {
     unsigned long num_measured;
     int id;
     char padding[CACHE_LINE_SIZE];
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test_latency(void *data)
 {
@@ -403,16 +373,6 @@ void *test_throughput(void *data)
 }
 
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
-
-
 int main(int argc, char* const argv[])
 {
     set_cpu(the_cores[0]);
@@ -435,10 +395,7 @@ int main(int argc, char* const argv[])
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
 
     num_entries = DEFAULT_NUM_ENTRIES;
     num_threads = DEFAULT_NUM_THREADS;
@@ -446,7 +403,6 @@ int main(int argc, char* const argv[])
     benchmark = DEFAULT_BENCHMARK;
     op_pause = DEFAULT_PAUSE;
 
-    sigset_t block_set;
 
     while(1) {
         i = 0;
@@ -521,8 +477,6 @@ int main(int argc, char* const argv[])
             (int)sizeof(long),
             (int)sizeof(void *));
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
 
     the_data = (data_t*)malloc(num_entries * sizeof(data_t));
@@ -530,7 +484,7 @@ int main(int argc, char* const argv[])
         the_data[i].data=0;
     }
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -543,8 +497,6 @@ int main(int argc, char* const argv[])
     stop = 0;
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
         data[i].id = i;
         data[i].num_operations = 0;
@@ -575,49 +527,25 @@ int main(int argc, char* const argv[])
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
 #endif
-        if (pthread_create(&threads[i], &attr, test_function, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test_function, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
-    barrier_cross(&barrier);
-
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+    duration = bench_run(&barrier, duration);
     stop = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
 
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
     unsigned long operations = 0;
     unsigned long total_measurements = 0;
@@ -14,7 +14,9 @@
 #include "gl_lock.h"
 #include "atomic_ops.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
+#include "ccsynch.h"
 
 #ifdef DEBUG
 # define IO_FLUSH                       fflush(NULL)
@@ -39,6 +41,9 @@
 #define DEFAULT_READ_THREADS            0
 #define DEFAULT_WRITE_THREADS           0
 #define DEFAULT_DISJOINT                0
+#define DEFAULT_COMBINE                 0
+#define DEFAULT_LOCK_SETS               0
+#define DEFAULT_SNAPSHOT                0
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -57,6 +62,18 @@ __thread uint32_t cluster_id;
 lock_global_data the_lock;
 __attribute__((aligned(CACHE_LINE_SIZE))) lock_local_data * local_th_data;
 
+//transfers and reads are submitted to a combining lock instead
+int combine;
+ccsynch_global_params comb_lock;
+__attribute__((aligned(CACHE_LINE_SIZE))) ccsynch_local_params * comb_th_data;
+
+//every operation takes the locks of its accounts, one per account, as a lock set (lock_set.h)
+int lock_sets;
+global_data account_locks;
+__attribute__((aligned(CACHE_LINE_SIZE))) local_data * account_th_data;
+//accounts read by a read-all transaction (0 = all)
+int snapshot;
+
 /* ################################################################### *
  * BANK ACCOUNTS
  * ################################################################### */
@@ -76,9 +93,44 @@ typedef struct bank {
 
 
 
+/* critical sections run by the combiner */
+typedef struct bank_op {
+    volatile account_t *a1;
+    volatile account_t *a2;
+    int amount;
+} bank_op_t;
+
+void *read_accounts_cs(void *arg)
+{
+    bank_op_t *op = (bank_op_t *)arg;
+    return (void *)(intptr_t)(op->a1->balance + op->a2->balance);
+}
+
+void *transfer_cs(void *arg)
+{
+    bank_op_t *op = (bank_op_t *)arg;
+    op->a1->balance-=op->amount;
+    op->a2->balance+=op->amount;
+    return NULL;
+}
+
 int read_accounts(volatile account_t *a1, volatile account_t *a2,  int thread_id)
 {
     int amount=0;
+    if (combine) {
+        bank_op_t op = { a1, a2, 0 };
+        return (int)(intptr_t)ccsynch_execute(comb_lock.the_lock, &comb_th_data[thread_id], read_accounts_cs, &op);
+    }
+    if (lock_sets) {
+        lock_set_t set;
+        lock_set_init(&set);
+        lock_set_add(&set, a1->number);
+        lock_set_add(&set, a2->number);
+        lock_set_acquire_read(&set, account_th_data[thread_id], account_locks);
+        amount = a1->balance + a2->balance;
+        lock_set_release_read(&set, account_th_data[thread_id], account_locks);
+        return amount;
+    }
     if (use_locks!=0){
     acquire_read(&(local_th_data[thread_id]),&the_lock);
     }
@@ -96,6 +148,22 @@ int read_accounts(volatile account_t *a1, volatile account_t *a2,  int thread_id
 int transfer(volatile account_t *src, volatile account_t *dst, int amount, int thread_id)
 {
     /* Allow overdrafts */
+    if (combine) {
+        bank_op_t op = { src, dst, amount };
+        ccsynch_execute(comb_lock.the_lock, &comb_th_data[thread_id], transfer_cs, &op);
+        return amount;
+    }
+    if (lock_sets) {
+        lock_set_t set;
+        lock_set_init(&set);
+        lock_set_add(&set, src->number);
+        lock_set_add(&set, dst->number);
+        lock_set_acquire(&set, account_th_data[thread_id], account_locks);
+        src->balance-=amount;
+        dst->balance+=amount;
+        lock_set_release(&set, account_th_data[thread_id], account_locks);
+        return amount;
+    }
     if (use_locks!=0) {
     acquire_write(&(local_th_data[thread_id]),&the_lock);
     }
@@ -125,9 +193,44 @@ int total(bank_t *bank, int transactional)
     return total;
 }
 
-void reset(bank_t *bank)
+//sum of the accounts first to first + count - 1
+int snapshot_accounts(bank_t *bank, int first, int count, int thread_id)
+{
+    int i, total;
+    lock_set_t set;
+    if (lock_sets) {
+        lock_set_init(&set);
+        lock_set_add_range(&set, first, count);
+        lock_set_acquire_read(&set, account_th_data[thread_id], account_locks);
+    } else if (use_locks!=0) {
+        global_acquire_read(&gl);
+    }
+    total = 0;
+    for (i = first; i < first + count; i++) {
+        total += bank->accounts[i].balance;
+    }
+    if (lock_sets) {
+        lock_set_release_read(&set, account_th_data[thread_id], account_locks);
+    } else if (use_locks!=0) {
+        global_unlock_read(&gl);
+    }
+    return total;
+}
+
+void reset(bank_t *bank, int thread_id)
 {
     int i;
+    lock_set_t set;
+    if (lock_sets) {
+        lock_set_init(&set);
+        lock_set_add_range(&set, 0, bank->size);
+        lock_set_acquire(&set, account_th_data[thread_id], account_locks);
+        for (i = 0; i < bank->size; i++) {
+            bank->accounts[i].balance = 0;
+        }
+        lock_set_release(&set, account_th_data[thread_id], account_locks);
+        return;
+    }
     if (use_locks!=0) {
         global_acquire_write(&gl);
     }
@@ -143,37 +246,6 @@ void reset(bank_t *bank)
  * BARRIER
  * ################################################################### */
 
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 /* ################################################################### *
  * STRESS TEST
  * ################################################################### */
@@ -199,7 +271,10 @@ typedef struct thread_data {
     };
     uint8_t padding[2 * CACHE_LINE_SIZE];
   };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
+
+//with --disjoint, every thread uses its own rand_max accounts from rand_min
+#define PICK_ACCOUNT(d, r) ((d)->disjoint ? rand_min + (int) ((r) % rand_max) : (int) ((r) & rand_max))
 
 void *test(void *data)
 {
@@ -240,6 +315,13 @@ void *test(void *data)
 
     /* local initialization of locks */
     init_lock_local(phys_id, &the_lock, &(local_th_data[d->id]));
+    if (combine) {
+        init_ccsynch_local(phys_id, &comb_th_data[d->id]);
+    }
+    if (lock_sets) {
+        account_th_data[d->id] = init_lock_array_local(phys_id, d->bank->size, account_locks);
+    }
+    int snapshot_size = (snapshot > 0 && snapshot < d->bank->size) ? snapshot : d->bank->size;
 
     /* Wait on barrier */
     barrier_cross(d->barrier);
@@ -252,11 +334,11 @@ void *test(void *data)
     while (stop[0] == 0) {
         if (d->id < d->read_threads) {
             /* Read all */
-            total(d->bank, 1);
+            snapshot_accounts(d->bank, (int) (my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) % (d->bank->size - snapshot_size + 1)), snapshot_size, d->id);
             d->nb_read_all++;
         } else if (d->id < d->read_threads + d->write_threads) {
             /* Write all */
-            reset(d->bank);
+            reset(d->bank, d->id);
             d->nb_write_all++;
         } else {
             //nb = (int)(erand48(seed) * 100);
@@ -267,8 +349,8 @@ void *test(void *data)
                 d->nb_read_all++;
 
                 //actually, just read a couple of accounts
-                n1=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & rand_max;
-                n2=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[3])) & rand_max;
+                n1=PICK_ACCOUNT(d, my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])));
+                n2=PICK_ACCOUNT(d, my_random(&(seeds[0]),&(seeds[1]),&(seeds[3])));
 
                 // n1 = (int)(erand48(seed) * rand_max) + rand_min;
                 // n2 = (int)(erand48(seed) * rand_max) + rand_min;
@@ -278,12 +360,12 @@ void *test(void *data)
 
             } else if (nb < read_write_thresh) {
                 /* Write all */
-                reset(d->bank);
+                reset(d->bank, d->id);
                 d->nb_write_all++;
             } else {
                 /* Choose random accounts */
-                src=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & rand_max;
-                dst=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & rand_max;
+                src=PICK_ACCOUNT(d, my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])));
+                dst=PICK_ACCOUNT(d, my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])));
                 ammount=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[3])) & 0xf;
 
                 //  src = (int)(erand48(seed) * rand_max) + rand_min;
@@ -297,17 +379,12 @@ void *test(void *data)
     }
     /* Free locks */
     //free_local(local_th_data[d->id], d->bank->size);
+#ifdef LOCK_ELISION
+    elide_stats_flush();
+#endif
     return NULL;
 }
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
 
 int main(int argc, char **argv)
 {
@@ -326,6 +403,9 @@ int main(int argc, char **argv)
         {"write-all-rate",            required_argument, NULL, 'w'},
         {"write-threads",             required_argument, NULL, 'W'},
         {"disjoint",                  no_argument,       NULL, 'j'},
+        {"combine",                   no_argument,       NULL, 'C'},
+        {"lock-sets",                 no_argument,       NULL, 'S'},
+        {"snapshot",                  required_argument, NULL, 'g'},
         {NULL, 0, NULL, 0}
     };
 
@@ -334,10 +414,7 @@ int main(int argc, char **argv)
     unsigned long reads, writes, updates;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     int duration = DEFAULT_DURATION;
     int nb_accounts = DEFAULT_NB_ACCOUNTS;
     int nb_threads = DEFAULT_NB_THREADS;
@@ -348,13 +425,13 @@ int main(int argc, char **argv)
     int write_all = DEFAULT_WRITE_ALL;
     int write_threads = DEFAULT_WRITE_THREADS;
     int disjoint = DEFAULT_DISJOINT;
-
-
-    sigset_t block_set;
+    combine = DEFAULT_COMBINE;
+    lock_sets = DEFAULT_LOCK_SETS;
+    snapshot = DEFAULT_SNAPSHOT;
 
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "ha:c:d:n:r:R:s:l:w:W:j", long_options, &i);
+        c = getopt_long(argc, argv, "ha:c:d:n:r:R:s:l:w:W:jCSg:", long_options, &i);
 
         if(c == -1)
             break;
@@ -393,6 +470,12 @@ int main(int argc, char **argv)
                         "        Percentage of write-all transactions (default=" XSTR(DEFAULT_WRITE_ALL) ")\n"
                         "  -W, --write-threads <int>\n"
                         "        Number of threads issuing only write-all transactions (default=" XSTR(DEFAULT_WRITE_THREADS) ")\n"
+                        "  -C, --combine\n"
+                        "        Submit the transfers and reads to a combining lock (ccsynch.h) instead of acquiring the lock\n"
+                        "  -S, --lock-sets\n"
+                        "        Lock every account instead of the bank; operations take their accounts as a lock set (lock_set.h)\n"
+                        "  -g, --snapshot <int>\n"
+                        "        Number of consecutive accounts read by a read-all transaction (0=all, default=" XSTR(DEFAULT_SNAPSHOT) ")\n"
                         );
                 exit(0);
             case 'a':
@@ -425,6 +508,15 @@ int main(int argc, char **argv)
             case 'j':
                 disjoint = 1;
                 break;
+            case 'C':
+                combine = 1;
+                break;
+            case 'S':
+                lock_sets = 1;
+                break;
+            case 'g':
+                snapshot = atoi(optarg);
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -450,15 +542,16 @@ int main(int argc, char **argv)
     printf("Use locks      : %d\n", use_locks);
     printf("Write-all rate : %d\n", write_all);
     printf("Write threads  : %d\n", write_threads);
+    printf("Combining      : %d\n", combine);
+    printf("Lock sets      : %d\n", lock_sets);
+    printf("Snapshot       : %d\n", snapshot);
     printf("Type sizes     : int=%d/long=%d/ptr=%d\n",
             (int)sizeof(int),
             (int)sizeof(long),
             (int)sizeof(void *));
 //#endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(nb_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(nb_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -480,7 +573,7 @@ int main(int argc, char **argv)
         bank->accounts[i].balance = 0;
     }
 
-    gl.lock_data = 0;
+    global_lock_init(&gl);
 
     local_th_data = (lock_local_data *)malloc(nb_threads*sizeof(lock_local_data));
 
@@ -491,11 +584,17 @@ int main(int argc, char **argv)
     printf("Initializing locks\n");
 #endif
     init_lock_global_nt(nb_threads,&the_lock);
+    if (lock_sets) {
+        account_locks = init_lock_array_global(nb_accounts, nb_threads);
+        account_th_data = (local_data *)malloc(nb_threads*sizeof(local_data));
+    }
+    if (combine) {
+        init_ccsynch_global(&comb_lock);
+        comb_th_data = (ccsynch_local_params *)malloc(nb_threads*sizeof(ccsynch_local_params));
+    }
 
     /* Access set from all threads */
     barrier_init(&barrier, nb_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < nb_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -513,49 +612,26 @@ int main(int argc, char **argv)
         data[i].seed = rand();
         data[i].bank = bank;
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
 
     /* Start threads */
-    barrier_cross(&barrier);
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
-#endif    
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+#endif
+    duration = bench_run(&barrier, duration);
     stop[0] = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif    
 
     /* Wait for thread completion */
-    for (i = 0; i < nb_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, nb_threads);
 
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
     reads = 0;
     writes = 0;
     updates = 0;
@@ -577,6 +653,9 @@ int main(int argc, char **argv)
     printf("#write txs    : %lu ( %f / s)\n", writes, writes * 1000.0 / duration);
     printf("#update txs   : %lu ( %f / s)\n", updates, updates * 1000.0 / duration);
 //#endif
+#ifdef LOCK_ELISION
+    elide_stats_print();
+#endif
     printf("#txs          : %lu ( %lu / s)\n", reads + writes + updates,(unsigned long)((reads + writes + updates) * 1000.0 / duration));
     /* Delete bank and accounts */
     free((void*) bank->accounts);
@@ -13,6 +13,7 @@
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "atomic_ops.h"
 #include "lock_if.h"
 
@@ -155,38 +156,6 @@ withdraw(account_t *src, int amount, int thread_id)
  * BARRIER
  * ################################################################### */
 
-typedef struct barrier 
-{
-  pthread_cond_t complete;
-  pthread_mutex_t mutex;
-  int count;
-  int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-  pthread_cond_init(&b->complete, NULL);
-  pthread_mutex_init(&b->mutex, NULL);
-  b->count = n;
-  b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-  pthread_mutex_lock(&b->mutex);
-  /* One more thread through */
-  b->crossing++;
-  /* If not all here, wait */
-  if (b->crossing < b->count) {
-    pthread_cond_wait(&b->complete, &b->mutex);
-  } else {
-    pthread_cond_broadcast(&b->complete);
-    /* Reset for next time */
-    b->crossing = 0;
-  }
-  pthread_mutex_unlock(&b->mutex);
-}
-
 /* ################################################################### *
  * STRESS TEST
  * ################################################################### */
@@ -211,7 +180,7 @@ typedef struct thread_data
     };
     uint8_t padding[2 * CACHE_LINE_SIZE];
   };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test(void *data)
 {
@@ -262,14 +231,6 @@ void *test(void *data)
   return NULL;
 }
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
 
 int 
 main(int argc, char **argv)
@@ -293,10 +254,7 @@ main(int argc, char **argv)
   unsigned long reads, writes, updates;
   thread_data_t *data;
   pthread_t *threads;
-  pthread_attr_t attr;
   barrier_t barrier;
-  struct timeval start, end;
-  struct timespec timeout;
   int nb_threads = DEFAULT_NUM_THREADS;
   int duration = DEFAULT_DURATION;
   int nb_accounts = DEFAULT_NB_ACCOUNTS;
@@ -305,7 +263,6 @@ main(int argc, char **argv)
   int seed = DEFAULT_SEED;
   int withdraw_perc = DEFAULT_WITHDRAW_PERC;
 
-  sigset_t block_set;
 
   while(1) 
     {
@@ -396,10 +353,8 @@ main(int argc, char **argv)
   withdraw_perc += deposit_perc;
   balance_perc += withdraw_perc;
 
-  timeout.tv_sec = duration / 1000;
-  timeout.tv_nsec = (duration % 1000) * 1000000;
 
-  if ((data = (thread_data_t *)malloc(nb_threads * sizeof(thread_data_t))) == NULL) {
+  if ((data = (thread_data_t *)bench_alloc_slots(nb_threads, sizeof(thread_data_t))) == NULL) {
     perror("malloc");
     exit(1);
   }
@@ -421,7 +376,7 @@ main(int argc, char **argv)
     bank->accounts[i].balance = 0;
   }
 
-  gl.lock_data = 0;
+  global_lock_init(&gl);
 
   local_th_data = (local_data *)malloc(nb_threads*sizeof(local_data));
 
@@ -432,8 +387,6 @@ main(int argc, char **argv)
 
   /* Access set from all threads */
   barrier_init(&barrier, nb_threads + 1);
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
   for (i = 0; i < nb_threads; i++) {
     printf("Creating thread %d\n", i);
     data[i].id = i;
@@ -448,46 +401,22 @@ main(int argc, char **argv)
     data[i].seed = rand();
     data[i].bank = bank;
     data[i].barrier = &barrier;
-    if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-      fprintf(stderr, "Error creating thread\n");
-      exit(1);
-    }
+    bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
   }
-  pthread_attr_destroy(&attr);
 
   /* Catch some signals */
-  if (signal(SIGHUP, catcher) == SIG_ERR ||
-      signal(SIGINT, catcher) == SIG_ERR ||
-      signal(SIGTERM, catcher) == SIG_ERR) {
-    perror("signal");
-    exit(1);
-  }
+  bench_catch_signals();
 
 
   /* Start threads */
-  barrier_cross(&barrier);
-
   printf("STARTING...\n");
-  gettimeofday(&start, NULL);
-  if (duration > 0) {
-    nanosleep(&timeout, NULL);
-  } else {
-    sigemptyset(&block_set);
-    sigsuspend(&block_set);
-  }
+  duration = bench_run(&barrier, duration);
   stop = 1;
-  gettimeofday(&end, NULL);
   printf("STOPPING...\n");
 
   /* Wait for thread completion */
-  for (i = 0; i < nb_threads; i++) {
-    if (pthread_join(threads[i], NULL) != 0) {
-      fprintf(stderr, "Error waiting for thread completion\n");
-      exit(1);
-    }
-  }
+  bench_join_threads(threads, nb_threads);
 
-  duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
   reads = 0;
   writes = 0;
   updates = 0;
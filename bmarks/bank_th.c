@@ -15,6 +15,7 @@
 #include "gl_lock.h"
 #include "atomic_ops.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 
 #ifdef DEBUG
@@ -40,6 +41,8 @@
 #define DEFAULT_READ_THREADS            0
 #define DEFAULT_WRITE_THREADS           0
 #define DEFAULT_DISJOINT                0
+#define DEFAULT_LOCK_SETS               0
+#define DEFAULT_SNAPSHOT                0
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -58,6 +61,12 @@ __thread uint32_t cluster_id;
 volatile global_data the_locks;
 __attribute__((aligned(CACHE_LINE_SIZE))) volatile local_data * local_th_data;
 
+//every operation takes the locks of its accounts as a lock set (lock_set.h), in increasing
+//order, and the read-all and write-all transactions no longer use the global lock
+int lock_sets;
+//accounts read by a read-all transaction (0 = all)
+int snapshot;
+
 /* ################################################################### *
  * BANK ACCOUNTS
  * ################################################################### */
@@ -80,6 +89,16 @@ typedef struct bank {
 int read_accounts(volatile account_t *a1, volatile account_t *a2,  int thread_id)
 {
     int amount=0;
+    if (lock_sets) {
+        lock_set_t set;
+        lock_set_init(&set);
+        lock_set_add(&set, a1->number);
+        lock_set_add(&set, a2->number);
+        lock_set_acquire_read(&set, local_th_data[thread_id], the_locks);
+        amount = a1->balance + a2->balance;
+        lock_set_release_read(&set, local_th_data[thread_id], the_locks);
+        return amount;
+    }
     //lock ordering
     int n1=a1->number;
     int n2=a2->number;
@@ -108,6 +127,17 @@ int read_accounts(volatile account_t *a1, volatile account_t *a2,  int thread_id
 int transfer(volatile account_t *src, volatile account_t *dst, int amount, int thread_id)
 {
     /* Allow overdrafts */
+    if (lock_sets) {
+        lock_set_t set;
+        lock_set_init(&set);
+        lock_set_add(&set, src->number);
+        lock_set_add(&set, dst->number);
+        lock_set_acquire(&set, local_th_data[thread_id], the_locks);
+        src->balance-=amount;
+        dst->balance+=amount;
+        lock_set_release(&set, local_th_data[thread_id], the_locks);
+        return amount;
+    }
     //lock ordering
     int n1=src->number;
     int n2=dst->number;
@@ -147,9 +177,44 @@ int total(bank_t *bank, int transactional)
     return total;
 }
 
-void reset(bank_t *bank)
+//sum of the accounts first to first + count - 1
+int snapshot_accounts(bank_t *bank, int first, int count, int thread_id)
+{
+    int i, total;
+    lock_set_t set;
+    if (lock_sets) {
+        lock_set_init(&set);
+        lock_set_add_range(&set, first, count);
+        lock_set_acquire_read(&set, local_th_data[thread_id], the_locks);
+    } else if (use_locks!=0) {
+        global_acquire_read(&gl);
+    }
+    total = 0;
+    for (i = first; i < first + count; i++) {
+        total += bank->accounts[i].balance;
+    }
+    if (lock_sets) {
+        lock_set_release_read(&set, local_th_data[thread_id], the_locks);
+    } else if (use_locks!=0) {
+        global_unlock_read(&gl);
+    }
+    return total;
+}
+
+void reset(bank_t *bank, int thread_id)
 {
     int i;
+    lock_set_t set;
+    if (lock_sets) {
+        lock_set_init(&set);
+        lock_set_add_range(&set, 0, bank->size);
+        lock_set_acquire(&set, local_th_data[thread_id], the_locks);
+        for (i = 0; i < bank->size; i++) {
+            bank->accounts[i].balance = 0;
+        }
+        lock_set_release(&set, local_th_data[thread_id], the_locks);
+        return;
+    }
     if (use_locks!=0) {
         global_acquire_write(&gl);
     }
@@ -165,37 +230,6 @@ void reset(bank_t *bank)
  * BARRIER
  * ################################################################### */
 
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 /* ################################################################### *
  * STRESS TEST
  * ################################################################### */
@@ -221,7 +255,7 @@ typedef struct thread_data {
     };
     uint8_t padding[2 * CACHE_LINE_SIZE];
   };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test(void *data)
 {
@@ -262,6 +296,7 @@ void *test(void *data)
 
     /* local initialization of locks */
     local_th_data[d->id] = init_lock_array_local(phys_id, d->bank->size, the_locks);
+    int snapshot_size = (snapshot > 0 && snapshot < d->bank->size) ? snapshot : d->bank->size;
 
     /* Wait on barrier */
     barrier_cross(d->barrier);
@@ -273,11 +308,11 @@ void *test(void *data)
     while (stop[0] == 0) {
         if (d->id < d->read_threads) {
             /* Read all */
-            total(d->bank, 1);
+            snapshot_accounts(d->bank, (int) (my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) % (d->bank->size - snapshot_size + 1)), snapshot_size, d->id);
             d->nb_read_all++;
         } else if (d->id < d->read_threads + d->write_threads) {
             /* Write all */
-            reset(d->bank);
+            reset(d->bank, d->id);
             d->nb_write_all++;
         } else {
             //nb = (int)(erand48(seed) * 100);
@@ -299,7 +334,7 @@ void *test(void *data)
 
             } else if (nb < read_write_thresh) {
                 /* Write all */
-                reset(d->bank);
+                reset(d->bank, d->id);
                 d->nb_write_all++;
             } else {
                 /* Choose random accounts */
@@ -320,14 +355,6 @@ void *test(void *data)
     return NULL;
 }
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
 
 int main(int argc, char **argv)
 {
@@ -346,6 +373,8 @@ int main(int argc, char **argv)
         {"write-all-rate",            required_argument, NULL, 'w'},
         {"write-threads",             required_argument, NULL, 'W'},
         {"disjoint",                  no_argument,       NULL, 'j'},
+        {"lock-sets",                 no_argument,       NULL, 'S'},
+        {"snapshot",                  required_argument, NULL, 'g'},
         {NULL, 0, NULL, 0}
     };
 
@@ -354,10 +383,7 @@ int main(int argc, char **argv)
     unsigned long reads, writes, updates;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     int duration = DEFAULT_DURATION;
     int nb_accounts = DEFAULT_NB_ACCOUNTS;
     int nb_threads = DEFAULT_NB_THREADS;
@@ -368,13 +394,12 @@ int main(int argc, char **argv)
     int write_all = DEFAULT_WRITE_ALL;
     int write_threads = DEFAULT_WRITE_THREADS;
     int disjoint = DEFAULT_DISJOINT;
-
-
-    sigset_t block_set;
+    lock_sets = DEFAULT_LOCK_SETS;
+    snapshot = DEFAULT_SNAPSHOT;
 
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "ha:c:d:n:r:R:s:l:w:W:j", long_options, &i);
+        c = getopt_long(argc, argv, "ha:c:d:n:r:R:s:l:w:W:jSg:", long_options, &i);
 
         if(c == -1)
             break;
@@ -413,6 +438,10 @@ int main(int argc, char **argv)
                         "        Percentage of write-all transactions (default=" XSTR(DEFAULT_WRITE_ALL) ")\n"
                         "  -W, --write-threads <int>\n"
                         "        Number of threads issuing only write-all transactions (default=" XSTR(DEFAULT_WRITE_THREADS) ")\n"
+                        "  -S, --lock-sets\n"
+                        "        Every transaction takes the locks of its accounts as a lock set (lock_set.h), without the global lock\n"
+                        "  -g, --snapshot <int>\n"
+                        "        Number of consecutive accounts read by a read-all transaction (0=all, default=" XSTR(DEFAULT_SNAPSHOT) ")\n"
                         );
                 exit(0);
             case 'a':
@@ -445,6 +474,12 @@ int main(int argc, char **argv)
             case 'j':
                 disjoint = 1;
                 break;
+            case 'S':
+                lock_sets = 1;
+                break;
+            case 'g':
+                snapshot = atoi(optarg);
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -470,15 +505,15 @@ int main(int argc, char **argv)
     printf("Use locks      : %d\n", use_locks);
     printf("Write-all rate : %d\n", write_all);
     printf("Write threads  : %d\n", write_threads);
+    printf("Lock sets      : %d\n", lock_sets);
+    printf("Snapshot       : %d\n", snapshot);
     printf("Type sizes     : int=%d/long=%d/ptr=%d\n",
             (int)sizeof(int),
             (int)sizeof(long),
             (int)sizeof(void *));
 //#endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(nb_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(nb_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -500,7 +535,7 @@ int main(int argc, char **argv)
         bank->accounts[i].balance = 0;
     }
 
-    gl.lock_data = 0;
+    global_lock_init(&gl);
 
     local_th_data = (local_data *)malloc(nb_threads*sizeof(local_data));
 
@@ -514,8 +549,6 @@ int main(int argc, char **argv)
 
     /* Access set from all threads */
     barrier_init(&barrier, nb_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < nb_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -533,49 +566,26 @@ int main(int argc, char **argv)
         data[i].seed = rand();
         data[i].bank = bank;
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
 
     /* Start threads */
-    barrier_cross(&barrier);
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
-#endif    
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+#endif
+    duration = bench_run(&barrier, duration);
     stop[0] = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif    
 
     /* Wait for thread completion */
-    for (i = 0; i < nb_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, nb_threads);
 
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
     reads = 0;
     writes = 0;
     updates = 0;
@@ -14,6 +14,7 @@
 #include "gl_lock.h"
 #include "atomic_ops.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 
 #define XSTR(s) #s
@@ -54,37 +55,6 @@ int acq_duration;
 int acq_delay;
 
 ticks correction;
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 typedef struct thread_data {
     barrier_t *barrier;
     unsigned long num_acquires;
@@ -92,7 +62,7 @@ typedef struct thread_data {
     ticks release_time;
     int id;
     char padding[CACHE_LINE_SIZE];
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test(void *data)
 {
@@ -147,16 +117,6 @@ void *test(void *data)
 }
 
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
-
-
 int main(int argc, char **argv)
 {
     set_cpu(the_cores[0]);
@@ -176,10 +136,7 @@ int main(int argc, char **argv)
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     duration = DEFAULT_DURATION;
     num_locks = DEFAULT_NUM_LOCKS;
     num_threads = DEFAULT_NUM_THREADS;
@@ -189,7 +146,6 @@ int main(int argc, char **argv)
     head=1;
     tail=0;
 
-    sigset_t block_set;
 
     while(1) {
         i = 0;
@@ -267,10 +223,8 @@ int main(int argc, char **argv)
             (int)sizeof(long),
             (int)sizeof(void *));
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -290,8 +244,6 @@ int main(int argc, char **argv)
 
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -301,52 +253,28 @@ int main(int argc, char **argv)
         data[i].acquire_time = 0;
         data[i].release_time = 0;
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
-    barrier_cross(&barrier);
-
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+    duration = bench_run(&barrier, duration);
     stop = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
 
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
 #ifdef PRINT_OUTPUT
     fprintf(stderr, "%d %d %d %d\n",some_data[0].the_data[1],some_data[1].the_data[2],some_data[2].the_data[3],some_data[3].the_data[4]);
 #endif
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
     unsigned long acquires = 0;
     ticks total_acquire = 0;
@@ -2,8 +2,8 @@
  * File: measure_contention.c
  * Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
  *
- * Description: measures the avg queuing per lock acquisition
- * using ticket locks
+ * Description: measures the avg queuing per lock acquisition,
+ * and the other lock statistics of lock_stats.h, for any lock
  */
 
 #include <assert.h>
@@ -20,11 +20,10 @@
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 #include "atomic_ops.h"
 
-#include "ticket.h"
-
 uint64_t c[2] = {0, 0};
 
 #define STR(s)   #s
@@ -50,6 +49,8 @@ uint64_t c[2] = {0, 0};
 #define DEFAULT_DO_WRITES 0
 //default seed
 #define DEFAULT_SEED 0
+//number of locks printed in the most contended list
+#define DEFAULT_HOT_LOCKS 5
 
 static volatile int stop;
 
@@ -78,38 +79,6 @@ int cl_access;
 int seed;
 
 
-typedef struct barrier 
-{
-  pthread_cond_t complete;
-  pthread_mutex_t mutex;
-  int count;
-  int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-  pthread_cond_init(&b->complete, NULL);
-  pthread_mutex_init(&b->mutex, NULL);
-  b->count = n;
-  b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-  pthread_mutex_lock(&b->mutex);
-  /* One more thread through */
-  b->crossing++;
-  /* If not all here, wait */
-  if (b->crossing < b->count) {
-    pthread_cond_wait(&b->complete, &b->mutex);
-  } else {
-    pthread_cond_broadcast(&b->complete);
-    /* Reset for next time */
-    b->crossing = 0;
-  }
-  pthread_mutex_unlock(&b->mutex);
-}
-
 typedef struct thread_data 
 {
   union
@@ -123,7 +92,7 @@ typedef struct thread_data
     };
     char padding[CACHE_LINE_SIZE];
   };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 
 double* avg_q_stats;
@@ -191,23 +160,14 @@ test(void *data)
     }
 
 
-  ticket_print_contention_stats();
-  avg_q_stats[d->id] = ticket_avg_queue();
+  lock_stats_print_thread();
+  avg_q_stats[d->id] = lock_stats_avg_queue(lock_stats_mine);
 
   free_lock_array_local(local_th_data[d->id], num_locks);
   return NULL;
 }
 
 
-void catcher(int sig)
-{
-  static int nb = 0;
-  printf("CAUGHT SIGNAL %d\n", sig);
-  if (++nb >= 3)
-    exit(1);
-}
-
-
 int main(int argc, char **argv)
 {
   set_cpu(the_cores[0]);
@@ -229,10 +189,7 @@ int main(int argc, char **argv)
   int i, c;
   thread_data_t *data;
   pthread_t *threads;
-  pthread_attr_t attr;
   barrier_t barrier;
-  struct timeval start, end;
-  struct timespec timeout;
   duration = DEFAULT_DURATION;
   num_locks = DEFAULT_NUM_LOCKS;
   do_writes = DEFAULT_DO_WRITES;
@@ -242,7 +199,6 @@ int main(int argc, char **argv)
   cl_access = DEFAULT_CL_ACCESS;
   seed = DEFAULT_SEED;
 
-  sigset_t block_set;
 
   while(1) 
     {
@@ -362,10 +318,8 @@ int main(int argc, char **argv)
   printf("Cache lines accessed   : %d\n", cl_access);
   printf("Do writes              : %d\n", do_writes);
 #endif
-  timeout.tv_sec = duration / 1000;
-  timeout.tv_nsec = (duration % 1000) * 1000000;
 
-  if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+  if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
     perror("malloc");
     exit(1);
   }
@@ -387,55 +341,24 @@ int main(int argc, char **argv)
 
   /* Access set from all threads */
   barrier_init(&barrier, num_threads + 1);
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
   for (i = 0; i < num_threads; i++) 
     {
       data[i].id = i;
       data[i].num_acquires = 0;
       data[i].seed = rand();
       data[i].barrier = &barrier;
-      if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) 
-	{
-	  fprintf(stderr, "Error creating thread\n");
-	  exit(1);
-	}
+      bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
     }
-  pthread_attr_destroy(&attr);
 
   /* Catch some signals */
-  if (signal(SIGHUP, catcher) == SIG_ERR ||
-      signal(SIGINT, catcher) == SIG_ERR ||
-      signal(SIGTERM, catcher) == SIG_ERR) 
-    {
-      perror("signal");
-      exit(1);
-    }
+  bench_catch_signals();
 
   /* Start threads */
-  barrier_cross(&barrier);
-  gettimeofday(&start, NULL);
-  if (duration > 0) 
-    {
-      nanosleep(&timeout, NULL);
-    } else 
-    {
-      sigemptyset(&block_set);
-      sigsuspend(&block_set);
-    }
+  duration = bench_run(&barrier, duration);
   stop = 1;
-  gettimeofday(&end, NULL);
   /* Wait for thread completion */
-  for (i = 0; i < num_threads; i++) 
-    {
-      if (pthread_join(threads[i], NULL) != 0) 
-	{
-	  fprintf(stderr, "Error waiting for thread completion\n");
-	  exit(1);
-	}
-    }
+  bench_join_threads(threads, num_threads);
 
-  duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
   double avg_q = 0;
   unsigned long acquires = 0;
@@ -460,6 +383,10 @@ int main(int argc, char **argv)
   printf("Duration      : %d (ms)\n", duration);
 #endif
   printf("#acquires     : %lu ( %lu / s)\n", acquires, (unsigned long )(acquires * 1000.0 / duration));
+  printf("All threads:\n  ");
+  lock_stats_print();
+  printf("Most contended locks:\n");
+  lock_stats_print_hot(DEFAULT_HOT_LOCKS);
     
   /* Cleanup locks */
   free_lock_array_global(the_locks, num_locks);
@@ -0,0 +1,45 @@
+/*
+ * File: print_topology.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description: 
+ *      Prints the topology detected at startup
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "utils.h"
+#include "hmcs.h"
+
+int main(int argc, char **argv) {
+#ifdef DEFAULT
+    topology_print(stdout);
+#endif
+    printf("Sockets: %d, cores per socket: %d\n", (int) NUMBER_OF_SOCKETS, (int) CORES_PER_SOCKET);
+    int i;
+    printf("%5s %8s %8s\n", "core", "cluster", "node");
+    for (i = 0; i < NUMBER_OF_SOCKETS * CORES_PER_SOCKET; i++) {
+        printf("%5d %8d %8d\n", the_cores[i], get_cluster(the_cores[i]), get_numa_node(the_cores[i]));
+    }
+    hmcs_levels_print(stdout);
+    return 0;
+}
@@ -0,0 +1,359 @@
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#ifndef __sparc__
+#include <numa.h>
+#endif
+#include "atomic_ops.h"
+#include "utils.h"
+#include "bench.h"
+#include "lock_if.h"
+#include "rw_ttas.h"
+#include "seqlock.h"
+
+#define STR(s) #s
+#define XSTR(s) STR(s)
+
+//number of concurrent readers
+#define DEFAULT_NUM_THREADS 1
+//how the readers access the data
+#define DEFAULT_MODE 0
+//delay between two updates of the writer in cycles; 0 means no writer
+#define DEFAULT_WRITE_DELAY 0
+//the total duration of a test
+#define DEFAULT_DURATION 10000
+
+#define NUM_HW_CONTEXTS (NUMBER_OF_SOCKETS * CORES_PER_SOCKET)
+
+//read modes
+#define MODE_SEQLOCK 0 //seqlock_read_begin/seqlock_read_retry; the writer uses acquire_seq_write
+#define MODE_RW_TTAS 1 //read_acquire of rw_ttas
+#define MODE_LOCK_IF 2 //acquire_read of the lock given by LOCK_VERSION
+
+static const char* mode_names[] = {"seqlock", "rw_ttas", "acquire_read"};
+
+//number of words of the data read; the writer stores the same value in all of them
+#define DATA_WORDS 8
+
+static volatile int stop;
+
+__thread uint32_t phys_id;
+
+typedef struct shared_config {
+    volatile uint64_t words[DATA_WORDS];
+} shared_config;
+
+__attribute__((aligned(CACHE_LINE_SIZE))) shared_config config;
+__attribute__((aligned(CACHE_LINE_SIZE))) seqlock_t config_seq;
+__attribute__((aligned(CACHE_LINE_SIZE))) rw_ttas config_rw;
+lock_global_data config_lock;
+
+int duration;
+int num_threads;
+int mode;
+int write_delay;
+
+typedef struct thread_data {
+    barrier_t *barrier;
+    unsigned long num_ops;
+    unsigned long num_retries;
+    unsigned long num_inconsistent;
+    ticks total_time;
+    int id;
+    char padding[CACHE_LINE_SIZE];
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
+
+//copies the data and returns 1 if the copy is inconsistent
+static inline int copy_config(shared_config* copy) {
+    int i;
+    for (i = 0; i < DATA_WORDS; i++) {
+        copy->words[i] = config.words[i];
+    }
+    for (i = 1; i < DATA_WORDS; i++) {
+        if (copy->words[i] != copy->words[0]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void *test_reader(void *data)
+{
+    thread_data_t *d = (thread_data_t *)data;
+    lock_local_data local_d;
+    uint32_t limit;
+    shared_config copy;
+    uint32_t seq;
+    int inconsistent;
+
+    phys_id = the_cores[d->id % NUM_HW_CONTEXTS];
+    if (mode == MODE_RW_TTAS) {
+        init_rw_ttas_local(phys_id, &limit);
+    } else {
+        init_lock_local(phys_id, &config_lock, &local_d);
+    }
+
+    barrier_cross(d->barrier);
+
+    ticks begin = getticks();
+    while (stop == 0) {
+        switch (mode) {
+            case MODE_SEQLOCK:
+                //the copy may be inconsistent until read_retry returns 0
+                seq = seqlock_read_begin(&config_seq);
+                inconsistent = copy_config(&copy);
+                while (seqlock_read_retry(&config_seq, seq)) {
+                    d->num_retries++;
+                    seq = seqlock_read_begin(&config_seq);
+                    inconsistent = copy_config(&copy);
+                }
+                d->num_inconsistent += inconsistent;
+                break;
+            case MODE_RW_TTAS:
+                read_acquire(&config_rw, &limit);
+                d->num_inconsistent += copy_config(&copy);
+                read_release(&config_rw);
+                break;
+            default:
+                acquire_read(&local_d, &config_lock);
+                d->num_inconsistent += copy_config(&copy);
+                release_read(&local_d, &config_lock);
+                break;
+        }
+        d->num_ops++;
+    }
+    d->total_time = getticks() - begin;
+
+    if (mode != MODE_RW_TTAS) {
+        free_lock_local(local_d);
+    }
+    return NULL;
+}
+
+void *test_writer(void *data)
+{
+    thread_data_t *d = (thread_data_t *)data;
+    lock_local_data local_d;
+    uint32_t limit;
+    int i;
+
+    phys_id = the_cores[d->id % NUM_HW_CONTEXTS];
+    if (mode == MODE_RW_TTAS) {
+        init_rw_ttas_local(phys_id, &limit);
+    } else {
+        init_lock_local(phys_id, &config_lock, &local_d);
+    }
+
+    barrier_cross(d->barrier);
+
+    uint64_t version = 0;
+    while (stop == 0) {
+        version++;
+        switch (mode) {
+            case MODE_SEQLOCK:
+                acquire_seq_write(&local_d, &config_lock, &config_seq);
+                for (i = 0; i < DATA_WORDS; i++) {
+                    config.words[i] = version;
+                }
+                release_seq_write(&local_d, &config_lock, &config_seq);
+                break;
+            case MODE_RW_TTAS:
+                write_acquire(&config_rw, &limit);
+                for (i = 0; i < DATA_WORDS; i++) {
+                    config.words[i] = version;
+                }
+                write_release(&config_rw);
+                break;
+            default:
+                acquire_write(&local_d, &config_lock);
+                for (i = 0; i < DATA_WORDS; i++) {
+                    config.words[i] = version;
+                }
+                release_write(&local_d, &config_lock);
+                break;
+        }
+        d->num_ops++;
+        cpause(write_delay);
+    }
+
+    if (mode != MODE_RW_TTAS) {
+        free_lock_local(local_d);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    set_cpu(the_cores[0]);
+    struct option long_options[] = {
+        // These options don't set a flag
+        {"help",                      no_argument,       NULL, 'h'},
+        {"duration",                  required_argument, NULL, 'd'},
+        {"num-threads",               required_argument, NULL, 'n'},
+        {"mode",                      required_argument, NULL, 'm'},
+        {"write-delay",               required_argument, NULL, 'w'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int i, c;
+    thread_data_t *data;
+    pthread_t *threads;
+    barrier_t barrier;
+    duration = DEFAULT_DURATION;
+    num_threads = DEFAULT_NUM_THREADS;
+    mode = DEFAULT_MODE;
+    write_delay = DEFAULT_WRITE_DELAY;
+
+
+    while(1) {
+        i = 0;
+        c = getopt_long(argc, argv, "hd:n:m:w:", long_options, &i);
+
+        if(c == -1)
+            break;
+
+        if(c == 0 && long_options[i].flag == 0)
+            c = long_options[i].val;
+
+        switch(c) {
+            case 0:
+                /* Flag is automatically set */
+                break;
+            case 'h':
+                printf("reader throughput test\n"
+                        "\n"
+                        "Usage:\n"
+                        "  read_ops [options...]\n"
+                        "\n"
+                        "Options:\n"
+                        "  -h, --help\n"
+                        "        Print this message\n"
+                        "  -d, --duration <int>\n"
+                        "        Test duration in milliseconds (0=infinite, default=" XSTR(DEFAULT_DURATION) ")\n"
+                        "  -n, --num-threads <int>\n"
+                        "        Number of reader threads (default=" XSTR(DEFAULT_NUM_THREADS) ")\n"
+                        "  -m, --mode <int>\n"
+                        "        0: seqlock, 1: rw_ttas, 2: acquire_read of the lock in lock_if.h (default=" XSTR(DEFAULT_MODE) ")\n"
+                        "  -w, --write-delay <int>\n"
+                        "        Cycles between two updates of a writer thread; 0 means no writer (default=" XSTR(DEFAULT_WRITE_DELAY) ")\n"
+                      );
+                exit(0);
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'n':
+                num_threads = atoi(optarg);
+                break;
+            case 'm':
+                mode = atoi(optarg);
+                break;
+            case 'w':
+                write_delay = atoi(optarg);
+                break;
+            case '?':
+                printf("Use -h or --help for help\n");
+                exit(0);
+            default:
+                exit(1);
+        }
+    }
+
+    assert(duration >= 0);
+    assert(num_threads > 0);
+    assert(mode >= MODE_SEQLOCK && mode <= MODE_LOCK_IF);
+    assert(write_delay >= 0);
+    int num_writers = (write_delay > 0) ? 1 : 0;
+    write_delay = write_delay / NOP_DURATION;
+
+#ifdef PRINT_OUTPUT
+    printf("Mode               : %s\n", mode_names[mode]);
+    printf("Duration           : %d\n", duration);
+    printf("Number of readers  : %d\n", num_threads);
+    printf("Number of writers  : %d\n", num_writers);
+#endif
+
+    if ((data = (thread_data_t *)bench_alloc_slots((num_threads + num_writers), sizeof(thread_data_t))) == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    if ((threads = (pthread_t *)malloc((num_threads + num_writers) * sizeof(pthread_t))) == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+
+    stop = 0;
+    /* Init locks */
+    seqlock_init(&config_seq);
+    init_rw_ttas_global(&config_rw);
+    init_lock_global(&config_lock);
+    for (i = 0; i < DATA_WORDS; i++) {
+        config.words[i] = 0;
+    }
+
+    /* the writer is the last thread */
+    barrier_init(&barrier, num_threads + num_writers + 1);
+    for (i = 0; i < num_threads + num_writers; i++) {
+        data[i].id = i;
+        data[i].num_ops = 0;
+        data[i].num_retries = 0;
+        data[i].num_inconsistent = 0;
+        data[i].total_time = 0;
+        data[i].barrier = &barrier;
+        bench_start_thread(&threads[i], bench_core(i), (i < num_threads) ? test_reader : test_writer, (void *)(&data[i]));
+    }
+
+    /* Catch some signals */
+    bench_catch_signals();
+
+    /* Start threads */
+    duration = bench_run(&barrier, duration);
+    stop = 1;
+
+    /* Wait for thread completion */
+    bench_join_threads(threads, num_threads + num_writers);
+
+
+    unsigned long reads = 0;
+    unsigned long retries = 0;
+    unsigned long inconsistent = 0;
+    ticks total_time = 0;
+    for (i = 0; i < num_threads; i++) {
+#ifdef PRINT_OUTPUT
+        printf("Thread %d\n", i);
+        printf("  #reads     : %lu\n", data[i].num_ops);
+        printf("  #retries   : %lu\n", data[i].num_retries);
+#endif
+        reads += data[i].num_ops;
+        retries += data[i].num_retries;
+        inconsistent += data[i].num_inconsistent;
+        total_time += data[i].total_time;
+    }
+    if (reads == 0) {
+        reads = 1;
+    }
+
+#ifdef PRINT_OUTPUT
+    printf("Duration      : %d (ms)\n", duration);
+    printf("#reads        : %lu (%f / s)\n", reads, reads * 1000.0 / duration);
+    printf("#retries      : %lu\n", retries);
+    printf("#writes       : %lu\n", num_writers ? data[num_threads].num_ops : 0);
+    printf("Average read duration: %lu (cycles)\n", (unsigned long) (total_time / reads));
+#endif
+    if (inconsistent > 0) {
+        printf("Inconsistent reads: %lu\n", inconsistent);
+    }
+    //threads, mode, reads per second, cycles per read
+    printf("%d %s %.0f %lu\n", num_threads, mode_names[mode], reads * 1000.0 / duration, (unsigned long) (total_time / reads));
+
+    free_lock_global(config_lock);
+    free(threads);
+    free(data);
+
+    return (inconsistent > 0);
+}
@@ -8,16 +8,22 @@
 #include <stdio.h>
 #include <sys/time.h>
 #include <time.h>
+#include <math.h>
 #ifndef __sparc__
 #include <numa.h>
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 #include "atomic_ops.h"
 
 #define DETAILED_LATENCIES
 
+#if defined(DETAILED_LATENCIES)
+#include "latency_hist.h"
+#endif
+
 #define STR(s) #s
 #define XSTR(s) STR(s)
 
@@ -37,6 +43,10 @@
 #define DEFAULT_DURATION 10000
 //if DO_WRITES is set to 1, the threads will do writes on the shared cache lines
 #define DEFAULT_DO_WRITES 0
+//if rate is k > 0, requests arrive at every thread as a Poisson process of k requests/s (open loop)
+#define DEFAULT_RATE 0
+//arrival gaps precomputed by every thread in the open loop; the schedule repeats after them
+#define OPEN_LOOP_SCHEDULE (1 << 16)
 
 static volatile int stop;
 __thread unsigned long * seeds;
@@ -62,43 +72,15 @@ int acq_duration;
 int acq_delay;
 int cl_access;
 int do_writes;
+int rate;
+//mean gap between two arrivals at a thread in the open loop, in cycles
+double mean_gap;
 
 #if defined(MEASURE_CONTENTION) && defined(USE_TICKET_LOCKS)
 extern __thread uint64_t ticket_queued_total;
 extern __thread uint64_t ticket_acquires;
 #endif
 
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 typedef struct thread_data {
   union
   {
@@ -110,13 +92,28 @@ typedef struct thread_data {
 #if defined(DETAILED_LATENCIES)
       ticks acq_time;
       ticks rls_time;
+      //allocated by the thread
+      lat_hist_t* acq_hist;
+      lat_hist_t* rls_hist;
+      lat_hist_t* hold_hist;
+      //open loop: arrival to release, and requests that arrived while the thread was busy
+      lat_hist_t* resp_hist;
+      unsigned long queued;
 #endif
       ticks total_time;
 
     };
-    char padding[CACHE_LINE_SIZE];
+    char padding[2 * CACHE_LINE_SIZE];
   };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
+
+#if defined(DETAILED_LATENCIES)
+//a measured interval without the cost of getticks; 0 if it was shorter than that
+static inline uint64_t sub_correction(ticks t)
+{
+    return (t > correction) ? t - correction : 0;
+}
+#endif
 
 void *test(void *data)
 {
@@ -130,6 +127,14 @@ void *test(void *data)
 
     /* local initialization of locks */
     local_th_data[d->id] = init_lock_array_local(phys_id, num_locks, the_locks);
+#if defined(DETAILED_LATENCIES)
+    d->acq_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    d->rls_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    d->hold_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    lat_hist_init(d->acq_hist);
+    lat_hist_init(d->rls_hist);
+    lat_hist_init(d->hold_hist);
+#endif
 
     barrier_cross(d->barrier);
     int lock_to_acq;
@@ -221,6 +226,9 @@ void *test(void *data)
 #if defined(DETAILED_LATENCIES)
 	d->acq_time += t3 - t1 - correction;
 	d->rls_time += t2 - t4 - correction;
+	lat_hist_record(d->acq_hist, sub_correction(t3 - t1));
+	lat_hist_record(d->rls_hist, sub_correction(t2 - t4));
+	lat_hist_record(d->hold_hist, sub_correction(t4 - t3));
 #endif
         d->num_acquires++;
 #if defined(USE_MUTEX_LOCKS)
@@ -238,15 +246,118 @@ void *test(void *data)
     return NULL;
 }
 
-
-void catcher(int sig)
+#if defined(DETAILED_LATENCIES)
+//requests arrive on a precomputed Poisson schedule whether or not the thread
+//has served the previous ones; a request that arrives while the thread is
+//busy waits, and its response time includes that wait
+void *test_open_loop(void *data)
 {
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
+    thread_data_t *d = (thread_data_t *)data;
+    phys_id = the_cores[d->id];
+    cluster_id = get_cluster(phys_id);
+    seeds = seed_rand();
+    int rand_max = num_locks - 1;
+
+    /* local initialization of locks */
+    local_th_data[d->id] = init_lock_array_local(phys_id, num_locks, the_locks);
+    d->acq_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    d->rls_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    d->hold_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    d->resp_hist = (lat_hist_t*) memalign(CACHE_LINE_SIZE, sizeof(lat_hist_t));
+    lat_hist_init(d->acq_hist);
+    lat_hist_init(d->rls_hist);
+    lat_hist_init(d->hold_hist);
+    lat_hist_init(d->resp_hist);
+
+    //exponential gaps, drawn before the start so that the loop only reads them
+    ticks* gaps = (ticks*) malloc(OPEN_LOOP_SCHEDULE * sizeof(ticks));
+    uint32_t k;
+    for (k = 0; k < OPEN_LOOP_SCHEDULE; k++) {
+        double u = (my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & 0xffffffff) / 4294967296.0;
+        gaps[k] = (ticks) (-log(1.0 - u) * mean_gap);
+    }
+
+    barrier_cross(d->barrier);
+    int lock_to_acq;
+    ticks t1, t2, t3, t4;
+    local_data local_d = local_th_data[d->id];
+    ticks arrival = getticks();
+    k = 0;
+    while (stop == 0) {
+        arrival += gaps[k];
+        k = (k + 1) & (OPEN_LOOP_SCHEDULE - 1);
+        t1 = getticks();
+        if (t1 < arrival) {
+            //idle until the request arrives
+            while ((t1 = getticks()) < arrival && stop == 0) {
+                PAUSE;
+            }
+            if (stop) {
+                break;
+            }
+        } else {
+            d->queued++;
+        }
+        if (num_locks==1) {
+            lock_to_acq=0;
+        } else {
+            lock_to_acq=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & rand_max;
+        }
+
+        COMPILER_BARRIER;
+        acquire_lock(&local_d[lock_to_acq],&the_locks[lock_to_acq]);
+        COMPILER_BARRIER;
+        t3 = getticks();
+        COMPILER_BARRIER;
+        if (acq_duration > 0)
+        {
+            cpause(acq_duration);
+        }
+        uint32_t i;
+#ifndef NO_DELAYS
+        for (i = 0; i < cl_access; i++)
+        {
+            if (do_writes==1) {
+                protected_data[i + protected_offsets[lock_to_acq]].the_data[0]+=d->id;
+            } else {
+                protected_data[i + protected_offsets[lock_to_acq]].the_data[0]= d->id;
+            }
+        }
+#endif
+        MEM_BARRIER;
+        COMPILER_BARRIER;
+        t4 = getticks();
+        COMPILER_BARRIER;
+        release_lock(&local_d[lock_to_acq],&the_locks[lock_to_acq]);
+        MEM_BARRIER;
+        COMPILER_BARRIER;
+        t2 = getticks();
+        COMPILER_BARRIER;
+        d->total_time+=t2-t1-correction;
+        d->acq_time += t3 - t1 - correction;
+        d->rls_time += t2 - t4 - correction;
+        lat_hist_record(d->acq_hist, sub_correction(t3 - t1));
+        lat_hist_record(d->rls_hist, sub_correction(t2 - t4));
+        lat_hist_record(d->hold_hist, sub_correction(t4 - t3));
+        lat_hist_record(d->resp_hist, sub_correction(t2 - arrival));
+        d->num_acquires++;
+    }
+    free(gaps);
+    /* Free locks */
+    free_lock_array_local(local_th_data[d->id], num_locks);
+
+    return NULL;
 }
 
+//cycles of getticks in a second, measured over 100 ms
+static double ticks_per_second()
+{
+    struct timespec ts = { 0, 100 * 1000000 };
+    ticks start = getticks();
+    nanosleep(&ts, NULL);
+    return (getticks() - start) * 10.0;
+}
+#endif
 
 int main(int argc, char **argv)
 {
@@ -261,30 +372,27 @@ int main(int argc, char **argv)
         {"acquire",                   required_argument, NULL, 'a'},
         {"pause",                     required_argument, NULL, 'p'},
         {"clines",                    required_argument, NULL, 'c'},
+        {"rate",                      required_argument, NULL, 'r'},
         {NULL, 0, NULL, 0}
     };
     
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     duration = DEFAULT_DURATION;
     num_locks = DEFAULT_NUM_LOCKS;
     num_threads = DEFAULT_NUM_THREADS;
     acq_duration = DEFAULT_ACQ_DURATION;
     acq_delay = DEFAULT_ACQ_DELAY;
     cl_access = DEFAULT_CL_ACCESS;
+    rate = DEFAULT_RATE;
 
     correction = getticks_correction_calc();
 
-    sigset_t block_set;
-
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "hl:d:n:a:p:w:c:", long_options, &i);
+        c = getopt_long(argc, argv, "hl:d:n:a:p:w:c:r:", long_options, &i);
 
         if(c == -1)
             break;
@@ -319,6 +427,8 @@ int main(int argc, char **argv)
                         "        Number of cycles between a lock release and the next acquire (default=" XSTR(DEFAULT_ACQ_DELAY) ")\n"
                         "  -c, --clines <int>\n"
                         "        Number of cache lines written in every critical section (default=" XSTR(DEFAULT_CL_ACCESS) ")\n"
+                        "  -r, --rate <int>\n"
+                        "        Open loop: requests per second arriving at every thread as a Poisson process, -p is ignored (0=closed loop, default=" XSTR(DEFAULT_RATE) ")\n"
                         );
                 exit(0);
             case 'l':
@@ -352,6 +462,9 @@ int main(int argc, char **argv)
             case 'c':
                 cl_access = atoi(optarg);
                 break;
+            case 'r':
+                rate = atoi(optarg);
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -373,6 +486,17 @@ int main(int argc, char **argv)
     assert(acq_duration >= 0);
     assert(acq_delay >= 0);
     assert(cl_access >= 0);
+    assert(rate >= 0);
+#if defined(DETAILED_LATENCIES)
+    if (rate > 0) {
+        mean_gap = ticks_per_second() / rate;
+    }
+#else
+    if (rate > 0) {
+        fprintf(stderr, "The open loop needs DETAILED_LATENCIES\n");
+        exit(1);
+    }
+#endif
     if (cl_access > 0)
     {
         protected_data = (shared_data*) calloc(cl_access * num_locks, sizeof(shared_data));
@@ -395,10 +519,8 @@ int main(int argc, char **argv)
             (int)sizeof(long),
             (int)sizeof(void *));
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -418,8 +540,6 @@ int main(int argc, char **argv)
 
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -429,52 +549,34 @@ int main(int argc, char **argv)
 #if defined(DETAILED_LATENCIES)
 	data[i].acq_time = 0;
 	data[i].rls_time = 0;
+	data[i].queued = 0;
 #endif
         data[i].total_time = 0;
 
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+#if defined(DETAILED_LATENCIES)
+        bench_start_thread(&threads[i], bench_core(i), (rate > 0) ? test_open_loop : test, (void *)(&data[i]));
+#else
+        bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
+#endif
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
-    barrier_cross(&barrier);
-
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+    duration = bench_run(&barrier, duration);
     stop = 1;
-    gettimeofday(&end, NULL);
 
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
 
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
 #ifdef PRINT_OUTPUT
     for (i = 0; i < cl_access * num_threads; i++)
@@ -486,7 +588,6 @@ int main(int argc, char **argv)
         fprintf(stderr, "\n");
     }
 #endif
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
 #if defined(DETAILED_LATENCIES)
     ticks acq_time = 0;
@@ -514,6 +615,44 @@ int main(int argc, char **argv)
 #endif
 
 #if defined(DETAILED_LATENCIES)
+    lat_hist_t* acq_hist = (lat_hist_t*) malloc(sizeof(lat_hist_t));
+    lat_hist_t* rls_hist = (lat_hist_t*) malloc(sizeof(lat_hist_t));
+    lat_hist_t* hold_hist = (lat_hist_t*) malloc(sizeof(lat_hist_t));
+    lat_hist_init(acq_hist);
+    lat_hist_init(rls_hist);
+    lat_hist_init(hold_hist);
+    for (i = 0; i < num_threads; i++) {
+        lat_hist_merge(acq_hist, data[i].acq_hist);
+        lat_hist_merge(rls_hist, data[i].rls_hist);
+        lat_hist_merge(hold_hist, data[i].hold_hist);
+        free(data[i].acq_hist);
+        free(data[i].rls_hist);
+        free(data[i].hold_hist);
+    }
+    //percentiles in cycles; the summary line below stays last for the scripts
+    lat_hist_print("acquire", acq_hist);
+    lat_hist_print("release", rls_hist);
+    lat_hist_print("hold", hold_hist);
+    free(acq_hist);
+    free(rls_hist);
+    free(hold_hist);
+    if (rate > 0) {
+        //past the knee the completed load falls behind the offered one and the response times grow with the duration
+        lat_hist_t* resp_hist = (lat_hist_t*) malloc(sizeof(lat_hist_t));
+        lat_hist_init(resp_hist);
+        unsigned long queued = 0;
+        for (i = 0; i < num_threads; i++) {
+            lat_hist_merge(resp_hist, data[i].resp_hist);
+            free(data[i].resp_hist);
+            queued += data[i].queued;
+        }
+        lat_hist_print("response", resp_hist);
+        printf("open loop: offered %llu req/s, completed %.0f req/s, queued %.2f%%\n",
+                (unsigned long long) rate * num_threads, acquires * 1000.0 / duration,
+                acquires ? queued * 100.0 / acquires : 0.0);
+        free(resp_hist);
+    }
+
     printf("%d %-10lu %-10lu %-10lu %lu\n",
 	   num_threads, acq_time/acquires, rls_time/acquires, 
 	   (total_time - acq_time - rls_time - 2 * acquires * correction)/acquires,
@@ -13,6 +13,7 @@
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 #include "atomic_ops.h"
 
@@ -37,8 +38,19 @@ uint64_t c[2] = {0, 0};
 #define DEFAULT_DURATION 10000
 //if do_writes is 0, the test only reads cache lines, else it also writes them
 #define DEFAULT_DO_WRITES 0
+//if oversubscribe is k > 0, k threads run on every hardware context
+#define DEFAULT_OVERSUBSCRIBE 0
+//if phase is k > 0, the test alternates k ms of high and of low contention
+#define DEFAULT_PHASE 0
+//at most this many phases are reported separately
+#define MAX_PHASES 64
+
+//number of hardware contexts the threads are placed on
+#define NUM_HW_CONTEXTS (NUMBER_OF_SOCKETS * CORES_PER_SOCKET)
 
 static volatile int stop;
+//current phase: all threads use lock 0 in even phases, only threads 0 and 1 in odd ones
+static volatile int cur_phase;
 
 __thread unsigned long* seeds;
 __thread uint32_t phys_id;
@@ -61,37 +73,9 @@ int acq_delay;
 int fair_delay;
 int mutex_delay;
 int cl_access;
-
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
+int oversubscribe;
+int phase;
+int num_phases;
 
 typedef struct thread_data {
     union
@@ -100,17 +84,18 @@ typedef struct thread_data {
         {
             barrier_t *barrier;
             unsigned long num_acquires;
+            unsigned long* phase_acquires;
             int id;
         };
         char padding[CACHE_LINE_SIZE];
     };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test(void *data)
 {
     int rand_max;
     thread_data_t *d = (thread_data_t *)data;
-    phys_id = the_cores[d->id];
+    phys_id = the_cores[d->id % NUM_HW_CONTEXTS];
     cluster_id = get_cluster(phys_id);
     rand_max = num_locks - 1;
 
@@ -128,8 +113,17 @@ void *test(void *data)
     int lock_to_acq;
 
     local_data local_d = local_th_data[d->id];
+    int my_phase = 0;
     while (stop == 0) {
-        if (num_locks==1) {
+        if (phase > 0) {
+            my_phase = cur_phase;
+            //low contention: the other threads stay off the lock
+            if ((my_phase & 1) && d->id > 1) {
+                PAUSE;
+                continue;
+            }
+            lock_to_acq=0;
+        } else if (num_locks==1) {
             lock_to_acq=0;
         } else {
             lock_to_acq=(int) my_random(&(seeds[0]),&(seeds[1]),&(seeds[2])) & rand_max;
@@ -166,6 +160,9 @@ void *test(void *data)
             cpause(mutex_delay);
 #endif
         d->num_acquires++;
+        if (phase > 0) {
+            d->phase_acquires[my_phase]++;
+        }
     }
 
     free_lock_array_local(local_th_data[d->id], num_locks);
@@ -173,15 +170,6 @@ void *test(void *data)
 }
 
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
-
 int main(int argc, char **argv)
 {
     set_cpu(the_cores[0]);
@@ -195,16 +183,15 @@ int main(int argc, char **argv)
         {"pause",                     required_argument, NULL, 'p'},
         {"do_writes",                 required_argument, NULL, 'w'},
         {"clines",                    required_argument, NULL, 'c'},
+        {"oversubscribe",             required_argument, NULL, 'o'},
+        {"phase",                     required_argument, NULL, 'P'},
         {NULL, 0, NULL, 0}
     };
 
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     duration = DEFAULT_DURATION;
     num_locks = DEFAULT_NUM_LOCKS;
     do_writes = DEFAULT_DO_WRITES;
@@ -212,12 +199,13 @@ int main(int argc, char **argv)
     acq_duration = DEFAULT_ACQ_DURATION;
     acq_delay = DEFAULT_ACQ_DELAY;
     cl_access = DEFAULT_CL_ACCESS;
+    oversubscribe = DEFAULT_OVERSUBSCRIBE;
+    phase = DEFAULT_PHASE;
 
-    sigset_t block_set;
 
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "hl:d:n:w:a:p:c:", long_options, &i);
+        c = getopt_long(argc, argv, "hl:d:n:w:a:p:c:o:P:", long_options, &i);
 
         if(c == -1)
             break;
@@ -252,6 +240,10 @@ int main(int argc, char **argv)
                         "        Number of cycles between a lock release and the next acquire (default=" XSTR(DEFAULT_ACQ_DELAY) ")\n"
                         "  -c, --clines <int>\n"
                         "        Number of cache lines written in every critical section (default=" XSTR(DEFAULT_CL_ACCESS) ")\n"
+                        "  -o, --oversubscribe <int>\n"
+                        "        Run <int> threads on every hardware context; overrides -n (default=" XSTR(DEFAULT_OVERSUBSCRIBE) ")\n"
+                        "  -P, --phase <int>\n"
+                        "        Alternate <int> ms with all threads on lock 0 and <int> ms with only threads 0 and 1 on it (default=" XSTR(DEFAULT_PHASE) ")\n"
                         );
                 exit(0);
             case 'l':
@@ -285,6 +277,12 @@ int main(int argc, char **argv)
             case 'c':
                 cl_access = atoi(optarg);
                 break;
+            case 'o':
+                oversubscribe = atoi(optarg);
+                break;
+            case 'P':
+                phase = atoi(optarg);
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -292,6 +290,9 @@ int main(int argc, char **argv)
                 exit(1);
         }
     }
+    if (oversubscribe > 0) {
+        num_threads = oversubscribe * NUM_HW_CONTEXTS;
+    }
     fair_delay=100;
     mutex_delay=(num_threads-1) * 30 / NOP_DURATION;
     fair_delay=fair_delay/NOP_DURATION;
@@ -304,6 +305,14 @@ int main(int argc, char **argv)
     assert(acq_duration >= 0);
     assert(acq_delay >= 0);
     assert(cl_access >= 0);
+    assert(phase >= 0);
+    if (phase > 0) {
+        assert(duration > 0);
+        num_phases = (duration + phase - 1) / phase;
+        if (num_phases > MAX_PHASES) {
+            num_phases = MAX_PHASES;
+        }
+    }
 
     if (cl_access > 0)
     {
@@ -322,15 +331,15 @@ int main(int argc, char **argv)
     printf("Delay between locks    : %d\n", acq_delay);
     printf("Cache lines accessed   : %d\n", cl_access);
     printf("Do writes              : %d\n", do_writes);
+    printf("Threads per hw context : %d\n", oversubscribe);
+    printf("Phase length           : %d\n", phase);
     printf("Type sizes             : int=%d/long=%d/ptr=%d\n",
             (int)sizeof(int),
             (int)sizeof(long),
             (int)sizeof(void *));
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -350,54 +359,48 @@ int main(int argc, char **argv)
 
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
 #endif
         data[i].id = i;
         data[i].num_acquires = 0;
-        data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
+        data[i].phase_acquires = NULL;
+        if (phase > 0) {
+            data[i].phase_acquires = (unsigned long*) calloc(num_phases, sizeof(unsigned long));
         }
+        data[i].barrier = &barrier;
+        bench_start_thread(&threads[i], bench_core(i), test, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
-    barrier_cross(&barrier);
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
+    int phase_ms[MAX_PHASES];
+    if (phase > 0) {
+        int p, left = duration;
+        barrier_cross(&barrier);
+        duration = 0;
+        for (p = 0; p < num_phases; p++) {
+            int len = (p == num_phases - 1) ? left : phase;
+            cur_phase = p;
+            phase_ms[p] = bench_run(NULL, len);
+            duration += phase_ms[p];
+            left -= len;
+        }
     } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
+        duration = bench_run(&barrier, duration);
     }
     stop = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
 #ifdef PRINT_OUTPUT
     for (i = 0; i < cl_access * num_threads; i++)
@@ -409,7 +412,6 @@ int main(int argc, char **argv)
         printf("\n");
     }
 #endif
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
     unsigned long acquires = 0;
     for (i = 0; i < num_threads; i++) {
@@ -422,6 +424,20 @@ int main(int argc, char **argv)
 #ifdef PRINT_OUTPUT
     printf("Duration      : %d (ms)\n", duration);
 #endif
+    if (phase > 0) {
+        int p;
+        for (p = 0; p < num_phases; p++) {
+            unsigned long phase_acquires = 0;
+            for (i = 0; i < num_threads; i++) {
+                phase_acquires += data[i].phase_acquires[p];
+            }
+            printf("phase %-2d %-4s : %lu ( %lu / s)\n", p, (p & 1) ? "low" : "high", phase_acquires,
+                    (unsigned long )(phase_acquires * 1000.0 / (phase_ms[p] > 0 ? phase_ms[p] : 1)));
+        }
+        for (i = 0; i < num_threads; i++) {
+            free(data[i].phase_acquires);
+        }
+    }
     printf("#acquires     : %lu ( %lu / s)\n", acquires, (unsigned long )(acquires * 1000.0 / duration));
 
     /* Cleanup locks */
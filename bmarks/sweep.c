@@ -0,0 +1,500 @@
+/*
+ * File: sweep.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Runs a benchmark over ranges of thread counts, lock counts and
+ *      critical section lengths, repeats every point and prints the median
+ *      of every metric with its confidence interval, as CSV or JSON
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "lock_rt.h"
+
+#define STR(s) #s
+#define XSTR(s) STR(s)
+
+#define DEFAULT_BENCHES "stress_test"
+#define DEFAULT_THREADS "1"
+#define DEFAULT_REPEATS 5
+#define DEFAULT_DURATION 1000
+#define DEFAULT_LABEL "static"
+
+//environment variable read by the runtime selected locks (lock_rt.h)
+#define LOCK_ENV "LIBSLOCK_LOCK"
+
+#define MAX_VALUES 256
+#define MAX_REPEATS 101
+#define MAX_METRICS 4
+#define MAX_ARGS 64
+#define OUTPUT_SIZE (1 << 16)
+
+//a dimension that is not swept keeps the default of the benchmark
+#define NOT_SET -1
+
+typedef struct bench {
+    const char* name;
+    const char* locks_opt; //number of locks (accounts for the banks)
+    const char* acquire_opt; //critical section length in cycles, NULL if fixed
+    int num_metrics;
+    const char* metrics[MAX_METRICS];
+    int (*parse)(const char* out, double* values); //returns 0 if all the metrics were found
+} bench_t;
+
+//"#acquires     : 39790 ( 130888 / s)"
+static int parse_stress_test(const char* out, double* values) {
+    const char* p = strstr(out, "#acquires");
+    if (p == NULL) return 1;
+    return sscanf(p, "#acquires : %*u ( %lf", &values[0]) != 1;
+}
+
+//"#txs          : 3621322 ( 3606894 / s)"
+static int parse_bank(const char* out, double* values) {
+    const char* p = strstr(out, "#txs ");
+    if (p == NULL) return 1;
+    return sscanf(p, "#txs : %*u ( %lf", &values[0]) != 1;
+}
+
+//first line of out that starts with prefix
+static const char* find_line(const char* out, const char* prefix) {
+    size_t len = strlen(prefix);
+    while (out != NULL && *out != '\0') {
+        if (strncmp(out, prefix, len) == 0) return out;
+        out = strchr(out, '\n');
+        if (out != NULL) out++;
+    }
+    return NULL;
+}
+
+//"acquire  n=3415 avg=50 p50=52 p90=62 p99=77 ..." and the same for release
+static int parse_stress_latency(const char* out, double* values) {
+    const char* p = find_line(out, "acquire ");
+    if (p == NULL) return 1;
+    if (sscanf(p, "acquire n=%*u avg=%lf p50=%lf p90=%*u p99=%lf", &values[0], &values[1], &values[2]) != 3) return 1;
+    p = find_line(out, "release ");
+    if (p == NULL) return 1;
+    return sscanf(p, "release n=%*u avg=%lf", &values[3]) != 1;
+}
+
+static const bench_t benches[] = {
+    { "stress_test", "-l", "-a", 1, { "acquires_per_s" }, parse_stress_test },
+    { "stress_latency", "-l", "-a", 4, { "acquire_avg", "acquire_p50", "acquire_p99", "release_avg" }, parse_stress_latency },
+    { "bank", "-a", NULL, 1, { "txs_per_s" }, parse_bank },
+    { "bank_one", "-a", NULL, 1, { "txs_per_s" }, parse_bank },
+};
+
+#define NUM_BENCHES (sizeof(benches) / sizeof(benches[0]))
+
+static const bench_t* find_bench(const char* name) {
+    unsigned int i;
+    for (i = 0; i < NUM_BENCHES; i++) {
+        if (strcmp(name, benches[i].name) == 0) return &benches[i];
+    }
+    return NULL;
+}
+
+//splits a comma separated list in place; returns the number of items
+static int split_list(char* s, char** items, int max) {
+    int n = 0;
+    char* save;
+    char* tok = strtok_r(s, ",", &save);
+    while (tok != NULL && n < max) {
+        items[n++] = tok;
+        tok = strtok_r(NULL, ",", &save);
+    }
+    return n;
+}
+
+//"1,2,4", "1-16" or "1-16:2", mixed freely; returns the number of values, or -1 on a syntax error
+static int parse_values(const char* s, int* values) {
+    char buf[1024];
+    char* items[MAX_VALUES];
+    int i, n = 0;
+    strncpy(buf, s, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    int num_items = split_list(buf, items, MAX_VALUES);
+    for (i = 0; i < num_items; i++) {
+        int from, to, step = 1;
+        int k = sscanf(items[i], "%d-%d:%d", &from, &to, &step);
+        if (k < 1 || step < 1) return -1;
+        if (k == 1) to = from;
+        for (; from <= to && n < MAX_VALUES; from += step) {
+            values[n++] = from;
+        }
+    }
+    return n;
+}
+
+//runs path with args and the lock in LOCK_ENV (if not NULL); stdout goes to out
+static int run_once(const char* path, char** args, const char* lock, char* out, size_t size) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(fds[1], STDOUT_FILENO);
+        if (null_fd >= 0) dup2(null_fd, STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        if (lock != NULL) setenv(LOCK_ENV, lock, 1);
+        execv(path, args);
+        _exit(127);
+    }
+    close(fds[1]);
+    size_t len = 0;
+    ssize_t r;
+    while ((r = read(fds[0], out + len, size - 1 - len)) > 0) {
+        len += r;
+        if (len == size - 1) {
+            //keep the tail, where the summaries are
+            memmove(out, out + size / 2, len - size / 2);
+            len -= size / 2;
+        }
+    }
+    out[len] = '\0';
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    return !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+typedef struct summary {
+    double median, ci_low, ci_high, mean, stddev;
+} summary_t;
+
+//the confidence interval of the median comes from the order statistics (95%,
+//normal approximation of the binomial, ranks n/2 - 0.98 sqrt(n) and
+//1 + n/2 + 0.98 sqrt(n), Conover), so it does not assume normal runs;
+//with up to 10 runs it spans all the values
+static void summarize(double* v, int n, summary_t* s) {
+    int i;
+    qsort(v, n, sizeof(double), cmp_double);
+    s->median = (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    int lo = (int) floor(n / 2.0 - 0.98 * sqrt(n));
+    int hi = (int) ceil(1 + n / 2.0 + 0.98 * sqrt(n));
+    if (lo < 1) lo = 1;
+    if (hi > n) hi = n;
+    s->ci_low = v[lo - 1];
+    s->ci_high = v[hi - 1];
+    double sum = 0, sq = 0;
+    for (i = 0; i < n; i++) sum += v[i];
+    s->mean = sum / n;
+    for (i = 0; i < n; i++) sq += (v[i] - s->mean) * (v[i] - s->mean);
+    s->stddev = (n > 1) ? sqrt(sq / (n - 1)) : 0;
+}
+
+typedef enum { FORMAT_CSV, FORMAT_JSON } format_t;
+
+static int num_records = 0;
+
+static void print_header(format_t format) {
+    if (format == FORMAT_CSV) {
+        printf("bench,lock,threads,locks,acquire,metric,runs,median,ci_low,ci_high,mean,stddev\n");
+    } else {
+        printf("[");
+    }
+}
+
+static void print_dim(format_t format, int value) {
+    if (value != NOT_SET) printf("%d", value);
+    else if (format == FORMAT_JSON) printf("null");
+}
+
+static void print_record(format_t format, const char* bench, const char* lock, int threads, int locks, int acquire,
+        const char* metric, int runs, summary_t* s) {
+    if (format == FORMAT_CSV) {
+        printf("%s,%s,%d,", bench, lock, threads);
+        print_dim(format, locks);
+        printf(",");
+        print_dim(format, acquire);
+        printf(",%s,%d,%.1f,%.1f,%.1f,%.1f,%.1f\n", metric, runs, s->median, s->ci_low, s->ci_high, s->mean, s->stddev);
+    } else {
+        printf("%s\n  {\"bench\": \"%s\", \"lock\": \"%s\", \"threads\": %d, \"locks\": ", num_records ? "," : "", bench, lock, threads);
+        print_dim(format, locks);
+        printf(", \"acquire\": ");
+        print_dim(format, acquire);
+        printf(", \"metric\": \"%s\", \"runs\": %d, \"median\": %.1f, \"ci_low\": %.1f, \"ci_high\": %.1f, \"mean\": %.1f, \"stddev\": %.1f}",
+                metric, runs, s->median, s->ci_low, s->ci_high, s->mean, s->stddev);
+    }
+    num_records++;
+    fflush(stdout);
+}
+
+static void print_footer(format_t format) {
+    if (format == FORMAT_JSON) {
+        printf("\n]\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    struct option long_options[] = {
+        // These options don't set a flag
+        {"help",                      no_argument,       NULL, 'h'},
+        {"benches",                   required_argument, NULL, 'b'},
+        {"locks",                     required_argument, NULL, 'L'},
+        {"label",                     required_argument, NULL, 't'},
+        {"num-threads",               required_argument, NULL, 'n'},
+        {"num-locks",                 required_argument, NULL, 'l'},
+        {"acquire",                   required_argument, NULL, 'a'},
+        {"repeats",                   required_argument, NULL, 'r'},
+        {"duration",                  required_argument, NULL, 'd'},
+        {"format",                    required_argument, NULL, 'f'},
+        {"exec-dir",                  required_argument, NULL, 'x'},
+        {NULL, 0, NULL, 0}
+    };
+
+    char bench_list[1024] = DEFAULT_BENCHES;
+    char lock_list[1024] = "";
+    const char* label = DEFAULT_LABEL;
+    const char* thread_values = DEFAULT_THREADS;
+    const char* lock_values = NULL;
+    const char* acquire_values = NULL;
+    const char* exec_dir = ".";
+    int repeats = DEFAULT_REPEATS;
+    int duration = DEFAULT_DURATION;
+    format_t format = FORMAT_CSV;
+
+    int i, c;
+    while(1) {
+        i = 0;
+        c = getopt_long(argc, argv, "hb:L:t:n:l:a:r:d:f:x:", long_options, &i);
+
+        if(c == -1)
+            break;
+
+        if(c == 0 && long_options[i].flag == 0)
+            c = long_options[i].val;
+
+        switch(c) {
+            case 0:
+                /* Flag is automatically set */
+                break;
+            case 'h':
+                printf("sweep -- runs a benchmark over a range of parameters\n"
+                        "\n"
+                        "Usage:\n"
+                        "  sweep [options...] [-- benchmark options...]\n"
+                        "\n"
+                        "Options:\n"
+                        "  -h, --help\n"
+                        "        Print this message\n"
+                        "  -b, --benches <list>\n"
+                        "        Benchmarks to run: stress_test, stress_latency, bank, bank_one (default=" DEFAULT_BENCHES ")\n"
+                        "  -L, --locks <list>\n"
+                        "        Locks passed in " LOCK_ENV " to a LOCK_VERSION=-DUSE_RUNTIME_LOCKS build (default=the lock of the build)\n"
+                        "  -t, --label <name>\n"
+                        "        Name of the lock of the build in the output, without -L (default=" DEFAULT_LABEL ")\n"
+                        "  -n, --num-threads <values>\n"
+                        "        Thread counts, e.g. 1,2,4 or 1-16 or 2-32:2 (default=" DEFAULT_THREADS ")\n"
+                        "  -l, --num-locks <values>\n"
+                        "        Number of locks (accounts for the banks) (default=the benchmark's)\n"
+                        "  -a, --acquire <values>\n"
+                        "        Cycles a lock is held, not for the banks (default=the benchmark's)\n"
+                        "  -r, --repeats <int>\n"
+                        "        Runs of every point (default=" XSTR(DEFAULT_REPEATS) ", at most " XSTR(MAX_REPEATS) ")\n"
+                        "  -d, --duration <int>\n"
+                        "        Duration of a run in milliseconds (default=" XSTR(DEFAULT_DURATION) ")\n"
+                        "  -f, --format <csv|json>\n"
+                        "        Output format (default=csv)\n"
+                        "  -x, --exec-dir <dir>\n"
+                        "        Directory of the benchmark binaries (default=.)\n"
+                        );
+                exit(0);
+            case 'b':
+                strncpy(bench_list, optarg, sizeof(bench_list) - 1);
+                break;
+            case 'L':
+                strncpy(lock_list, optarg, sizeof(lock_list) - 1);
+                break;
+            case 't':
+                label = optarg;
+                break;
+            case 'n':
+                thread_values = optarg;
+                break;
+            case 'l':
+                lock_values = optarg;
+                break;
+            case 'a':
+                acquire_values = optarg;
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'f':
+                if (strcmp(optarg, "csv") == 0) format = FORMAT_CSV;
+                else if (strcmp(optarg, "json") == 0) format = FORMAT_JSON;
+                else {
+                    fprintf(stderr, "Unknown format %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'x':
+                exec_dir = optarg;
+                break;
+            case '?':
+                printf("Use -h or --help for help\n");
+                exit(0);
+            default:
+                exit(1);
+        }
+    }
+
+    if (repeats < 1 || repeats > MAX_REPEATS || duration < 1) {
+        fprintf(stderr, "Invalid number of repeats or duration\n");
+        exit(1);
+    }
+
+    char* bench_names[MAX_VALUES];
+    char* locks[MAX_VALUES];
+    int threads[MAX_VALUES], num_locks[MAX_VALUES], acquires[MAX_VALUES];
+    int num_benches = split_list(bench_list, bench_names, MAX_VALUES);
+    int num_lock_names = split_list(lock_list, locks, MAX_VALUES);
+    int num_threads = parse_values(thread_values, threads);
+    int num_num_locks = 1, num_acquires = 1;
+    num_locks[0] = NOT_SET;
+    acquires[0] = NOT_SET;
+    if (lock_values != NULL) num_num_locks = parse_values(lock_values, num_locks);
+    if (acquire_values != NULL) num_acquires = parse_values(acquire_values, acquires);
+    if (num_threads < 1 || num_num_locks < 1 || num_acquires < 1) {
+        fprintf(stderr, "Invalid list of values\n");
+        exit(1);
+    }
+    //without -L the binaries run with the lock they were built with
+    if (num_lock_names == 0) {
+        locks[0] = NULL;
+        num_lock_names = 1;
+    }
+
+    for (i = 0; i < num_lock_names && locks[i] != NULL; i++) {
+        if (lock_rt_select(locks[i]) != 0) {
+            fprintf(stderr, "Unknown lock %s\n", locks[i]);
+            exit(1);
+        }
+    }
+    for (i = 0; i < num_benches; i++) {
+        if (find_bench(bench_names[i]) == NULL) {
+            fprintf(stderr, "Unknown benchmark %s\n", bench_names[i]);
+            exit(1);
+        }
+    }
+
+    char* out = (char*) malloc(OUTPUT_SIZE);
+    double values[MAX_METRICS][MAX_REPEATS];
+    int failed = 0;
+
+    print_header(format);
+    int b, k, t, l, a, r, m;
+    for (b = 0; b < num_benches; b++) {
+        const bench_t* bench = find_bench(bench_names[b]);
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", exec_dir, bench->name);
+        for (k = 0; k < num_lock_names; k++) {
+            const char* lock_name = locks[k] ? locks[k] : label;
+            for (l = 0; l < num_num_locks; l++) {
+                for (a = 0; a < (bench->acquire_opt ? num_acquires : 1); a++) {
+                    int acquire = bench->acquire_opt ? acquires[a] : NOT_SET;
+                    for (t = 0; t < num_threads; t++) {
+                        char arg_buf[4][16];
+                        char* args[MAX_ARGS];
+                        int n = 0;
+                        args[n++] = path;
+                        snprintf(arg_buf[0], 16, "%d", threads[t]);
+                        args[n++] = "-n";
+                        args[n++] = arg_buf[0];
+                        snprintf(arg_buf[1], 16, "%d", duration);
+                        args[n++] = "-d";
+                        args[n++] = arg_buf[1];
+                        if (num_locks[l] != NOT_SET) {
+                            snprintf(arg_buf[2], 16, "%d", num_locks[l]);
+                            args[n++] = (char*) bench->locks_opt;
+                            args[n++] = arg_buf[2];
+                        }
+                        if (acquire != NOT_SET) {
+                            snprintf(arg_buf[3], 16, "%d", acquire);
+                            args[n++] = (char*) bench->acquire_opt;
+                            args[n++] = arg_buf[3];
+                        }
+                        //the options after "--" go to every benchmark
+                        int e;
+                        for (e = optind; e < argc && n < MAX_ARGS - 1; e++) {
+                            args[n++] = argv[e];
+                        }
+                        args[n] = NULL;
+
+                        int runs = 0;
+                        for (r = 0; r < repeats; r++) {
+                            fprintf(stderr, "%s %s n=%d run %d/%d\n", bench->name, lock_name, threads[t], r + 1, repeats);
+                            double v[MAX_METRICS];
+                            if (run_once(path, args, locks[k], out, OUTPUT_SIZE) != 0 || bench->parse(out, v) != 0) {
+                                fprintf(stderr, "Run of %s failed or printed no results\n", path);
+                                failed++;
+                                continue;
+                            }
+                            for (m = 0; m < bench->num_metrics; m++) {
+                                values[m][runs] = v[m];
+                            }
+                            runs++;
+                        }
+                        if (runs == 0) continue;
+                        for (m = 0; m < bench->num_metrics; m++) {
+                            summary_t s;
+                            summarize(values[m], runs, &s);
+                            print_record(format, bench->name, lock_name, threads[t], num_locks[l], acquire,
+                                    bench->metrics[m], runs, &s);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    print_footer(format);
+
+    free(out);
+    return failed ? 1 : 0;
+}
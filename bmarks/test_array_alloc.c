@@ -37,6 +37,7 @@
 #include <assert.h>
 #include <getopt.h>
 #include <limits.h>
+#include <malloc.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -48,6 +49,7 @@
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 #include "atomic_ops.h"
 
@@ -80,37 +82,6 @@ __attribute__((aligned(CACHE_LINE_SIZE))) volatile shared_data* protected_data;
 int duration;
 int num_threads;
 
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
-
 typedef struct thread_data {
     union
     {
@@ -122,7 +93,21 @@ typedef struct thread_data {
         };
         char padding[CACHE_LINE_SIZE];
     };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
+
+//bytes currently allocated with malloc; main makes all the threads use the same arena
+static size_t heap_in_use()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#elif defined(__GLIBC__)
+    struct mallinfo mi = mallinfo();
+    return (size_t) (unsigned int) mi.uordblks + (size_t) (unsigned int) mi.hblkhd;
+#else
+    return 0;
+#endif
+}
 
 void *test_correctness(void *data)
 {
@@ -148,15 +133,6 @@ void *test_correctness(void *data)
 }
 
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
-
 int main(int argc, char **argv)
 {
     set_cpu(the_cores[0]);
@@ -165,24 +141,21 @@ int main(int argc, char **argv)
         {"help",                      no_argument,       NULL, 'h'},
         {"duration",                  required_argument, NULL, 'd'},
         {"num-threads",               required_argument, NULL, 'n'},
+        {"num-locks",                 required_argument, NULL, 'l'},
         {NULL, 0, NULL, 0}
     };
 
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     duration = DEFAULT_DURATION;
     num_threads = DEFAULT_NUM_THREADS;
     num_locks = DEFAULT_NUM_LOCKS;
-    sigset_t block_set;
 
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "h:d:n:", long_options, &i);
+        c = getopt_long(argc, argv, "h:d:n:l:", long_options, &i);
 
         if(c == -1)
             break;
@@ -207,6 +180,8 @@ int main(int argc, char **argv)
                         "        Test duration in milliseconds (0=infinite, default=" XSTR(DEFAULT_DURATION) ")\n"
                         "  -n, --num-threads <int>\n"
                         "        Number of threads (default=" XSTR(DEFAULT_NUM_THREADS) ")\n"
+                        "  -l, --num-locks <int>\n"
+                        "        Number of locks in the array (default=" XSTR(DEFAULT_NUM_LOCKS) ")\n"
                       );
                 exit(0);
             case 'd':
@@ -215,6 +190,9 @@ int main(int argc, char **argv)
             case 'n':
                 num_threads = atoi(optarg);
                 break;
+            case 'l':
+                num_locks = atoi(optarg);
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -224,6 +202,12 @@ int main(int argc, char **argv)
     }
     assert(duration >= 0);
     assert(num_threads > 0);
+    //the threads acquire lock 5
+    assert(num_locks > 5);
+#ifdef M_ARENA_MAX
+    //so that the allocations of the threads are seen by heap_in_use
+    mallopt(M_ARENA_MAX, 1);
+#endif
 
     protected_data = (shared_data*) malloc(sizeof(shared_data));
     protected_data->counter=0;
@@ -231,10 +215,8 @@ int main(int argc, char **argv)
     printf("Duration               : %d\n", duration);
     printf("Number of threads      : %d\n", num_threads);
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -250,12 +232,12 @@ int main(int argc, char **argv)
 #ifdef PRINT_OUTPUT
     printf("Initializing locks\n");
 #endif
+    size_t heap_start = heap_in_use();
     the_locks = init_lock_array_global(num_locks, num_threads);
+    size_t heap_global = heap_in_use();
 
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -263,47 +245,27 @@ int main(int argc, char **argv)
         data[i].id = i;
         data[i].num_acquires = 0;
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test_correctness, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test_correctness, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
     barrier_cross(&barrier);
+    //all the threads have initialized their local data
+    size_t heap_local = heap_in_use();
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+    duration = bench_run(NULL, duration);
     stop = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
     uint64_t acquires = 0;
     for (i = 0; i < num_threads; i++) {
@@ -316,6 +278,13 @@ int main(int argc, char **argv)
 #ifdef PRINT_OUTPUT
     printf("Duration      : %d (ms)\n", duration);
 #endif
+    //the threads freed their local data; what is left is the global data, which may have grown
+    size_t heap_end = heap_in_use();
+    size_t global_bytes = heap_global - heap_start;
+    size_t global_end = heap_end > heap_start ? heap_end - heap_start : 0;
+    size_t local_bytes = heap_local > heap_global ? heap_local - heap_global : 0;
+    printf("Global data   : %lu bytes (%lu per lock), %lu after the run\n", (unsigned long) global_bytes, (unsigned long) (global_bytes / num_locks), (unsigned long) global_end);
+    printf("Local data    : %lu bytes (%lu per thread)\n", (unsigned long) local_bytes, (unsigned long) (local_bytes / num_threads));
     printf("Counter total : %llu, Expected: %llu\n", (unsigned long long) protected_data->counter, (unsigned long long) acquires);
     if (protected_data->counter != acquires) {
         printf("Incorrect lock behavior!\n");
@@ -47,6 +47,7 @@
 #endif
 #include "gl_lock.h"
 #include "utils.h"
+#include "bench.h"
 #include "lock_if.h"
 #include "atomic_ops.h"
 
@@ -66,6 +67,9 @@ __thread uint32_t phys_id;
 __thread uint32_t cluster_id;
 lock_global_data the_lock;
 __attribute__((aligned(CACHE_LINE_SIZE))) lock_local_data* local_th_data;
+//second lock of the hand-over-hand mode
+lock_global_data the_lock2;
+__attribute__((aligned(CACHE_LINE_SIZE))) lock_local_data* local_th_data2;
 
 typedef struct shared_data{
     volatile uint64_t counter;
@@ -73,39 +77,10 @@ typedef struct shared_data{
 } shared_data;
 
 __attribute__((aligned(CACHE_LINE_SIZE))) volatile shared_data* protected_data;
+__attribute__((aligned(CACHE_LINE_SIZE))) volatile shared_data* protected_data2;
 int duration;
 int num_threads;
-
-typedef struct barrier {
-    pthread_cond_t complete;
-    pthread_mutex_t mutex;
-    int count;
-    int crossing;
-} barrier_t;
-
-void barrier_init(barrier_t *b, int n)
-{
-    pthread_cond_init(&b->complete, NULL);
-    pthread_mutex_init(&b->mutex, NULL);
-    b->count = n;
-    b->crossing = 0;
-}
-
-void barrier_cross(barrier_t *b)
-{
-    pthread_mutex_lock(&b->mutex);
-    /* One more thread through */
-    b->crossing++;
-    /* If not all here, wait */
-    if (b->crossing < b->count) {
-        pthread_cond_wait(&b->complete, &b->mutex);
-    } else {
-        pthread_cond_broadcast(&b->complete);
-        /* Reset for next time */
-        b->crossing = 0;
-    }
-    pthread_mutex_unlock(&b->mutex);
-}
+int hand_over_hand;
 
 typedef struct thread_data {
     union
@@ -118,7 +93,7 @@ typedef struct thread_data {
         };
         char padding[CACHE_LINE_SIZE];
     };
-} thread_data_t;
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
 
 void *test_correctness(void *data)
 {
@@ -127,31 +102,38 @@ void *test_correctness(void *data)
     cluster_id = get_cluster(phys_id);
 
     init_lock_local(phys_id, &the_lock, &(local_th_data[d->id]));
+    if (hand_over_hand) {
+        init_lock_local(phys_id, &the_lock2, &(local_th_data2[d->id]));
+    }
 
     barrier_cross(d->barrier);
 
     lock_local_data* local_d = &(local_th_data[d->id]);
+    lock_local_data* local_d2 = &(local_th_data2[d->id]);
     while (stop == 0) {
         acquire_lock(local_d,&the_lock);
         protected_data->counter++;
-        release_lock(local_d,&the_lock);
+        if (hand_over_hand) {
+            //the first lock is released before the second one
+            acquire_lock(local_d2,&the_lock2);
+            protected_data2->counter++;
+            release_lock(local_d,&the_lock);
+            protected_data2->counter++;
+            release_lock(local_d2,&the_lock2);
+        } else {
+            release_lock(local_d,&the_lock);
+        }
         d->num_acquires++;
     }
 
     free_lock_local(local_th_data[d->id]);
+    if (hand_over_hand) {
+        free_lock_local(local_th_data2[d->id]);
+    }
     return NULL;
 }
 
 
-void catcher(int sig)
-{
-    static int nb = 0;
-    printf("CAUGHT SIGNAL %d\n", sig);
-    if (++nb >= 3)
-        exit(1);
-}
-
-
 int main(int argc, char **argv)
 {
     set_cpu(the_cores[0]);
@@ -160,23 +142,20 @@ int main(int argc, char **argv)
         {"help",                      no_argument,       NULL, 'h'},
         {"duration",                  required_argument, NULL, 'd'},
         {"num-threads",               required_argument, NULL, 'n'},
+        {"hand-over-hand",            no_argument,       NULL, 'o'},
         {NULL, 0, NULL, 0}
     };
 
     int i, c;
     thread_data_t *data;
     pthread_t *threads;
-    pthread_attr_t attr;
     barrier_t barrier;
-    struct timeval start, end;
-    struct timespec timeout;
     duration = DEFAULT_DURATION;
     num_threads = DEFAULT_NUM_THREADS;
-    sigset_t block_set;
 
     while(1) {
         i = 0;
-        c = getopt_long(argc, argv, "h:d:n:", long_options, &i);
+        c = getopt_long(argc, argv, "h:d:n:o", long_options, &i);
 
         if(c == -1)
             break;
@@ -201,6 +180,8 @@ int main(int argc, char **argv)
                         "        Test duration in milliseconds (0=infinite, default=" XSTR(DEFAULT_DURATION) ")\n"
                         "  -n, --num-threads <int>\n"
                         "        Number of threads (default=" XSTR(DEFAULT_NUM_THREADS) ")\n"
+                        "  -o, --hand-over-hand\n"
+                        "        Take a second lock in the critical section and release the first lock before it\n"
                       );
                 exit(0);
             case 'd':
@@ -209,6 +190,9 @@ int main(int argc, char **argv)
             case 'n':
                 num_threads = atoi(optarg);
                 break;
+            case 'o':
+                hand_over_hand = 1;
+                break;
             case '?':
                 printf("Use -h or --help for help\n");
                 exit(0);
@@ -221,14 +205,14 @@ int main(int argc, char **argv)
 
     protected_data = (shared_data*) malloc(sizeof(shared_data));
     protected_data->counter=0;
+    protected_data2 = (shared_data*) malloc(sizeof(shared_data));
+    protected_data2->counter=0;
 #ifdef PRINT_OUTPUT
     printf("Duration               : %d\n", duration);
     printf("Number of threads      : %d\n", num_threads);
 #endif
-    timeout.tv_sec = duration / 1000;
-    timeout.tv_nsec = (duration % 1000) * 1000000;
 
-    if ((data = (thread_data_t *)malloc(num_threads * sizeof(thread_data_t))) == NULL) {
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
         perror("malloc");
         exit(1);
     }
@@ -238,6 +222,7 @@ int main(int argc, char **argv)
     }
 
     local_th_data = (lock_local_data *)malloc(num_threads*sizeof(lock_local_data));
+    local_th_data2 = (lock_local_data *)malloc(num_threads*sizeof(lock_local_data));
 
     stop = 0;
     /* Init locks */
@@ -245,11 +230,12 @@ int main(int argc, char **argv)
     printf("Initializing locks\n");
 #endif
     init_lock_global_nt(num_threads,&the_lock);
+    if (hand_over_hand) {
+        init_lock_global_nt(num_threads,&the_lock2);
+    }
 
     /* Access set from all threads */
     barrier_init(&barrier, num_threads + 1);
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     for (i = 0; i < num_threads; i++) {
 #ifdef PRINT_OUTPUT
         printf("Creating thread %d\n", i);
@@ -257,47 +243,24 @@ int main(int argc, char **argv)
         data[i].id = i;
         data[i].num_acquires = 0;
         data[i].barrier = &barrier;
-        if (pthread_create(&threads[i], &attr, test_correctness, (void *)(&data[i])) != 0) {
-            fprintf(stderr, "Error creating thread\n");
-            exit(1);
-        }
+        bench_start_thread(&threads[i], bench_core(i), test_correctness, (void *)(&data[i]));
     }
-    pthread_attr_destroy(&attr);
 
     /* Catch some signals */
-    if (signal(SIGHUP, catcher) == SIG_ERR ||
-            signal(SIGINT, catcher) == SIG_ERR ||
-            signal(SIGTERM, catcher) == SIG_ERR) {
-        perror("signal");
-        exit(1);
-    }
+    bench_catch_signals();
 
     /* Start threads */
-    barrier_cross(&barrier);
 #ifdef PRINT_OUTPUT
     printf("STARTING...\n");
 #endif
-    gettimeofday(&start, NULL);
-    if (duration > 0) {
-        nanosleep(&timeout, NULL);
-    } else {
-        sigemptyset(&block_set);
-        sigsuspend(&block_set);
-    }
+    duration = bench_run(&barrier, duration);
     stop = 1;
-    gettimeofday(&end, NULL);
 #ifdef PRINT_OUTPUT
     printf("STOPPING...\n");
 #endif
     /* Wait for thread completion */
-    for (i = 0; i < num_threads; i++) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            fprintf(stderr, "Error waiting for thread completion\n");
-            exit(1);
-        }
-    }
+    bench_join_threads(threads, num_threads);
 
-    duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 
     uint64_t acquires = 0;
     for (i = 0; i < num_threads; i++) {
@@ -314,9 +277,18 @@ int main(int argc, char **argv)
     if (protected_data->counter != acquires) {
         printf("Incorrect lock behavior!\n");
     }
+    if (hand_over_hand) {
+        printf("Second lock   : %llu, Expected: %llu\n", (unsigned long long) protected_data2->counter, (unsigned long long) (2 * acquires));
+        if (protected_data2->counter != 2 * acquires) {
+            printf("Incorrect lock behavior!\n");
+        }
+    }
 
     /* Cleanup locks */
     free_lock_global(the_lock);
+    if (hand_over_hand) {
+        free_lock_global(the_lock2);
+    }
 
     free(threads);
     free(data);
@@ -0,0 +1,297 @@
+/*
+ * File: test_timeout.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description: 
+ *      Test which exposes bugs in the acquire_lock_timeout methods of the
+ *      lock algorithms; the lock is held long enough for some waiters to
+ *      give up;
+ *      By no means an exhaustive test, but generally exposes
+ *      a buggy algorithm;
+ *      Each thread continuously increments a global counter
+ *      protected by a lock; if the final counter value is not
+ *      equal to the sum of the increments by each thread, then
+ *      the lock algorithm has a bug.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+#ifndef __sparc__
+#include <numa.h>
+#endif
+#include "gl_lock.h"
+#include "utils.h"
+#include "bench.h"
+#include "lock_if.h"
+#include "atomic_ops.h"
+
+uint64_t c[2] = {0, 0};
+
+#define XSTR(s) #s
+
+//number of concurrent threads
+#define DEFAULT_NUM_THREADS 1
+//total duration of the test, in milliseconds
+#define DEFAULT_DURATION 10000
+//cycles a thread waits for the lock before giving up
+#define DEFAULT_TIMEOUT 20000
+//cycles the lock is held
+#define DEFAULT_HOLD 2000
+
+#ifdef LOCK_NO_TIMEOUT
+//the waiters of the selected lock cannot give up (lock_if.h): nothing to test
+int main(int argc, char **argv)
+{
+    printf("acquire_lock_timeout is not supported by the selected lock\n");
+    return 0;
+}
+#else
+
+static volatile int stop;
+
+__thread unsigned long* seeds;
+__thread uint32_t phys_id;
+__thread uint32_t cluster_id;
+lock_global_data the_lock;
+__attribute__((aligned(CACHE_LINE_SIZE))) lock_local_data* local_th_data;
+
+typedef struct shared_data{
+    volatile uint64_t counter;
+    char padding[56];
+} shared_data;
+
+__attribute__((aligned(CACHE_LINE_SIZE))) volatile shared_data* protected_data;
+int duration;
+int num_threads;
+ticks timeout_cycles;
+ticks hold_cycles;
+
+typedef struct thread_data {
+    union
+    {
+        struct
+        {
+            barrier_t *barrier;
+            unsigned long num_acquires;
+            unsigned long num_timeouts;
+            int id;
+        };
+        char padding[CACHE_LINE_SIZE];
+    };
+} ALIGNED(CACHE_LINE_SIZE) thread_data_t;
+
+void *test_correctness(void *data)
+{
+    thread_data_t *d = (thread_data_t *)data;
+    phys_id = the_cores[d->id];
+    cluster_id = get_cluster(phys_id);
+
+    init_lock_local(phys_id, &the_lock, &(local_th_data[d->id]));
+
+    barrier_cross(d->barrier);
+
+    lock_local_data* local_d = &(local_th_data[d->id]);
+    while (stop == 0) {
+        if (acquire_lock_timeout(local_d,&the_lock,timeout_cycles) !=0) {
+            d->num_timeouts++;
+            continue;
+        }
+        protected_data->counter++;
+        if (hold_cycles > 0) {
+            cpause(hold_cycles);
+        }
+        release_trylock(local_d,&the_lock);
+        d->num_acquires++;
+    }
+
+    free_lock_local(local_th_data[d->id]);
+    return NULL;
+}
+
+
+int main(int argc, char **argv)
+{
+    set_cpu(the_cores[0]);
+    struct option long_options[] = {
+        // These options don't set a flag
+        {"help",                      no_argument,       NULL, 'h'},
+        {"duration",                  required_argument, NULL, 'd'},
+        {"num-threads",               required_argument, NULL, 'n'},
+        {"timeout",                   required_argument, NULL, 't'},
+        {"hold",                      required_argument, NULL, 'a'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int i, c;
+    thread_data_t *data;
+    pthread_t *threads;
+    barrier_t barrier;
+    duration = DEFAULT_DURATION;
+    num_threads = DEFAULT_NUM_THREADS;
+    timeout_cycles = DEFAULT_TIMEOUT;
+    hold_cycles = DEFAULT_HOLD;
+
+    while(1) {
+        i = 0;
+        c = getopt_long(argc, argv, "h:d:n:t:a:", long_options, &i);
+
+        if(c == -1)
+            break;
+
+        if(c == 0 && long_options[i].flag == 0)
+            c = long_options[i].val;
+
+        switch(c) {
+            case 0:
+                /* Flag is automatically set */
+                break;
+            case 'h':
+                printf("lock stress test\n"
+                        "\n"
+                        "Usage:\n"
+                        "  stress_test [options...]\n"
+                        "\n"
+                        "Options:\n"
+                        "  -h, --help\n"
+                        "        Print this message\n"
+                        "  -d, --duration <int>\n"
+                        "        Test duration in milliseconds (0=infinite, default=" XSTR(DEFAULT_DURATION) ")\n"
+                        "  -n, --num-threads <int>\n"
+                        "        Number of threads (default=" XSTR(DEFAULT_NUM_THREADS) ")\n"
+                        "  -t, --timeout <int>\n"
+                        "        Cycles to wait for the lock before giving up (default=" XSTR(DEFAULT_TIMEOUT) ")\n"
+                        "  -a, --hold <int>\n"
+                        "        Cycles the lock is held (default=" XSTR(DEFAULT_HOLD) ")\n"
+                      );
+                exit(0);
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'n':
+                num_threads = atoi(optarg);
+                break;
+            case 't':
+                timeout_cycles = atol(optarg);
+                break;
+            case 'a':
+                hold_cycles = atol(optarg);
+                break;
+            case '?':
+                printf("Use -h or --help for help\n");
+                exit(0);
+            default:
+                exit(1);
+        }
+    }
+    assert(duration >= 0);
+    assert(num_threads > 0);
+
+    protected_data = (shared_data*) malloc(sizeof(shared_data));
+    protected_data->counter=0;
+#ifdef PRINT_OUTPUT
+    printf("Duration               : %d\n", duration);
+    printf("Number of threads      : %d\n", num_threads);
+#endif
+
+    if ((data = (thread_data_t *)bench_alloc_slots(num_threads, sizeof(thread_data_t))) == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    if ((threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t))) == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+
+    local_th_data = (lock_local_data *)malloc(num_threads*sizeof(lock_local_data));
+
+    stop = 0;
+    /* Init locks */
+#ifdef PRINT_OUTPUT
+    printf("Initializing locks\n");
+#endif
+    init_lock_global_nt(num_threads,&the_lock);
+
+    /* Access set from all threads */
+    barrier_init(&barrier, num_threads + 1);
+    for (i = 0; i < num_threads; i++) {
+#ifdef PRINT_OUTPUT
+        printf("Creating thread %d\n", i);
+#endif
+        data[i].id = i;
+        data[i].num_acquires = 0;
+        data[i].num_timeouts = 0;
+        data[i].barrier = &barrier;
+        bench_start_thread(&threads[i], bench_core(i), test_correctness, (void *)(&data[i]));
+    }
+
+    /* Catch some signals */
+    bench_catch_signals();
+
+    /* Start threads */
+#ifdef PRINT_OUTPUT
+    printf("STARTING...\n");
+#endif
+    duration = bench_run(&barrier, duration);
+    stop = 1;
+#ifdef PRINT_OUTPUT
+    printf("STOPPING...\n");
+#endif
+    /* Wait for thread completion */
+    bench_join_threads(threads, num_threads);
+
+
+    uint64_t acquires = 0;
+    uint64_t timeouts = 0;
+    for (i = 0; i < num_threads; i++) {
+        printf("Thread %d\n", i);
+        printf("  # acquires   : %lu\n", data[i].num_acquires);
+        printf("  # timeouts   : %lu\n", data[i].num_timeouts);
+        acquires += data[i].num_acquires;
+        timeouts += data[i].num_timeouts;
+    }
+    printf("Timeouts      : %llu\n", (unsigned long long) timeouts);
+#ifdef PRINT_OUTPUT
+    printf("Duration      : %d (ms)\n", duration);
+#endif
+    printf("Counter total : %llu, Expected: %llu\n", (unsigned long long) protected_data->counter, (unsigned long long) acquires);
+    if (protected_data->counter != acquires) {
+        printf("Incorrect lock behavior!\n");
+    }
+
+    /* Cleanup locks */
+    free_lock_global(the_lock);
+
+    free(threads);
+    free(data);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+ * File: alock_dyn.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Array (Anderson) lock with a ring of slots that grows with the
+ *      contention: a lock starts with ALOCK_DYN_INIT_SLOTS slots, and the
+ *      holder doubles the ring when it sees more waiters than slots. A slot
+ *      holds the ticket it lets in, so waiters sharing a slot stay ordered.
+ *      There is no per-lock local data.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _ALOCK_DYN_H_
+#define _ALOCK_DYN_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <assert.h>
+#if defined(PLATFORM_NUMA)
+#  include <numa.h>
+#endif
+#include "utils.h"
+#include "atomic_ops.h"
+
+//slots of a new lock; a power of two
+#ifndef ALOCK_DYN_INIT_SLOTS
+#  define ALOCK_DYN_INIT_SLOTS 4
+#endif
+//the ring stops growing at this size; the waiters beyond share slots
+#ifndef ALOCK_DYN_MAX_SLOTS
+#  define ALOCK_DYN_MAX_SLOTS 1024
+#endif
+
+typedef struct alock_dyn_slot {
+    volatile uint32_t grant; //ticket allowed to enter by this slot
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 4];
+#endif
+} alock_dyn_slot_t;
+
+typedef struct alock_dyn_ring {
+    uint32_t size;       //number of slots, a power of two
+    uint32_t interleaved; //allocated with numa_alloc_interleaved
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+#endif
+    alock_dyn_slot_t slots[];
+} alock_dyn_ring_t;
+
+typedef struct alock_dyn_lock {
+    volatile uint32_t tail; //next ticket
+    volatile uint32_t head; //ticket of the holder, or next to enter if the lock is free
+    alock_dyn_ring_t* volatile ring;
+    //ring replaced by the last growth, still used by the waiters with a ticket below old_until
+    alock_dyn_ring_t* old_ring;
+    uint32_t old_until;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 28];
+#endif
+} alock_dyn_lock_t;
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+alock_dyn_lock_t* init_alock_dyn_array_global(uint32_t num_locks);
+
+void init_alock_dyn_array_local(uint32_t thread_num);
+
+void end_alock_dyn_array_local();
+
+void end_alock_dyn_array_global(alock_dyn_lock_t* the_locks, uint32_t num_locks);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_alock_dyn_global(alock_dyn_lock_t* the_lock);
+
+int init_alock_dyn_local(uint32_t thread_num);
+
+void end_alock_dyn_local();
+
+void end_alock_dyn_global(alock_dyn_lock_t the_lock);
+
+/*
+ *  Acquire and release methods
+ */
+
+void alock_dyn_acquire(alock_dyn_lock_t* lock);
+
+void alock_dyn_release(alock_dyn_lock_t* lock);
+
+//returns 0 on success, 1 otherwise
+int alock_dyn_trylock(alock_dyn_lock_t* lock);
+
+int is_free_alock_dyn(alock_dyn_lock_t* lock);
+
+//threads holding or waiting for the lock
+uint32_t alock_dyn_queue_length(alock_dyn_lock_t* lock);
+
+//number of slots of the ring of the lock
+uint32_t alock_dyn_size(alock_dyn_lock_t* lock);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * File: bench.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Harness shared by the benchmarks: a spinning barrier, a launcher
+ *      of pinned threads, the timed run of the main thread, signal
+ *      handling and cache-aligned per-thread data
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//spins of a thread waiting on a barrier before it starts yielding the cpu,
+//so that oversubscribed runs still start quickly
+#define BENCH_BARRIER_SPINS 4096
+
+//the last thread to arrive starts a new episode, which releases the others;
+//unlike a condition variable, no thread has to be woken up
+typedef struct barrier {
+    union {
+        struct {
+            volatile uint32_t crossing;
+            volatile uint32_t episode;
+            uint32_t count;
+        };
+        uint8_t padding[CACHE_LINE_SIZE];
+    };
+} barrier_t;
+
+void barrier_init(barrier_t *b, int n);
+
+void barrier_cross(barrier_t *b);
+
+//core of the thread with the given id: consecutive ids fill the_cores, and wrap around when oversubscribed
+static inline uint32_t bench_core(uint32_t id) {
+    return the_cores[id % (NUMBER_OF_SOCKETS * CORES_PER_SOCKET)];
+}
+
+//starts fn(arg) on a thread pinned to core before fn runs; exits on failure
+void bench_start_thread(pthread_t* thread, uint32_t core, void* (*fn)(void*), void* arg);
+
+void bench_join_threads(pthread_t* threads, uint32_t num_threads);
+
+//zeroed array of num per-thread slots, aligned to a cache line; declare the
+//slot type ALIGNED(CACHE_LINE_SIZE) so that threads never share a line
+void* bench_alloc_slots(uint32_t num, size_t size);
+
+//prints the first SIGHUP, SIGINT or SIGTERM signals, exits at the third one
+void bench_catch_signals();
+
+//crosses the start barrier (if not NULL) with the threads and returns after
+//duration ms, or after a signal if duration is 0; returns the measured duration in ms
+int bench_run(barrier_t* start, int duration);
+
+#endif
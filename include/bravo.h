@@ -0,0 +1,204 @@
+/*
+ * File: bravo.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Reader bias for any lock (BRAVO, Dice and Kogan, USENIX ATC 2019),
+ *      used by lock_if.h when READER_BIAS is defined (make BRAVO=1). While
+ *      a lock is biased, a reader publishes the lock in a slot of a table
+ *      of visible readers shared by all locks, and does not touch the lock
+ *      itself. A writer acquires the lock, revokes the bias and waits until
+ *      no slot holds the lock; the bias is re-enabled by a slow reader once
+ *      BRAVO_INHIBIT_MULT times the revocation time has passed. The bias
+ *      state of a lock is kept in a table indexed by its address; the entry
+ *      is dropped when a lock is initialized or freed at that address.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _BRAVO_H_
+#define _BRAVO_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//slots of the visible readers table (power of 2)
+#ifndef BRAVO_VRT_SIZE
+#  define BRAVO_VRT_SIZE 4096
+#endif
+//locks that can be biased at the same time (power of 2); the others always take the slow path
+#ifndef BRAVO_LOCKS
+#  define BRAVO_LOCKS 4096
+#endif
+#define BRAVO_PROBES 8
+//the bias stays off for this many times the duration of the last revocation
+#ifndef BRAVO_INHIBIT_MULT
+#  define BRAVO_INHIBIT_MULT 9
+#endif
+//max number of locks read on the fast path at the same time by one thread
+#define BRAVO_MAX_NESTED 8
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) bravo_state {
+    void* volatile lock;
+    volatile uint32_t rbias;
+    volatile ticks inhibit_until;
+} bravo_state_t;
+
+extern void* volatile bravo_vrt[BRAVO_VRT_SIZE];
+extern bravo_state_t bravo_states[BRAVO_LOCKS];
+
+//locks held on the fast path by the thread, and their slots
+extern __thread void* bravo_held_lock[BRAVO_MAX_NESTED];
+extern __thread uint32_t bravo_held_slot[BRAVO_MAX_NESTED];
+extern __thread uint32_t bravo_held;
+extern __thread uint32_t bravo_thread_id;
+
+uint32_t bravo_new_thread_id();
+//reports, once, a lock left without bias because its entries are all taken
+void bravo_table_full(void* lock);
+
+//the bias state of lock; claims a free entry if create is set; NULL if there is none
+static inline bravo_state_t* bravo_state(void* lock, int create) {
+    uintptr_t h = ((uintptr_t) lock >> 3) * 0x9E3779B97F4A7C15ULL;
+    uint32_t i;
+    //entries are released, so a free entry does not end the probes
+    for (i = 0; i < BRAVO_PROBES; i++) {
+        bravo_state_t* st = &bravo_states[(h + i) & (BRAVO_LOCKS - 1)];
+        if (st->lock == lock) {
+            return st;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    for (i = 0; i < BRAVO_PROBES; i++) {
+        bravo_state_t* st = &bravo_states[(h + i) & (BRAVO_LOCKS - 1)];
+        void* owner = st->lock;
+        //the entry may have been claimed for the same lock by another thread meanwhile
+        if (owner == lock) {
+            return st;
+        }
+        if (owner == NULL) {
+            owner = CAS_PTR(&st->lock, NULL, lock);
+            if (owner == NULL || owner == lock) {
+                return st;
+            }
+        }
+    }
+    bravo_table_full(lock);
+    return NULL;
+}
+
+//drops the bias state of the locks of an array, so that the entries can be reused
+//and a later lock at the same address does not start with a stale state;
+//no reader or writer may be using the locks
+static inline void bravo_locks_reset(void* locks, size_t size, int num_locks) {
+    int n;
+    for (n = 0; n < num_locks; n++) {
+        void* lock = (char*) locks + n * size;
+        bravo_state_t* st;
+        while ((st = bravo_state(lock, 0)) != NULL) {
+            st->rbias = 0;
+            st->inhibit_until = 0;
+            MEM_BARRIER;
+            st->lock = NULL;
+        }
+    }
+}
+
+/*
+ *  Hooks called by lock_if.h
+ */
+
+//returns 1 if the read lock was taken on the fast path
+static inline int bravo_read_fast(void* lock) {
+    bravo_state_t* st = bravo_state(lock, 0);
+    if (st == NULL || st->rbias == 0 || bravo_held >= BRAVO_MAX_NESTED) {
+        return 0;
+    }
+    if (bravo_thread_id == 0) {
+        bravo_thread_id = bravo_new_thread_id();
+    }
+    uint32_t slot = (uint32_t) ((((uintptr_t) lock >> 3) ^ (bravo_thread_id * 0x9E3779B1U)) & (BRAVO_VRT_SIZE - 1));
+    if (bravo_vrt[slot] != NULL || CAS_PTR(&bravo_vrt[slot], NULL, lock) != NULL) {
+        return 0;
+    }
+    //the CAS is a full barrier: a writer revoking the bias after this point waits for the slot
+    if (st->rbias) {
+        bravo_held_lock[bravo_held] = lock;
+        bravo_held_slot[bravo_held] = slot;
+        bravo_held++;
+        return 1;
+    }
+    bravo_vrt[slot] = NULL;
+    return 0;
+}
+
+//read lock taken on the slow path: re-enables the bias once the inhibition period is over
+static inline void bravo_read_slow(void* lock) {
+    bravo_state_t* st = bravo_state(lock, 1);
+    if (st != NULL && st->rbias == 0 && getticks() >= st->inhibit_until) {
+        st->rbias = 1;
+    }
+}
+
+//returns 1 if the read lock was taken on the fast path, and releases it
+static inline int bravo_read_release(void* lock) {
+    int i;
+    for (i = (int) bravo_held - 1; i >= 0; i--) {
+        if (bravo_held_lock[i] == lock) {
+            COMPILER_BARRIER;
+#ifdef __tile__
+            MEM_BARRIER;
+#endif
+            bravo_vrt[bravo_held_slot[i]] = NULL;
+            bravo_held--;
+            bravo_held_lock[i] = bravo_held_lock[bravo_held];
+            bravo_held_slot[i] = bravo_held_slot[bravo_held];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//lock acquired exclusively: revokes the bias and waits for the fast readers to leave
+static inline void bravo_write_acquired(void* lock) {
+    bravo_state_t* st = bravo_state(lock, 0);
+    if (st == NULL || st->rbias == 0) {
+        return;
+    }
+    st->rbias = 0;
+    MEM_BARRIER;
+    ticks start = getticks();
+    uint32_t i;
+    for (i = 0; i < BRAVO_VRT_SIZE; i++) {
+        while (bravo_vrt[i] == lock) {
+            PAUSE;
+        }
+    }
+    ticks now = getticks();
+    st->inhibit_until = now + (now - start) * BRAVO_INHIBIT_MULT;
+}
+
+#endif
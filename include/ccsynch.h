@@ -0,0 +1,110 @@
+/*
+ * File: ccsynch.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Combining lock (CC-Synch, Fatourou and Kallimanis, PPoPP 2012): a
+ *      thread submits a function and its argument instead of acquiring the
+ *      lock; the thread at the head of the queue (the combiner) runs the
+ *      requests of the threads queued behind it, up to CCSYNCH_MAX_COMBINE
+ *      of them, and hands the role to the next waiter. The queue is built
+ *      like the clh one: a thread swaps its node into the tail and takes
+ *      over the node of its predecessor.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _CCSYNCH_H_
+#define _CCSYNCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//max number of requests a combiner runs before handing the role to the next waiter
+#ifndef CCSYNCH_MAX_COMBINE
+#  define CCSYNCH_MAX_COMBINE 64
+#endif
+
+//a critical section: runs on the combiner's thread, with the argument of the requester
+typedef void* (*ccsynch_fn)(void* arg);
+
+typedef struct ccsynch_qnode {
+    volatile ccsynch_fn fn;
+    void* volatile arg;
+    void* volatile ret;
+    volatile uint8_t wait;      //cleared when the request ran or the node's owner becomes the combiner
+    volatile uint8_t completed; //the request was run by a combiner
+    volatile struct ccsynch_qnode *volatile next;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 40];
+#endif
+} ccsynch_qnode;
+
+typedef volatile ccsynch_qnode *ccsynch_qnode_ptr;
+typedef ccsynch_qnode_ptr ccsynch_lock;
+
+//the node of a thread; changes with every request
+typedef ccsynch_qnode* ccsynch_local_params;
+
+typedef struct ccsynch_global_params {
+    ccsynch_lock* the_lock;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+#endif
+} ccsynch_global_params;
+
+/*
+ *  Lock array creation and destruction methods
+ */
+ccsynch_global_params* init_ccsynch_array_global(uint32_t num_locks);
+
+ccsynch_local_params* init_ccsynch_array_local(uint32_t thread_num, uint32_t num_locks);
+
+void end_ccsynch_array_local(ccsynch_local_params* the_params, uint32_t size);
+
+void end_ccsynch_array_global(ccsynch_global_params* the_locks, uint32_t size);
+
+/*
+ *  Single lock creation and destruction methods
+ */
+int init_ccsynch_global(ccsynch_global_params* the_lock);
+
+int init_ccsynch_local(uint32_t thread_num, ccsynch_local_params* local_d);
+
+void end_ccsynch_local(ccsynch_local_params the_params);
+
+void end_ccsynch_global(ccsynch_global_params the_lock);
+
+/*
+ *  Lock manipulation methods
+ */
+
+//runs fn(arg) in mutual exclusion with the other requests on the lock, and returns its result
+void* ccsynch_execute(ccsynch_lock* L, ccsynch_local_params* my_qnode, ccsynch_fn fn, void* arg);
+
+int is_free_ccsynch(ccsynch_lock* L);
+
+#endif
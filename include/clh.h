@@ -44,10 +44,14 @@
 #include "utils.h"
 #include "atomic_ops.h"
 
+//value of locked once the waiter gave up; its successor waits on pred instead, and frees the node
+#define CLH_ABANDONED 2
+
 typedef struct clh_qnode {
     volatile uint8_t locked;
+    volatile struct clh_qnode *volatile pred; //only set in abandoned nodes
 #ifdef ADD_PADDING
-    uint8_t padding[CACHE_LINE_SIZE - 1];
+    uint8_t padding[CACHE_LINE_SIZE - 16];
 #endif
 } clh_qnode;
 
@@ -98,5 +102,9 @@ clh_qnode* clh_release(clh_qnode* my_qnode, clh_qnode* my_pred);
 
 int clh_trylock(clh_lock * L, clh_qnode_ptr I);
 
+//waits at most timeout cycles; returns 0 on success and sets *my_pred, 1 otherwise;
+//a waiter that gives up behind another one leaves its node to it, and gets a new one in *my_qnode
+int clh_acquire_timeout(clh_lock* L, clh_qnode** my_qnode, clh_qnode** my_pred, ticks timeout);
+
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * File: cna.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description: 
+ *      Compact NUMA-aware (CNA) lock (Dice, Kogan, EuroSys 2019): an MCS lock
+ *      that moves the waiters of other sockets to a secondary queue at release
+ *      time, so that the lock is passed within a socket; the secondary queue
+ *      is moved back in front after CNA_MAX_HANDOFFS consecutive local
+ *      hand-offs, or when there are no local waiters left. The lock is one
+ *      word, as for MCS.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _CNA_H_
+#define _CNA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#ifndef __sparc__
+#include <numa.h>
+#endif
+#include <pthread.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//max number of consecutive hand-offs within a socket while remote threads wait
+#ifndef CNA_MAX_HANDOFFS
+#  define CNA_MAX_HANDOFFS 256
+#endif
+
+//values of spin besides the head of the secondary queue
+#define CNA_WAITING 0
+#define CNA_GRANTED 1 //owner of the lock, secondary queue empty
+
+typedef struct cna_qnode {
+    volatile uintptr_t spin; //word on which to spin; the owner keeps the head of the secondary queue here
+    volatile struct cna_qnode *volatile next;
+    volatile struct cna_qnode *sec_tail; //only valid in the head of the secondary queue
+    volatile uint32_t handoffs; //consecutive hand-offs within the socket
+    uint32_t socket;
+#ifdef ADD_PADDING
+#if CACHE_LINE_SIZE > 32
+    uint8_t padding[CACHE_LINE_SIZE - 32];
+#endif
+#endif
+} cna_qnode;
+
+typedef volatile cna_qnode *cna_qnode_ptr;
+typedef cna_qnode_ptr cna_lock; //initialized to NULL
+
+typedef cna_qnode* cna_local_params;
+
+typedef struct cna_global_params {
+    cna_lock* the_lock;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+#endif
+} cna_global_params;
+
+
+/*
+   Methods for easy lock array manipulation
+   */
+
+cna_global_params* init_cna_array_global(uint32_t num_locks);
+
+cna_qnode** init_cna_array_local(uint32_t thread_num, uint32_t num_locks);
+
+void end_cna_array_local(cna_qnode** the_qnodes, uint32_t size);
+
+void end_cna_array_global(cna_global_params* the_locks, uint32_t size);
+/*
+   single lock manipulation
+   */
+
+int init_cna_global(cna_global_params* the_lock);
+
+int init_cna_local(uint32_t thread_num, cna_qnode** the_qnode);
+
+void end_cna_local(cna_qnode* the_qnodes);
+
+void end_cna_global(cna_global_params the_locks);
+
+/*
+ *  Acquire and release methods
+ */
+
+void cna_acquire(cna_lock *the_lock, cna_qnode_ptr I);
+
+void cna_release(cna_lock *the_lock, cna_qnode_ptr I);
+
+int is_free_cna(cna_lock *L );
+
+int cna_trylock(cna_lock *L, cna_qnode_ptr I);
+#endif
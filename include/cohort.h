@@ -0,0 +1,141 @@
+/*
+ * File: cohort.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Lock cohorting (Dice, Marathe, Shavit, PPoPP 2012): a global lock
+ *      shared by all sockets, and a local lock per socket; the lock is passed
+ *      within a socket up to a given number of times before the global
+ *      lock is released. Global locks: ttas with backoff (BO), ticket (TKT),
+ *      mcs with one queue node per socket (MCS); local locks: mcs, ticket.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COHORT_H_
+#define _COHORT_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#ifndef __sparc__
+#  ifndef __tile__
+#    include <numa.h>
+#  endif
+#endif
+#include <pthread.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+#include "ttas.h"
+#include "ticket.h"
+#include "mcs.h"
+
+//max number of consecutive hand-offs within a socket before releasing the global lock
+#ifndef COHORT_MAX_HANDOFFS
+#  define COHORT_MAX_HANDOFFS 64
+#endif
+
+//global lock types
+#define COHORT_GLOBAL_BO  0
+#define COHORT_GLOBAL_TKT 1
+#define COHORT_GLOBAL_MCS 2
+
+//local lock types
+#define COHORT_LOCAL_MCS 0
+#define COHORT_LOCAL_TKT 1
+
+//per socket part of a cohort lock
+typedef struct cohort_local {
+    union {
+        mcs_lock mcs;
+        ticketlock_t ticket;
+        uint8_t padding0[CACHE_LINE_SIZE];
+    };
+    //written by the owner of the local lock only
+    volatile uint32_t top_granted; //the global lock is passed along with the local one
+    uint32_t handoffs;             //consecutive local hand-offs
+    uint8_t padding1[CACHE_LINE_SIZE - 8];
+    //queue node of the socket in the global mcs lock
+    mcs_qnode global_qnode;
+} cohort_local_t;
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) cohort_lock {
+    union {
+        ttas_lock_t bo;
+        ticketlock_t ticket;
+        mcs_lock mcs;
+        uint8_t padding0[CACHE_LINE_SIZE];
+    } global;
+    cohort_local_t* local[MAX_SOCKETS];
+    uint32_t max_handoffs;
+    uint8_t global_type;
+    uint8_t local_type;
+} cohort_lock_t;
+
+//thread local parameters
+typedef struct cohort_local_params {
+    mcs_qnode* my_qnode; //node in the local mcs lock
+    uint32_t limit;      //backoff limit of the global ttas lock
+} cohort_local_params;
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+cohort_lock_t* init_cohort_array_global(uint32_t num_locks, uint8_t global_type, uint8_t local_type);
+
+cohort_local_params* init_cohort_array_local(uint32_t thread_num, uint32_t num_locks);
+
+void end_cohort_array_local(cohort_local_params* local_params, uint32_t size);
+
+void end_cohort_array_global(cohort_lock_t* the_locks, uint32_t size);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_cohort_global(cohort_lock_t* the_lock, uint8_t global_type, uint8_t local_type);
+
+int init_cohort_local(uint32_t thread_num, cohort_local_params* local_d);
+
+void end_cohort_local(cohort_local_params local_d);
+
+void end_cohort_global(cohort_lock_t the_lock);
+
+//changes the max number of consecutive hand-offs within a socket
+void cohort_set_max_handoffs(cohort_lock_t* the_lock, uint32_t max_handoffs);
+
+/*
+ *  Acquire and release methods
+ */
+
+void cohort_acquire(cohort_lock_t* the_lock, cohort_local_params* local_d);
+
+void cohort_release(cohort_lock_t* the_lock, cohort_local_params* local_d);
+
+//returns 0 on success, 1 otherwise
+int cohort_trylock(cohort_lock_t* the_lock, cohort_local_params* local_d);
+
+int is_free_cohort(cohort_lock_t* the_lock);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * File: elide.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Lock elision with Intel RTM, used by lock_if.h when LOCK_ELISION is
+ *      defined (make ELIDE=1). An acquire first starts a transaction and
+ *      only reads the lock, which must be free; the matching release
+ *      commits it. Critical sections that do not conflict then run in
+ *      parallel, and one that aborts ELIDE_RETRIES times takes the lock.
+ *      RTM is detected with cpuid when the first lock is initialized;
+ *      without it (or with LIBSLOCK_ELIDE=0) every acquire takes the lock.
+ *      Aborts are counted per thread and summed by elide_stats_flush.
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _ELIDE_H_
+#define _ELIDE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//transactions tried before taking the lock
+#ifndef ELIDE_RETRIES
+#  define ELIDE_RETRIES 3
+#endif
+#define ELIDE_ENV "LIBSLOCK_ELIDE"
+//locks elided at the same time by a thread; the next ones are taken
+#ifndef ELIDE_MAX_NESTED
+#  define ELIDE_MAX_NESTED 8
+#endif
+
+//_xbegin returns this when the transaction started
+#define ELIDE_STARTED (~0U)
+//abort status bits
+#define ELIDE_ABORT_EXPLICIT (1 << 0)
+#define ELIDE_ABORT_RETRY    (1 << 1)
+#define ELIDE_ABORT_CONFLICT (1 << 2)
+#define ELIDE_ABORT_CAPACITY (1 << 3)
+#define ELIDE_ABORT_CODE(s)  (((s) >> 24) & 0xff)
+//explicit abort code: the lock was held when the transaction started
+#define ELIDE_CODE_BUSY 0xff
+
+typedef struct elide_stats {
+    uint64_t attempts;  //transactions started
+    uint64_t commits;
+    uint64_t busy;      //aborted because the lock was held
+    uint64_t conflict;  //aborted by a conflicting access of another thread
+    uint64_t capacity;  //aborted because the footprint did not fit
+    uint64_t other;     //interrupts, system calls, unsupported instructions
+    uint64_t fallbacks; //acquires that took the lock
+} elide_stats_t;
+
+extern int elide_enabled;
+extern __thread elide_stats_t elide_stats;
+//locks elided by the thread, one nested transaction each; written inside the
+//transactions, so an abort also drops the locks it elided
+extern __thread void* elide_held_lock[ELIDE_MAX_NESTED];
+extern __thread uint32_t elide_held;
+
+//detects RTM (once) and reads LIBSLOCK_ELIDE
+void elide_init();
+//whether the cpu supports RTM
+int elide_rtm_supported();
+//adds the counters of the calling thread to the totals
+void elide_stats_flush();
+void elide_stats_get(elide_stats_t* totals);
+void elide_stats_print();
+
+#if defined(__x86_64__) || defined(__i386__)
+//the RTM instructions are emitted as bytes so that no -mrtm is needed
+static inline uint32_t elide_xbegin() {
+    uint32_t status = ELIDE_STARTED;
+    __asm__ __volatile__(".byte 0xc7,0xf8 ; .long 0" : "+a" (status) :: "memory");
+    return status;
+}
+
+static inline void elide_xend() {
+    __asm__ __volatile__(".byte 0x0f,0x01,0xd5" ::: "memory");
+}
+
+#  define elide_xabort(code) __asm__ __volatile__(".byte 0xc6,0xf8,%P0" :: "i" (code) : "memory")
+
+//whether the thread runs a transaction
+static inline int elide_xtest() {
+    uint8_t in_tx;
+    __asm__ __volatile__(".byte 0x0f,0x01,0xd6 ; setnz %0" : "=r" (in_tx) :: "memory");
+    return in_tx;
+}
+#else
+static inline uint32_t elide_xbegin() {
+    return 0;
+}
+
+static inline void elide_xend() {
+}
+
+#  define elide_xabort(code)
+
+static inline int elide_xtest() {
+    return 0;
+}
+#endif
+
+//counts an abort; returns 1 if another transaction is worth trying
+static inline int elide_aborted(uint32_t status) {
+    if ((status & ELIDE_ABORT_EXPLICIT) && ELIDE_ABORT_CODE(status) == ELIDE_CODE_BUSY) {
+        elide_stats.busy++;
+        return 1;
+    }
+    if (status & ELIDE_ABORT_CONFLICT) {
+        elide_stats.conflict++;
+    } else if (status & ELIDE_ABORT_CAPACITY) {
+        elide_stats.capacity++;
+    } else {
+        elide_stats.other++;
+    }
+    return (status & ELIDE_ABORT_RETRY) != 0;
+}
+
+//release hook: returns 1 if lock was elided by the thread, and ends its transaction
+//(the outermost one commits); any other lock, even one released inside a transaction,
+//takes the normal release, so the locks can be released in any order
+static inline int elide_release(void* lock) {
+    int i;
+    for (i = (int) elide_held - 1; i >= 0; i--) {
+        if (elide_held_lock[i] == lock) {
+            elide_held--;
+            elide_held_lock[i] = elide_held_lock[elide_held];
+            elide_xend();
+            elide_stats.commits++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -3,8 +3,14 @@
  * Author: Tudor David <tudor.david@epfl.ch>
  *
  * Description: 
- *      Implementation of a global read-write lock;
- *      Not used in any of the tests
+ *      Two-level read-write lock for data that is accessed both piecewise
+ *      (local operations, e.g. one account) and as a whole (global
+ *      operations, e.g. a snapshot of all accounts). A local operation only
+ *      counts itself in the partition of its thread, one cache line among
+ *      GL_PARTITIONS, and checks the global word; a global operation marks
+ *      the global word and drains the partitions it excludes. Local readers
+ *      exclude global writers; local writers exclude global readers and
+ *      writers; local operations do not exclude each other.
  *
  * The MIT License (MIT)
  *
@@ -28,9 +34,6 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-
-
-
 #ifndef _GLLOCK_H_
 #define _GLLOCK_H_
 
@@ -44,28 +47,33 @@
 #include "utils.h"
 #include "atomic_ops.h"
 
-typedef struct glock{
-    volatile unsigned char local_read;
-    volatile unsigned char local_write;
-    volatile unsigned char global_read;
-    volatile unsigned char global_write;
-} glock;
+//partitions of the local operations; a thread always uses the same one
+#ifndef GL_PARTITIONS
+#  define GL_PARTITIONS 64
+#endif
+
+//the global word: number of global readers, and a global writer
+#define GL_GLOBAL_READ_MASK 0x7fffffffU
+#define GL_GLOBAL_WRITE     0x80000000U
 
-typedef struct glock_2{
-    volatile unsigned short local_lock;
-    volatile unsigned short global_lock;
-} glock_2;
+typedef struct gl_partition {
+    volatile uint32_t local_read;
+    volatile uint32_t local_write;
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+} gl_partition;
 
+//all zero when free, so a static global_lock needs no initialization
 typedef struct global_lock {
     union {
         volatile unsigned int lock_data;
-        glock_2 lock_short;
-        glock lock;
         volatile unsigned char padding[CACHE_LINE_SIZE];
     };
+    gl_partition partitions[GL_PARTITIONS];
 } global_lock;
 
 
+void global_lock_init(global_lock* gl);
+
 void local_lock_write(global_lock* gl);
 
 void local_unlock_write(global_lock* gl);
@@ -68,16 +68,18 @@ typedef qnode_ptr global_queue;
 typedef struct hclh_global_params {
     global_queue* shared_queue;
     local_queue** local_queues;
-    volatile uint32_t* init_done;
 #ifdef ADD_PADDING
 #if CACHE_LINE_SIZE == 16
 #else
-    volatile uint8_t padding[CACHE_LINE_SIZE-20];
+    volatile uint8_t padding[CACHE_LINE_SIZE-16];
 #endif
 #endif
 
 } hclh_global_params;
 
+//cluster of the thread
+extern __thread uint32_t hclh_node_mine;
+
 //thread local parameters
 typedef struct hclh_local_params {
     qnode* my_qnode;
@@ -110,6 +112,9 @@ int init_hclh_global(hclh_global_params* the_lock);
 
 int init_hclh_local(uint32_t thread_num, hclh_global_params* the_params, hclh_local_params* local_d);
 
+//pins the thread and sets its cluster, without allocating any local data
+void init_hclh_thread(uint32_t thread_num);
+
 
 void end_hclh_local(hclh_local_params local_params);
 
@@ -127,4 +132,9 @@ qnode * hclh_release(qnode *my_qnode, qnode * my_pred);
 
 int is_free_hclh(local_queue *lq, global_queue *gq, qnode *my_qnode);
 
+//a waiter cannot leave the queues: the release recycles the node of the
+//predecessor, and the splicing of a local queue depends on the flags of its
+//tail; so there is no bounded acquire, and a call to this one does not build
+int hclh_acquire_timeout_unsupported() __attribute__((error("acquire_lock_timeout is not supported by the HCLH locks: a queued HCLH waiter cannot leave its queue")));
+
 #endif
@@ -0,0 +1,161 @@
+/*
+ * File: hmcs.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Hierarchical MCS lock (Chabbi, Fagan, Mellor-Crummey, PPoPP 2015):
+ *      a tree of MCS locks with one level per level of the topology (the
+ *      hardware threads of a core, the cores of a last level cache, the
+ *      cores of a socket, the machine). The holder of a level passes it to
+ *      the next waiter of its group, together with all the levels above,
+ *      up to the threshold of the level; then it releases the parent level.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _HMCS_H_
+#define _HMCS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//levels of the topology that may get a level of the lock; a level is only
+//kept if it groups the cpus of the level below and nests in the level above
+#define HMCS_LEVEL_SMT    0x1 //hardware threads of a core
+#define HMCS_LEVEL_LLC    0x2 //cores sharing the last level cache
+#define HMCS_LEVEL_SOCKET 0x4 //cores of a socket
+#ifndef HMCS_LEVELS
+#  define HMCS_LEVELS (HMCS_LEVEL_SMT | HMCS_LEVEL_LLC | HMCS_LEVEL_SOCKET)
+#endif
+
+//passes of a level inside its group before the parent level is released
+#ifndef HMCS_SMT_THRESHOLD
+#  define HMCS_SMT_THRESHOLD 8
+#endif
+#ifndef HMCS_LLC_THRESHOLD
+#  define HMCS_LLC_THRESHOLD 32
+#endif
+#ifndef HMCS_SOCKET_THRESHOLD
+#  define HMCS_SOCKET_THRESHOLD 64
+#endif
+
+//levels of the tree, the root included
+#define HMCS_MAX_LEVELS 4
+#define HMCS_MAX_CPUS 1024
+
+//values of the status of a queue node; below HMCS_ACQUIRE_PARENT, the number of passes in the group
+#define HMCS_WAIT           0xffffffffU
+#define HMCS_ACQUIRE_PARENT 0xfffffffeU
+#define HMCS_COHORT_START   1
+
+typedef struct hmcs_qnode {
+    struct hmcs_qnode* volatile next;
+    volatile uint32_t status;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 12];
+#endif
+} hmcs_qnode_t;
+
+//the MCS lock of a group of cpus at one level
+typedef struct hmcs_hnode {
+    hmcs_qnode_t* volatile tail;
+    struct hmcs_hnode* parent; //NULL for the root
+    uint32_t threshold;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 20];
+#endif
+    hmcs_qnode_t node; //queue node of the group in the parent level
+} hmcs_hnode_t;
+
+typedef struct hmcs_lock {
+    hmcs_hnode_t* hnodes; //the groups of all the levels, leaves first; the last one is the root
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+#endif
+} hmcs_lock_t;
+
+typedef hmcs_qnode_t* hmcs_local_params;
+
+//the levels derived from the topology, shared by all the hmcs locks
+typedef struct hmcs_levels {
+    uint32_t num_levels;                 //the root included
+    uint32_t kind[HMCS_MAX_LEVELS];      //HMCS_LEVEL_*, 0 for the root
+    uint32_t groups[HMCS_MAX_LEVELS];    //groups of each level
+    uint32_t offset[HMCS_MAX_LEVELS];    //index of the first hnode of each level
+    uint32_t threshold[HMCS_MAX_LEVELS];
+    uint32_t num_hnodes;                 //hnodes of a lock
+    uint16_t parent[HMCS_MAX_CPUS * HMCS_MAX_LEVELS]; //hnode of the parent of each hnode
+} hmcs_levels_t;
+
+extern hmcs_levels_t hmcs_levels;
+
+//computes the levels on the first call
+void hmcs_levels_init();
+
+void hmcs_levels_print(FILE* f);
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+hmcs_lock_t* init_hmcs_array_global(uint32_t num_locks);
+
+hmcs_local_params* init_hmcs_array_local(uint32_t thread_num, uint32_t num_locks);
+
+void end_hmcs_array_local(hmcs_local_params* local_params, uint32_t size);
+
+void end_hmcs_array_global(hmcs_lock_t* the_locks, uint32_t size);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_hmcs_global(hmcs_lock_t* the_lock);
+
+int init_hmcs_local(uint32_t thread_num, hmcs_local_params* local_d);
+
+void end_hmcs_local(hmcs_local_params local_d);
+
+void end_hmcs_global(hmcs_lock_t the_lock);
+
+//changes the threshold of a level (0 is the leaves) of a lock
+void hmcs_set_threshold(hmcs_lock_t* the_lock, uint32_t level, uint32_t threshold);
+
+/*
+ *  Acquire and release methods
+ */
+
+void hmcs_acquire(hmcs_lock_t* the_lock, hmcs_qnode_t* I);
+
+void hmcs_release(hmcs_lock_t* the_lock, hmcs_qnode_t* I);
+
+//returns 0 on success, 1 otherwise
+int hmcs_trylock(hmcs_lock_t* the_lock, hmcs_qnode_t* I);
+
+int is_free_hmcs(hmcs_lock_t* the_lock);
+
+#endif
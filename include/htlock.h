@@ -76,7 +76,7 @@ typedef struct htlock_local
 typedef struct ALIGNED(CACHE_LINE_SIZE) htlock
 {
     htlock_global_t* global;
-    htlock_local_t* local[NUMBER_OF_SOCKETS];
+    htlock_local_t* local[MAX_SOCKETS];
 } htlock_t;
 
 extern int create_htlock(htlock_t* htl);
@@ -0,0 +1,132 @@
+/*
+ * File: latency_hist.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Log-linear latency histograms (in the style of HdrHistogram): values
+ *      below LAT_HIST_SUB are counted exactly, larger ones in
+ *      LAT_HIST_SUB / 2 buckets per power of two, i.e. with a relative
+ *      error below 2 / LAT_HIST_SUB. Recording is a few instructions and
+ *      touches one counter; a histogram is meant to be owned by one thread
+ *      and merged with the others at the end.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define LAT_HIST_SUB_BITS 6
+#define LAT_HIST_SUB (1 << LAT_HIST_SUB_BITS)
+#define LAT_HIST_HALF (LAT_HIST_SUB / 2)
+#define LAT_HIST_BUCKETS ((64 - LAT_HIST_SUB_BITS + 2) * LAT_HIST_HALF)
+
+typedef struct lat_hist {
+    uint64_t count;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t counts[LAT_HIST_BUCKETS];
+} lat_hist_t;
+
+static inline void lat_hist_init(lat_hist_t* h) {
+    memset(h, 0, sizeof(lat_hist_t));
+}
+
+static inline uint32_t lat_hist_index(uint64_t v) {
+    if (v < LAT_HIST_SUB) {
+        return (uint32_t) v;
+    }
+    uint32_t shift = 63 - __builtin_clzll(v) - LAT_HIST_SUB_BITS + 1;
+    return shift * LAT_HIST_HALF + (uint32_t) (v >> shift);
+}
+
+//highest value counted in bucket i
+static inline uint64_t lat_hist_value(uint32_t i) {
+    if (i < LAT_HIST_SUB) {
+        return i;
+    }
+    uint32_t shift = i / LAT_HIST_HALF - 1;
+    uint64_t sub = i - shift * LAT_HIST_HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+static inline void lat_hist_record(lat_hist_t* h, uint64_t v) {
+    h->counts[lat_hist_index(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v > h->max) {
+        h->max = v;
+    }
+}
+
+static inline void lat_hist_merge(lat_hist_t* into, lat_hist_t* from) {
+    uint32_t i;
+    for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+//value below which a fraction p (0 < p <= 1) of the recorded values are
+static inline uint64_t lat_hist_percentile(lat_hist_t* h, double p) {
+    if (h->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) (p * h->count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    uint32_t i;
+    for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = lat_hist_value(i);
+            return (v < h->max) ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+//one line: name, count, mean and the usual percentiles
+static inline void lat_hist_print(const char* name, lat_hist_t* h) {
+    printf("%-8s n=%-10llu avg=%-8llu p50=%-8llu p90=%-8llu p99=%-8llu p99.9=%-8llu p99.99=%-8llu max=%llu\n",
+            name, (unsigned long long) h->count,
+            (unsigned long long) (h->count ? h->sum / h->count : 0),
+            (unsigned long long) lat_hist_percentile(h, 0.50),
+            (unsigned long long) lat_hist_percentile(h, 0.90),
+            (unsigned long long) lat_hist_percentile(h, 0.99),
+            (unsigned long long) lat_hist_percentile(h, 0.999),
+            (unsigned long long) lat_hist_percentile(h, 0.9999),
+            (unsigned long long) h->max);
+}
+
+#endif
@@ -28,7 +28,47 @@
  */
 
 
+//the cohort lock variants: global lock type and local lock type
+#if defined(USE_COHORT_BO_MCS_LOCKS)
+#  define USE_COHORT_LOCKS
+#  define COHORT_GLOBAL_TYPE COHORT_GLOBAL_BO
+#  define COHORT_LOCAL_TYPE COHORT_LOCAL_MCS
+#elif defined(USE_COHORT_TKT_TKT_LOCKS)
+#  define USE_COHORT_LOCKS
+#  define COHORT_GLOBAL_TYPE COHORT_GLOBAL_TKT
+#  define COHORT_LOCAL_TYPE COHORT_LOCAL_TKT
+#elif defined(USE_COHORT_MCS_MCS_LOCKS)
+#  define USE_COHORT_LOCKS
+#  define COHORT_GLOBAL_TYPE COHORT_GLOBAL_MCS
+#  define COHORT_LOCAL_TYPE COHORT_LOCAL_MCS
+#endif
+
+//with QNODE_POOL the queue locks take their nodes from a per-thread pool
+//(qnode_pool.h) instead of keeping local data for every lock
+#if defined(QNODE_POOL)
+#  if defined(USE_MCS_LOCKS)
+#    undef USE_MCS_LOCKS
+#    define USE_POOLED_LOCKS
+#    define POOLED_MCS
+#  elif defined(USE_CLH_LOCKS)
+#    undef USE_CLH_LOCKS
+#    define USE_POOLED_LOCKS
+#    define POOLED_CLH
+#  elif defined(USE_HCLH_LOCKS)
+#    undef USE_HCLH_LOCKS
+#    define USE_POOLED_LOCKS
+#    define POOLED_HCLH
+#  elif defined(USE_ARRAY_LOCKS)
+#    undef USE_ARRAY_LOCKS
+#    define USE_POOLED_LOCKS
+#    define POOLED_ARRAY
+#  endif
+#endif
 
+//HCLH waiters cannot leave their queue: acquire_lock_timeout does not build with these locks
+#if defined(USE_HCLH_LOCKS) || defined(POOLED_HCLH)
+#  define LOCK_NO_TIMEOUT
+#endif
 
 #ifdef USE_MCS_LOCKS
 #include "mcs.h"
@@ -48,12 +88,48 @@
 #include "ticket.h"
 #elif defined(USE_MUTEX_LOCKS)
 #include <pthread.h>
+#include "utils.h"
 #elif defined(USE_HTICKET_LOCKS)
 #include "htlock.h"
+#elif defined(USE_RW_NUMA_LOCKS)
+#include "rw_numa.h"
+#elif defined(USE_QSPIN_LOCKS)
+#include "qspin.h"
+#elif defined(USE_SHFL_LOCKS)
+#include "shfl.h"
+#elif defined(USE_ARRAY_DYN_LOCKS)
+#include "alock_dyn.h"
+#elif defined(USE_POOLED_LOCKS)
+#include "qnode_pool.h"
+#elif defined(USE_HMCS_LOCKS)
+#include "hmcs.h"
+#elif defined(USE_CNA_LOCKS)
+#include "cna.h"
+#elif defined(USE_COHORT_LOCKS)
+#include "cohort.h"
+#elif defined(USE_RUNTIME_LOCKS)
+#include "lock_rt.h"
 #else
 #error "No type of locks given"
 #endif
 
+#ifdef LOCK_STATS
+#include "lock_stats.h"
+#endif
+
+#ifdef READER_BIAS
+#include "bravo.h"
+#endif
+
+#ifdef LOCK_ELISION
+#  ifdef READER_BIAS
+#    error "an elided writer would not revoke the reader bias: ELIDE=1 and BRAVO=1 cannot be combined"
+#  endif
+#include "elide.h"
+#endif
+
+#include "seqlock.h"
+
 //lock globals
 #ifdef USE_MCS_LOCKS
 typedef mcs_global_params lock_global_data;
@@ -75,6 +151,24 @@ typedef ticketlock_t lock_global_data;
 typedef pthread_mutex_t lock_global_data;
 #elif defined(USE_HTICKET_LOCKS)
 typedef htlock_t lock_global_data;
+#elif defined(USE_RW_NUMA_LOCKS)
+typedef rw_numa_lock_t lock_global_data;
+#elif defined(USE_QSPIN_LOCKS)
+typedef qspin_lock_t lock_global_data;
+#elif defined(USE_SHFL_LOCKS)
+typedef shfl_lock_t lock_global_data;
+#elif defined(USE_ARRAY_DYN_LOCKS)
+typedef alock_dyn_lock_t lock_global_data;
+#elif defined(USE_POOLED_LOCKS)
+typedef qpool_global_t lock_global_data;
+#elif defined(USE_HMCS_LOCKS)
+typedef hmcs_lock_t lock_global_data;
+#elif defined(USE_CNA_LOCKS)
+typedef cna_global_params lock_global_data;
+#elif defined(USE_COHORT_LOCKS)
+typedef cohort_lock_t lock_global_data;
+#elif defined(USE_RUNTIME_LOCKS)
+typedef rt_global_params lock_global_data;
 #endif
 
 typedef lock_global_data* global_data;
@@ -101,6 +195,24 @@ typedef void* lock_local_data;//no local data for ticket locks
 typedef void* lock_local_data;//no local data for mutexes
 #elif defined(USE_HTICKET_LOCKS)
 typedef void* lock_local_data;//no local data for hticket locks
+#elif defined(USE_RW_NUMA_LOCKS)
+typedef rw_numa_local_params lock_local_data;
+#elif defined(USE_QSPIN_LOCKS)
+typedef void* lock_local_data;//no local data for qspin locks
+#elif defined(USE_SHFL_LOCKS)
+typedef void* lock_local_data;//no local data for shfl locks
+#elif defined(USE_ARRAY_DYN_LOCKS)
+typedef void* lock_local_data;//no local data for dynamic array locks
+#elif defined(USE_POOLED_LOCKS)
+typedef void* lock_local_data;//no local data: the nodes come from the pool of the thread
+#elif defined(USE_HMCS_LOCKS)
+typedef hmcs_local_params lock_local_data;
+#elif defined(USE_CNA_LOCKS)
+typedef cna_local_params lock_local_data;
+#elif defined(USE_COHORT_LOCKS)
+typedef cohort_local_params lock_local_data;
+#elif defined(USE_RUNTIME_LOCKS)
+typedef rt_local_params lock_local_data;
 #endif
 
 typedef lock_local_data* local_data;
@@ -121,6 +233,10 @@ static inline void acquire_write(lock_local_data* local_d, lock_global_data* glo
 //trylock
 static inline int acquire_trylock(lock_local_data* local_d, lock_global_data* global_d);
 
+//acquire that gives up after timeout cycles; return 0 on success, 1 otherwise;
+//a lock acquired this way is released with release_trylock
+static inline int acquire_lock_timeout(lock_local_data* local_d, lock_global_data* global_d, ticks timeout);
+
 //lock release operation
 //cluster_id is the cluster number of the core requesting the operation;
 //e.g. the socket in the case of the Opteron
@@ -134,6 +250,12 @@ static inline void release_read(lock_local_data* local_d, lock_global_data* glob
 //release writer lock
 static inline void release_write(lock_local_data* local_d, lock_global_data* global_d);
 
+//writer of the data protected by seq: the lock serializes the writers, the readers
+//only use seqlock_read_begin/seqlock_read_retry
+static inline void acquire_seq_write(lock_local_data* local_d, lock_global_data* global_d, seqlock_t* seq);
+
+static inline void release_seq_write(lock_local_data* local_d, lock_global_data* global_d, seqlock_t* seq);
+
 //initialization of local data for an array of locks; core_to_pin is the core on which the thread is execting, 
 static inline local_data init_lock_array_local(int core_to_pin, int num_locks, global_data the_locks);
 
@@ -162,7 +284,110 @@ static inline void free_lock_local(lock_local_data local_d);
 /*
  *  Functions
  */
+
+#if defined(LOCK_STATS) || defined(LOCK_ELISION)
+//number of threads holding or waiting for the lock; exact for the ticket locks, 0 or 1 for the others
+static inline uint32_t lock_queue_length(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef USE_MCS_LOCKS
+    return !is_free_mcs(global_d->the_lock);
+#elif defined(USE_HCLH_LOCKS)
+    return !is_free_hclh(local_d->my_queue, global_d->shared_queue, local_d->my_qnode);
+#elif defined(USE_TTAS_LOCKS)
+    return !is_free_ttas(global_d);
+#elif defined(USE_SPINLOCK_LOCKS)
+    return !is_free_spinlock(global_d);
+#elif defined(USE_ARRAY_LOCKS)
+    return !is_free_alock(global_d);
+#elif defined(USE_CLH_LOCKS)
+    return (*global_d->the_lock)->locked != 0;
+#elif defined(USE_RW_LOCKS)
+    return !is_free_rw(global_d);
+#elif defined(USE_TICKET_LOCKS)
+    return global_d->tail - global_d->head + 1;
+#elif defined(USE_MUTEX_LOCKS)
+#  ifdef __GLIBC__
+    return global_d->__data.__lock != 0;
+#  else
+    return 0;
+#  endif
+#elif defined(USE_HTICKET_LOCKS)
+    return !is_free_hticket(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    return !is_free_rw_numa(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    return qspin_queue_length(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    return shfl_queue_length(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    return alock_dyn_queue_length(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    return qpool_queue_length(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    return !is_free_hmcs(global_d);
+#elif defined(USE_CNA_LOCKS)
+    return !is_free_cna(global_d->the_lock);
+#elif defined(USE_COHORT_LOCKS)
+    return !is_free_cohort(global_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    return lock_rt.queue_length(local_d, global_d->the_lock);
+#endif
+}
+
+//whether readers exclude each other
+static inline int lock_read_exclusive() {
+#if defined(USE_RW_LOCKS) || defined(USE_RW_NUMA_LOCKS)
+    return 0;
+#elif defined(USE_RUNTIME_LOCKS)
+    return lock_rt.acquire_read == lock_rt.acquire;
+#else
+    return 1;
+#endif
+}
+#endif
+
+#ifdef LOCK_ELISION
+//tries to run the critical section as a transaction; returns 1 if it started,
+//0 if the lock has to be taken; with wait unset, gives up as soon as the lock is held
+static inline int lock_elide(lock_local_data* local_d, lock_global_data* global_d, int wait) {
+    if (!elide_enabled) {
+        return 0;
+    }
+    uint32_t tries;
+    for (tries = 0; tries < ELIDE_RETRIES && elide_held < ELIDE_MAX_NESTED; tries++) {
+        elide_stats.attempts++;
+        uint32_t status = elide_xbegin();
+        if (status == ELIDE_STARTED) {
+            //the lock is now in the read set: taking it aborts the transaction
+            if (lock_queue_length(local_d, global_d) == 0) {
+                //only the release of this lock ends the transaction (elide_release)
+                elide_held_lock[elide_held++] = global_d;
+                return 1;
+            }
+            elide_xabort(ELIDE_CODE_BUSY);
+        }
+        if (!elide_aborted(status) || (!wait && lock_queue_length(local_d, global_d) != 0)) {
+            break;
+        }
+        //wait for the holder instead of aborting on the lock again
+        while (lock_queue_length(local_d, global_d) != 0) {
+            PAUSE;
+        }
+    }
+    elide_stats.fallbacks++;
+    return 0;
+}
+#endif
+
 static inline void acquire_lock(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef LOCK_ELISION
+    if (lock_elide(local_d, global_d, 1)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    ticks stats_start = getticks();
+    uint32_t stats_queue = lock_queue_length(local_d, global_d);
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_acquire(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -183,9 +408,42 @@ static inline void acquire_lock(lock_local_data* local_d, lock_global_data* glob
     pthread_mutex_lock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_lock(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_write_acquire(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_acquire(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_acquire(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_acquire(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_acquire(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_acquire(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_acquire(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_acquire(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.acquire(local_d, global_d->the_lock);
+#endif
+#ifdef READER_BIAS
+    bravo_write_acquired(global_d);
+#endif
+#ifdef LOCK_STATS
+    lock_stats_acquired(global_d, stats_start, stats_queue, 1);
 #endif
 }
 static inline void acquire_write(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef LOCK_ELISION
+    if (lock_elide(local_d, global_d, 1)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    ticks stats_start = getticks();
+    uint32_t stats_queue = lock_queue_length(local_d, global_d);
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_acquire(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -206,10 +464,51 @@ static inline void acquire_write(lock_local_data* local_d, lock_global_data* glo
     pthread_mutex_lock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_lock(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_write_acquire(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_acquire(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_acquire(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_acquire(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_acquire(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_acquire(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_acquire(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_acquire(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.acquire(local_d, global_d->the_lock);
+#endif
+#ifdef READER_BIAS
+    bravo_write_acquired(global_d);
+#endif
+#ifdef LOCK_STATS
+    lock_stats_acquired(global_d, stats_start, stats_queue, 1);
 #endif
 }
 
 static inline void acquire_read(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef LOCK_ELISION
+    if (lock_elide(local_d, global_d, 1)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    ticks stats_start = getticks();
+    uint32_t stats_queue = lock_queue_length(local_d, global_d);
+#endif
+#ifdef READER_BIAS
+    if (bravo_read_fast(global_d)) {
+#  ifdef LOCK_STATS
+        lock_stats_acquired(global_d, stats_start, 0, 0);
+#  endif
+        return;
+    }
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_acquire(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -230,11 +529,43 @@ static inline void acquire_read(lock_local_data* local_d, lock_global_data* glob
     pthread_mutex_lock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_lock(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_read_acquire(global_d, local_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_acquire(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_acquire(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_acquire(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_acquire(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_acquire(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_acquire(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_acquire(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.acquire_read(local_d, global_d->the_lock);
+#endif
+#ifdef READER_BIAS
+    bravo_read_slow(global_d);
+#endif
+#ifdef LOCK_STATS
+    lock_stats_acquired(global_d, stats_start, stats_queue, lock_read_exclusive());
 #endif
 }
 
 
 static inline void release_lock(lock_local_data *local_d, lock_global_data *global_d) {
+#ifdef LOCK_ELISION
+    if (elide_release(global_d)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    lock_stats_release(global_d);
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_release(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -255,11 +586,37 @@ static inline void release_lock(lock_local_data *local_d, lock_global_data *glob
     pthread_mutex_unlock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_release(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_write_release(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_release(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_release(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_release(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_release(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_release(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_release(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_release(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.release(local_d, global_d->the_lock);
 #endif
 
 }
 
 static inline void release_write(lock_local_data *local_d, lock_global_data *global_d) {
+#ifdef LOCK_ELISION
+    if (elide_release(global_d)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    lock_stats_release(global_d);
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_release(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -280,11 +637,44 @@ static inline void release_write(lock_local_data *local_d, lock_global_data *glo
     pthread_mutex_unlock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_release(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_write_release(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_release(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_release(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_release(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_release(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_release(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_release(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_release(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.release(local_d, global_d->the_lock);
 #endif
 
 }
 
 static inline void release_read(lock_local_data *local_d, lock_global_data *global_d) {
+#ifdef LOCK_ELISION
+    if (elide_release(global_d)) {
+        return;
+    }
+#endif
+#ifdef READER_BIAS
+    if (bravo_read_release(global_d)) {
+        return;
+    }
+#endif
+#ifdef LOCK_STATS
+    if (lock_read_exclusive()) {
+        lock_stats_release(global_d);
+    }
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_release(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -305,6 +695,24 @@ static inline void release_read(lock_local_data *local_d, lock_global_data *glob
     pthread_mutex_unlock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_release(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_read_release(global_d, local_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_release(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_release(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_release(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_release(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_release(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_release(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_release(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.release_read(local_d, global_d->the_lock);
 #endif
 
 }
@@ -313,6 +721,9 @@ static inline void release_read(lock_local_data *local_d, lock_global_data *glob
 static inline void set_cpu(int);
 
 static inline local_data init_lock_array_local(int core_to_pin, int num_locks, global_data the_locks){
+#ifdef LOCK_STATS
+    lock_stats_thread_init(core_to_pin);
+#endif
 #ifdef USE_MCS_LOCKS
     return init_mcs_array_local(core_to_pin, num_locks);
 #elif defined(USE_HCLH_LOCKS)
@@ -337,10 +748,35 @@ static inline local_data init_lock_array_local(int core_to_pin, int num_locks, g
 #elif defined(USE_HTICKET_LOCKS)
     init_thread_htlocks(core_to_pin);
     return NULL;
+#elif defined(USE_RW_NUMA_LOCKS)
+    return init_rw_numa_array_local(core_to_pin, num_locks);
+#elif defined(USE_QSPIN_LOCKS)
+    init_qspin_array_local(core_to_pin);
+    return NULL;
+#elif defined(USE_SHFL_LOCKS)
+    init_shfl_array_local(core_to_pin);
+    return NULL;
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    init_alock_dyn_array_local(core_to_pin);
+    return NULL;
+#elif defined(USE_POOLED_LOCKS)
+    qpool_thread_init(core_to_pin);
+    return NULL;
+#elif defined(USE_HMCS_LOCKS)
+    return init_hmcs_array_local(core_to_pin, num_locks);
+#elif defined(USE_CNA_LOCKS)
+    return init_cna_array_local(core_to_pin, num_locks);
+#elif defined(USE_COHORT_LOCKS)
+    return init_cohort_array_local(core_to_pin, num_locks);
+#elif defined(USE_RUNTIME_LOCKS)
+    return init_rt_array_local(core_to_pin, num_locks, the_locks);
 #endif
 }
 
 static inline int init_lock_local(int core_to_pin,  lock_global_data* the_lock, lock_local_data* local_data){
+#ifdef LOCK_STATS
+    lock_stats_thread_init(core_to_pin);
+#endif
 #ifdef USE_MCS_LOCKS
     return init_mcs_local(core_to_pin, local_data);
 #elif defined(USE_HCLH_LOCKS)
@@ -365,10 +801,35 @@ static inline int init_lock_local(int core_to_pin,  lock_global_data* the_lock,
 #elif defined(USE_HTICKET_LOCKS)
     init_thread_htlocks(core_to_pin);
     return 0;
+#elif defined(USE_RW_NUMA_LOCKS)
+    return init_rw_numa_local(core_to_pin, local_data);
+#elif defined(USE_QSPIN_LOCKS)
+    init_qspin_local(core_to_pin);
+    return 0;
+#elif defined(USE_SHFL_LOCKS)
+    init_shfl_local(core_to_pin);
+    return 0;
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    init_alock_dyn_local(core_to_pin);
+    return 0;
+#elif defined(USE_POOLED_LOCKS)
+    qpool_thread_init(core_to_pin);
+    return 0;
+#elif defined(USE_HMCS_LOCKS)
+    return init_hmcs_local(core_to_pin, local_data);
+#elif defined(USE_CNA_LOCKS)
+    return init_cna_local(core_to_pin, local_data);
+#elif defined(USE_COHORT_LOCKS)
+    return init_cohort_local(core_to_pin, local_data);
+#elif defined(USE_RUNTIME_LOCKS)
+    return init_rt_local(core_to_pin, the_lock, local_data);
 #endif
 }
 
 static inline void free_lock_local(lock_local_data local_d){
+#ifdef LOCK_ELISION
+    elide_stats_flush();
+#endif
 #ifdef USE_MCS_LOCKS
     end_mcs_local(local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -389,10 +850,31 @@ static inline void free_lock_local(lock_local_data local_d){
     //nothing to be done
 #elif defined(USE_HTICKET_LOCKS)
     //nothing to be done
+#elif defined(USE_RW_NUMA_LOCKS)
+    end_rw_numa_local(local_d);
+#elif defined(USE_QSPIN_LOCKS)
+    end_qspin_local();
+#elif defined(USE_SHFL_LOCKS)
+    end_shfl_local();
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    //nothing to be done
+#elif defined(USE_POOLED_LOCKS)
+    //nothing to be done
+#elif defined(USE_HMCS_LOCKS)
+    end_hmcs_local(local_d);
+#elif defined(USE_CNA_LOCKS)
+    end_cna_local(local_d);
+#elif defined(USE_COHORT_LOCKS)
+    end_cohort_local(local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    end_rt_local(local_d);
 #endif
 }
 
 static inline void free_lock_array_local(local_data local_d, int num_locks){
+#ifdef LOCK_ELISION
+    elide_stats_flush();
+#endif
 #ifdef USE_MCS_LOCKS
     end_mcs_array_local(local_d,num_locks);
 #elif defined(USE_HCLH_LOCKS)
@@ -413,10 +895,29 @@ static inline void free_lock_array_local(local_data local_d, int num_locks){
     //nothing to be done
 #elif defined(USE_HTICKET_LOCKS)
     //nothing to be done
+#elif defined(USE_RW_NUMA_LOCKS)
+    end_rw_numa_array_local(local_d);
+#elif defined(USE_QSPIN_LOCKS)
+    end_qspin_array_local();
+#elif defined(USE_SHFL_LOCKS)
+    end_shfl_array_local();
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    //nothing to be done
+#elif defined(USE_POOLED_LOCKS)
+    //nothing to be done
+#elif defined(USE_HMCS_LOCKS)
+    end_hmcs_array_local(local_d,num_locks);
+#elif defined(USE_CNA_LOCKS)
+    end_cna_array_local(local_d,num_locks);
+#elif defined(USE_COHORT_LOCKS)
+    end_cohort_array_local(local_d, num_locks);
+#elif defined(USE_RUNTIME_LOCKS)
+    end_rt_array_local(local_d, num_locks);
 #endif
 }
 
-static inline global_data init_lock_array_global(int num_locks, int num_threads){
+//array of locks of the selected algorithm, without the reader bias
+static inline global_data lock_init_array_global_impl(int num_locks, int num_threads){
 #ifdef USE_MCS_LOCKS
     return init_mcs_array_global(num_locks);
 #elif defined(USE_HCLH_LOCKS)
@@ -443,10 +944,45 @@ static inline global_data init_lock_array_global(int num_locks, int num_threads)
     return the_locks;
 #elif defined(USE_HTICKET_LOCKS)
     return init_htlocks(num_locks);
+#elif defined(USE_RW_NUMA_LOCKS)
+    return init_rw_numa_array_global(num_locks);
+#elif defined(USE_QSPIN_LOCKS)
+    return init_qspin_array_global(num_locks);
+#elif defined(USE_SHFL_LOCKS)
+    return init_shfl_array_global(num_locks);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    return init_alock_dyn_array_global(num_locks);
+#elif defined(USE_POOLED_LOCKS)
+    return qpool_init_array_global(num_locks, num_threads);
+#elif defined(USE_HMCS_LOCKS)
+    return init_hmcs_array_global(num_locks);
+#elif defined(USE_CNA_LOCKS)
+    return init_cna_array_global(num_locks);
+#elif defined(USE_COHORT_LOCKS)
+    return init_cohort_array_global(num_locks, COHORT_GLOBAL_TYPE, COHORT_LOCAL_TYPE);
+#elif defined(USE_RUNTIME_LOCKS)
+    return init_rt_array_global(num_locks, num_threads);
 #endif
 }
 
+static inline global_data init_lock_array_global(int num_locks, int num_threads){
+#ifdef LOCK_ELISION
+    elide_init();
+#endif
+    global_data the_locks = lock_init_array_global_impl(num_locks, num_threads);
+#ifdef READER_BIAS
+    bravo_locks_reset(the_locks, sizeof(lock_global_data), num_locks);
+#endif
+    return the_locks;
+}
+
 static inline int init_lock_global(lock_global_data* the_lock){
+#ifdef LOCK_ELISION
+    elide_init();
+#endif
+#ifdef READER_BIAS
+    bravo_locks_reset(the_lock, sizeof(lock_global_data), 1);
+#endif
 #ifdef USE_MCS_LOCKS
     return init_mcs_global(the_lock);
 #elif defined(USE_HCLH_LOCKS)
@@ -469,18 +1005,54 @@ static inline int init_lock_global(lock_global_data* the_lock){
     return 0;
 #elif defined(USE_HTICKET_LOCKS)
     return create_htlock(the_lock);
+#elif defined(USE_RW_NUMA_LOCKS)
+    return init_rw_numa_global(the_lock);
+#elif defined(USE_QSPIN_LOCKS)
+    return init_qspin_global(the_lock);
+#elif defined(USE_SHFL_LOCKS)
+    return init_shfl_global(the_lock);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    return init_alock_dyn_global(the_lock);
+#elif defined(USE_POOLED_LOCKS)
+#  ifdef POOLED_ARRAY
+    perror("operation not suported for array locks; use init_lock_global_nt instead");
+    return 1;
+#  else
+    return qpool_init_global(1, the_lock);
+#  endif
+#elif defined(USE_HMCS_LOCKS)
+    return init_hmcs_global(the_lock);
+#elif defined(USE_CNA_LOCKS)
+    return init_cna_global(the_lock);
+#elif defined(USE_COHORT_LOCKS)
+    return init_cohort_global(the_lock, COHORT_GLOBAL_TYPE, COHORT_LOCAL_TYPE);
+#elif defined(USE_RUNTIME_LOCKS)
+    return init_rt_global(0, the_lock);
 #endif
 }
 
 static inline int init_lock_global_nt(int num_threads, lock_global_data* the_lock) {
+#ifdef LOCK_ELISION
+    elide_init();
+#endif
+#ifdef READER_BIAS
+    bravo_locks_reset(the_lock, sizeof(lock_global_data), 1);
+#endif
     #ifdef USE_ARRAY_LOCKS
         return init_alock_global(num_threads, the_lock);
+    #elif defined(USE_POOLED_LOCKS)
+        return qpool_init_global(num_threads, the_lock);
+    #elif defined(USE_RUNTIME_LOCKS)
+        return init_rt_global(num_threads, the_lock);
     #else 
         return init_lock_global(the_lock);
     #endif
 }
 
 static inline void free_lock_array_global(global_data the_locks, int num_locks) {
+#ifdef READER_BIAS
+    bravo_locks_reset(the_locks, sizeof(lock_global_data), num_locks);
+#endif
 #ifdef USE_MCS_LOCKS
     end_mcs_array_global(the_locks, num_locks);
 #elif defined(USE_HCLH_LOCKS)
@@ -504,9 +1076,29 @@ static inline void free_lock_array_global(global_data the_locks, int num_locks)
     }
 #elif defined(USE_HTICKET_LOCKS)
     free_htlocks(the_locks);
+#elif defined(USE_RW_NUMA_LOCKS)
+    end_rw_numa_array_global(the_locks);
+#elif defined(USE_QSPIN_LOCKS)
+    end_qspin_array_global(the_locks);
+#elif defined(USE_SHFL_LOCKS)
+    end_shfl_array_global(the_locks);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    end_alock_dyn_array_global(the_locks, num_locks);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_end_array_global(the_locks, num_locks);
+#elif defined(USE_HMCS_LOCKS)
+    end_hmcs_array_global(the_locks, num_locks);
+#elif defined(USE_CNA_LOCKS)
+    end_cna_array_global(the_locks, num_locks);
+#elif defined(USE_COHORT_LOCKS)
+    end_cohort_array_global(the_locks, num_locks);
+#elif defined(USE_RUNTIME_LOCKS)
+    end_rt_array_global(the_locks, num_locks);
 #endif
 }
 
+//the_lock is a copy: with READER_BIAS, the entry of the lock is dropped when
+//another lock is initialized at its address, or with bravo_locks_reset
 static inline void free_lock_global(lock_global_data the_lock) {
 #ifdef USE_MCS_LOCKS
     end_mcs_global(the_lock);
@@ -528,6 +1120,24 @@ static inline void free_lock_global(lock_global_data the_lock) {
     pthread_mutex_destroy(&the_lock);
 #elif defined(USE_HTICKET_LOCKS)
     //
+#elif defined(USE_RW_NUMA_LOCKS)
+    end_rw_numa_global(the_lock);
+#elif defined(USE_QSPIN_LOCKS)
+    end_qspin_global(the_lock);
+#elif defined(USE_SHFL_LOCKS)
+    end_shfl_global(the_lock);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    end_alock_dyn_global(the_lock);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_end_global(&the_lock);
+#elif defined(USE_HMCS_LOCKS)
+    end_hmcs_global(the_lock);
+#elif defined(USE_CNA_LOCKS)
+    end_cna_global(the_lock);
+#elif defined(USE_COHORT_LOCKS)
+    end_cohort_global(the_lock);
+#elif defined(USE_RUNTIME_LOCKS)
+    end_rt_global(the_lock);
 #endif
 }
 
@@ -535,7 +1145,8 @@ static inline void free_lock_global(lock_global_data the_lock) {
 //checks whether the lock is free; if it is, acquire it;
 //we use this in memcached to simulate trylocks
 //return 0 on success, 1 otherwise
-static inline int acquire_trylock( lock_local_data* local_d, lock_global_data* global_d) {
+//trylock of the selected algorithm, without the reader bias
+static inline int lock_trylock_impl(lock_local_data* local_d, lock_global_data* global_d) {
 #ifdef USE_MCS_LOCKS
     return mcs_trylock(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -565,10 +1176,33 @@ static inline int acquire_trylock( lock_local_data* local_d, lock_global_data* g
 #elif defined(USE_HTICKET_LOCKS)
     if (htlock_trylock(global_d)) return 0;
     return 1;
+#elif defined(USE_RW_NUMA_LOCKS)
+    return rw_numa_write_trylock(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    return qspin_trylock(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    return shfl_trylock(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    return alock_dyn_trylock(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    return qpool_trylock(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    return hmcs_trylock(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    return cna_trylock(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    return cohort_trylock(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    return lock_rt.trylock(local_d, global_d->the_lock);
 #endif
 }
 
 static inline void release_trylock(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef LOCK_ELISION
+    if (elide_release(global_d)) {
+        return;
+    }
+#endif
 #ifdef USE_MCS_LOCKS
     mcs_release(global_d->the_lock,*local_d);
 #elif defined(USE_HCLH_LOCKS)
@@ -589,6 +1223,88 @@ static inline void release_trylock(lock_local_data* local_d, lock_global_data* g
     pthread_mutex_unlock(global_d);
 #elif defined(USE_HTICKET_LOCKS)
     htlock_release_try(global_d);
+#elif defined(USE_RW_NUMA_LOCKS)
+    rw_numa_write_release(global_d);
+#elif defined(USE_QSPIN_LOCKS)
+    qspin_release(global_d);
+#elif defined(USE_SHFL_LOCKS)
+    shfl_release(global_d);
+#elif defined(USE_ARRAY_DYN_LOCKS)
+    alock_dyn_release(global_d);
+#elif defined(USE_POOLED_LOCKS)
+    qpool_release(global_d);
+#elif defined(USE_HMCS_LOCKS)
+    hmcs_release(global_d,*local_d);
+#elif defined(USE_CNA_LOCKS)
+    cna_release(global_d->the_lock,*local_d);
+#elif defined(USE_COHORT_LOCKS)
+    cohort_release(global_d, local_d);
+#elif defined(USE_RUNTIME_LOCKS)
+    lock_rt.release_trylock(local_d, global_d->the_lock);
+#endif
+}
+
+//timeout acquire of the selected algorithm, without the reader bias
+static inline int lock_timeout_impl(lock_local_data* local_d, lock_global_data* global_d, ticks timeout) {
+#ifdef USE_MCS_LOCKS
+    return mcs_acquire_timeout(global_d->the_lock, local_d, timeout);
+#elif defined(USE_HCLH_LOCKS)
+    return hclh_acquire_timeout_unsupported();
+#elif defined(USE_CLH_LOCKS)
+    return clh_acquire_timeout(global_d->the_lock, &(local_d->my_qnode), &(local_d->my_pred), timeout);
+#elif defined(USE_POOLED_LOCKS)
+    return qpool_acquire_timeout(global_d, timeout);
+#elif defined(USE_RUNTIME_LOCKS)
+    return lock_rt.acquire_timeout(local_d, global_d->the_lock, timeout);
+#else
+    //the other locks cannot leave a queue once in it: poll with trylock
+    ticks start = getticks();
+    while (lock_trylock_impl(local_d, global_d) != 0) {
+        if ((getticks() - start) > timeout) return 1;
+        PAUSE;
+    }
+    return 0;
 #endif
 }
 
+static inline int acquire_trylock(lock_local_data* local_d, lock_global_data* global_d) {
+#ifdef LOCK_ELISION
+    if (lock_elide(local_d, global_d, 0)) {
+        return 0;
+    }
+#endif
+    int ret = lock_trylock_impl(local_d, global_d);
+#ifdef READER_BIAS
+    if (ret == 0) {
+        bravo_write_acquired(global_d);
+    }
+#endif
+    return ret;
+}
+
+static inline int acquire_lock_timeout(lock_local_data* local_d, lock_global_data* global_d, ticks timeout) {
+#ifdef LOCK_ELISION
+    if (lock_elide(local_d, global_d, 0)) {
+        return 0;
+    }
+#endif
+    int ret = lock_timeout_impl(local_d, global_d, timeout);
+#ifdef READER_BIAS
+    if (ret == 0) {
+        bravo_write_acquired(global_d);
+    }
+#endif
+    return ret;
+}
+
+static inline void acquire_seq_write(lock_local_data* local_d, lock_global_data* global_d, seqlock_t* seq) {
+    acquire_write(local_d, global_d);
+    seqlock_write_begin(seq);
+}
+
+static inline void release_seq_write(lock_local_data* local_d, lock_global_data* global_d, seqlock_t* seq) {
+    seqlock_write_end(seq);
+    release_write(local_d, global_d);
+}
+
+#include "lock_set.h"
@@ -0,0 +1,151 @@
+/*
+ * File: lock_rt.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Runtime selection of the locking algorithm; all the algorithms
+ *      are compiled in and the calls are dispatched through a table of
+ *      function pointers. Used by lock_if.h when USE_RUNTIME_LOCKS is defined.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LOCK_RT_H_
+#define _LOCK_RT_H_
+
+#include "mcs.h"
+#include "clh.h"
+#include "hclh.h"
+#include "ttas.h"
+#include "spinlock.h"
+#include "rw_ttas.h"
+#include "rw_numa.h"
+#include "alock.h"
+#include "ticket.h"
+#include "htlock.h"
+#include "cohort.h"
+#include "cna.h"
+#include "qspin.h"
+#include "alock_dyn.h"
+#include "hmcs.h"
+#include "shfl.h"
+
+//environment variable used to pick the algorithm, e.g. LIBSLOCK_LOCK=mcs
+#define LOCK_RT_ENV "LIBSLOCK_LOCK"
+//algorithm used if neither lock_rt_select nor the environment picked one
+#define LOCK_RT_DEFAULT "SPINLOCK"
+
+//thread local data of any of the algorithms
+typedef union rt_local_params {
+    mcs_local_params mcs;
+    cna_local_params cna;
+    hmcs_local_params hmcs;
+    hclh_local_params hclh;
+    clh_local_params clh;
+    array_lock_t alock;
+    cohort_local_params cohort;
+    uint32_t limit;
+    void* base; //only used by the hidden first element of an array
+} rt_local_params;
+
+//points to the global data of the selected algorithm
+typedef struct rt_global_params {
+    void* the_lock;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 8];
+#endif
+} rt_global_params;
+
+//all functions take the local and global data of the selected algorithm
+typedef void (*lock_rt_fn)(void* local_d, void* global_d);
+typedef int (*lock_rt_try_fn)(void* local_d, void* global_d);
+typedef int (*lock_rt_timeout_fn)(void* local_d, void* global_d, ticks timeout);
+typedef uint32_t (*lock_rt_queue_fn)(void* local_d, void* global_d);
+
+typedef struct lock_rt_ops {
+    lock_rt_fn acquire;
+    lock_rt_fn release;
+    lock_rt_fn acquire_read;
+    lock_rt_fn release_read;
+    lock_rt_try_fn trylock;
+    lock_rt_fn release_trylock;
+
+    const char* name;
+    size_t global_size; //size of one element of the global array
+    size_t local_size;  //size of one element of the local array; 0 if there is no local data
+
+    void* (*init_array_global)(uint32_t num_locks, uint32_t num_threads);
+    void* (*init_array_local)(uint32_t thread_num, uint32_t num_locks, void* the_locks);
+    void (*end_array_local)(void* local_d, uint32_t num_locks);
+    void (*end_array_global)(void* the_locks, uint32_t num_locks);
+    int (*init_global)(uint32_t num_threads, void* the_lock);
+    int (*init_local)(uint32_t thread_num, void* the_lock, void* local_d);
+    void (*end_local)(void* local_d);
+    void (*end_global)(void* the_lock);
+
+    lock_rt_timeout_fn acquire_timeout;
+    lock_rt_queue_fn queue_length; //threads holding or waiting for the lock, used by the lock statistics
+} lock_rt_ops;
+
+//the selected algorithm; kept by value so that a call costs a single load
+extern lock_rt_ops lock_rt;
+
+/*
+ *  Selection of the algorithm; must happen before any lock is initialized
+ */
+
+//select by name (MCS, HCLH, TTAS, SPINLOCK, ARRAY, RW, CLH, TICKET, MUTEX, HTICKET,
+//COHORT_BO_MCS, COHORT_TKT_TKT, COHORT_MCS_MCS, CNA, RW_NUMA, QSPIN, ARRAY_DYN, HMCS, SHFL);
+//returns 0 on success, 1 if the name is unknown
+int lock_rt_select(const char* name);
+
+//select from LIBSLOCK_LOCK if nothing was selected yet; returns the name of the selected algorithm
+const char* lock_rt_init();
+
+//names of all the available algorithms, NULL terminated
+extern const char* lock_rt_names[];
+
+/*
+   Methods for easy lock array manipulation
+   */
+
+rt_global_params* init_rt_array_global(uint32_t num_locks, uint32_t num_threads);
+
+rt_local_params* init_rt_array_local(uint32_t thread_num, uint32_t num_locks, rt_global_params* the_locks);
+
+void end_rt_array_local(rt_local_params* local_params, uint32_t size);
+
+void end_rt_array_global(rt_global_params* the_locks, uint32_t size);
+
+/*
+   single lock manipulation
+   */
+
+int init_rt_global(uint32_t num_threads, rt_global_params* the_lock);
+
+int init_rt_local(uint32_t thread_num, rt_global_params* the_lock, rt_local_params* local_d);
+
+void end_rt_local(rt_local_params local_d);
+
+void end_rt_global(rt_global_params the_lock);
+
+#endif
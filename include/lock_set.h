@@ -0,0 +1,151 @@
+/*
+ * File: lock_set.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Sets of locks from an array of lock_if.h locks, acquired together in
+ *      a canonical order: the indices are kept sorted as runs of
+ *      consecutive indices, and acquired in increasing order, so threads
+ *      that only take locks through lock sets of the same array cannot
+ *      deadlock. A run (e.g. a range of accounts) is acquired by one loop
+ *      over the array. Included by lock_if.h.
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LOCK_SET_H_
+#define _LOCK_SET_H_
+
+//runs of consecutive indices in a set
+#ifndef LOCK_SET_MAX_RUNS
+#  define LOCK_SET_MAX_RUNS 16
+#endif
+
+typedef struct lock_set {
+    uint32_t num_runs;
+    uint32_t first[LOCK_SET_MAX_RUNS];
+    uint32_t count[LOCK_SET_MAX_RUNS];
+} lock_set_t;
+
+static inline void lock_set_init(lock_set_t* set) {
+    set->num_runs = 0;
+}
+
+//adds the indices first to first + count - 1, merged with the runs they touch;
+//returns 0 on success, 1 if the set has no room for a new run
+static inline int lock_set_add_range(lock_set_t* set, uint32_t first, uint32_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t end = first + count;
+    uint32_t i = 0;
+    //runs that end before the new one starts
+    while (i < set->num_runs && set->first[i] + set->count[i] < first) {
+        i++;
+    }
+    //runs that overlap or touch the new one are merged into it
+    uint32_t j = i;
+    while (j < set->num_runs && set->first[j] <= end) {
+        if (set->first[j] < first) {
+            first = set->first[j];
+        }
+        if (set->first[j] + set->count[j] > end) {
+            end = set->first[j] + set->count[j];
+        }
+        j++;
+    }
+    if (j == i) {
+        if (set->num_runs == LOCK_SET_MAX_RUNS) {
+            return 1;
+        }
+        memmove(&set->first[i + 1], &set->first[i], (set->num_runs - i) * sizeof(uint32_t));
+        memmove(&set->count[i + 1], &set->count[i], (set->num_runs - i) * sizeof(uint32_t));
+        set->num_runs++;
+    } else if (j > i + 1) {
+        memmove(&set->first[i + 1], &set->first[j], (set->num_runs - j) * sizeof(uint32_t));
+        memmove(&set->count[i + 1], &set->count[j], (set->num_runs - j) * sizeof(uint32_t));
+        set->num_runs -= j - i - 1;
+    }
+    set->first[i] = first;
+    set->count[i] = end - first;
+    return 0;
+}
+
+static inline int lock_set_add(lock_set_t* set, uint32_t index) {
+    return lock_set_add_range(set, index, 1);
+}
+
+//number of locks in the set
+static inline uint32_t lock_set_size(lock_set_t* set) {
+    uint32_t i, size = 0;
+    for (i = 0; i < set->num_runs; i++) {
+        size += set->count[i];
+    }
+    return size;
+}
+
+/*
+ *  Acquire and release methods; local_d and the_locks are the arrays of
+ *  init_lock_array_local and init_lock_array_global
+ */
+
+static inline void lock_set_acquire(lock_set_t* set, local_data local_d, global_data the_locks) {
+    uint32_t r, i;
+    for (r = 0; r < set->num_runs; r++) {
+        uint32_t end = set->first[r] + set->count[r];
+        for (i = set->first[r]; i < end; i++) {
+            acquire_write(&local_d[i], &the_locks[i]);
+        }
+    }
+}
+
+static inline void lock_set_release(lock_set_t* set, local_data local_d, global_data the_locks) {
+    int r;
+    uint32_t i;
+    for (r = (int) set->num_runs - 1; r >= 0; r--) {
+        for (i = set->first[r] + set->count[r]; i-- > set->first[r]; ) {
+            release_write(&local_d[i], &the_locks[i]);
+        }
+    }
+}
+
+static inline void lock_set_acquire_read(lock_set_t* set, local_data local_d, global_data the_locks) {
+    uint32_t r, i;
+    for (r = 0; r < set->num_runs; r++) {
+        uint32_t end = set->first[r] + set->count[r];
+        for (i = set->first[r]; i < end; i++) {
+            acquire_read(&local_d[i], &the_locks[i]);
+        }
+    }
+}
+
+static inline void lock_set_release_read(lock_set_t* set, local_data local_d, global_data the_locks) {
+    int r;
+    uint32_t i;
+    for (r = (int) set->num_runs - 1; r >= 0; r--) {
+        for (i = set->first[r] + set->count[r]; i-- > set->first[r]; ) {
+            release_read(&local_d[i], &the_locks[i]);
+        }
+    }
+}
+
+#endif
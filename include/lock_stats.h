@@ -0,0 +1,210 @@
+/*
+ * File: lock_stats.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Contention statistics of the locks, collected by lock_if.h when
+ *      LOCK_STATS is defined (make STATS=1). The counters of a thread are
+ *      kept in its own cache line and summed on demand; the counters of a
+ *      lock are kept in a table indexed by its address and are only
+ *      written by the holder of the lock. The hold time is measured from
+ *      the acquisition time kept by the holding thread, so it is counted
+ *      for every lock, with or without an entry in the table. The
+ *      acquisitions of acquire_trylock and acquire_lock_timeout are not
+ *      counted, and neither are their hold times.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LOCK_STATS_H_
+#define _LOCK_STATS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <sched.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//max number of threads with statistics
+#ifndef LOCK_STATS_MAX_THREADS
+#  define LOCK_STATS_MAX_THREADS 1024
+#endif
+//number of locks with their own statistics (power of 2); the locks that do not fit are only counted per thread
+#ifndef LOCK_STATS_SLOTS
+#  define LOCK_STATS_SLOTS 4096
+#endif
+#define LOCK_STATS_PROBES 8
+//locks held at the same time by a thread whose acquisition time it keeps; beyond that,
+//the hold time is only measured for the locks with an entry in the table
+#ifndef LOCK_STATS_MAX_HELD
+#  define LOCK_STATS_MAX_HELD 64
+#endif
+#define LOCK_STATS_NO_CLUSTER 0xffffffff
+
+//statistics of a thread, or sum of them
+typedef struct lock_stats {
+    uint64_t acquires;
+    uint64_t exclusive;   //acquisitions that excluded the other threads: not the shared reads
+    uint64_t contended;   //the lock was held when the thread arrived
+    uint64_t wait_cycles; //from the arrival to the acquisition
+    uint64_t hold_cycles; //from the acquisition to the release; exclusive acquisitions only
+    uint64_t queued;      //sum of the number of threads ahead at the arrival (holder included);
+                          //exact for the ticket locks only, 0 or 1 (up to 3 for qspin and shfl) for the others
+    uint64_t cross_socket; //the previous holder ran on another socket; exclusive acquisitions only
+    uint8_t padding[CACHE_LINE_SIZE - 56];
+} lock_stats_t;
+
+//statistics of a lock; exclusive acquisitions only
+typedef struct ALIGNED(CACHE_LINE_SIZE) lock_stats_slot {
+    void* volatile lock;
+    uint64_t acquires;
+    uint64_t contended;
+    uint64_t wait_cycles;
+    uint64_t hold_cycles;
+    uint64_t cross_socket;
+    ticks acquired_at;
+    uint32_t last_cluster;
+} lock_stats_slot_t;
+
+extern __thread lock_stats_t* lock_stats_mine;
+extern __thread uint32_t lock_stats_cluster;
+
+//locks held exclusively by the thread, and their acquisition times
+extern __thread void* lock_stats_held_lock[LOCK_STATS_MAX_HELD];
+extern __thread ticks lock_stats_held_at[LOCK_STATS_MAX_HELD];
+extern __thread uint32_t lock_stats_held;
+//locks held exclusively by the thread that did not fit in lock_stats_held_lock
+extern __thread uint32_t lock_stats_held_overflow;
+
+//registers the calling thread, running on core; called by the thread initialization of lock_if.h
+void lock_stats_thread_init(uint32_t core);
+
+//the statistics of the lock, NULL if the table is full
+lock_stats_slot_t* lock_stats_slot(void* lock);
+
+//sums the statistics of all threads
+void lock_stats_aggregate(lock_stats_t* total);
+
+void lock_stats_reset();
+
+//prints the sum of the statistics of all threads
+void lock_stats_print();
+
+//prints the stats of the calling thread
+void lock_stats_print_thread();
+
+//prints the num_locks locks with the most contended acquisitions
+void lock_stats_print_hot(uint32_t num_locks);
+
+//average number of threads ahead at the arrival
+static inline double lock_stats_avg_queue(lock_stats_t* s) {
+    if (s->acquires == 0) return 0;
+    return s->queued / (double) s->acquires;
+}
+
+/*
+ *  Hooks called by lock_if.h
+ */
+
+static inline lock_stats_t* lock_stats_self() {
+    if (lock_stats_mine == NULL) {
+        //thread that did not initialize its lock data
+        lock_stats_thread_init(sched_getcpu());
+    }
+    return lock_stats_mine;
+}
+
+//lock acquired; start is the arrival time, queue the number of threads ahead at the arrival;
+//not called for the acquisitions of acquire_trylock and acquire_lock_timeout
+static inline void lock_stats_acquired(void* lock, ticks start, uint32_t queue, int exclusive) {
+    lock_stats_t* s = lock_stats_self();
+    ticks now = getticks();
+    s->acquires++;
+    s->wait_cycles += now - start;
+    s->queued += queue;
+    if (queue > 0) {
+        s->contended++;
+    }
+    if (!exclusive) {
+        return;
+    }
+    s->exclusive++;
+    if (lock_stats_held < LOCK_STATS_MAX_HELD) {
+        lock_stats_held_lock[lock_stats_held] = lock;
+        lock_stats_held_at[lock_stats_held] = now;
+        lock_stats_held++;
+    } else {
+        lock_stats_held_overflow++;
+    }
+    lock_stats_slot_t* slot = lock_stats_slot(lock);
+    if (slot == NULL) {
+        return;
+    }
+    slot->acquires++;
+    slot->wait_cycles += now - start;
+    if (queue > 0) {
+        slot->contended++;
+    }
+    if (slot->last_cluster != lock_stats_cluster && slot->last_cluster != LOCK_STATS_NO_CLUSTER) {
+        slot->cross_socket++;
+        s->cross_socket++;
+    }
+    slot->last_cluster = lock_stats_cluster;
+    slot->acquired_at = now;
+}
+
+//about to release a lock acquired exclusively; a lock the thread does not hold
+//in its list was taken by acquire_trylock or acquire_lock_timeout, or did not fit
+static inline void lock_stats_release(void* lock) {
+    ticks now = getticks();
+    lock_stats_slot_t* slot = lock_stats_slot(lock);
+    ticks hold;
+    int i;
+    for (i = (int) lock_stats_held - 1; i >= 0; i--) {
+        if (lock_stats_held_lock[i] == lock) {
+            break;
+        }
+    }
+    if (i >= 0) {
+        hold = now - lock_stats_held_at[i];
+        lock_stats_held--;
+        lock_stats_held_lock[i] = lock_stats_held_lock[lock_stats_held];
+        lock_stats_held_at[i] = lock_stats_held_at[lock_stats_held];
+    } else if (lock_stats_held_overflow > 0) {
+        lock_stats_held_overflow--;
+        if (slot == NULL) {
+            return;
+        }
+        hold = now - slot->acquired_at;
+    } else {
+        return;
+    }
+    if (slot != NULL) {
+        slot->hold_cycles += hold;
+    }
+    lock_stats_self()->hold_cycles += hold;
+}
+
+#endif
@@ -46,9 +46,16 @@
 #include <pthread.h>
 #include "utils.h"
 #include "atomic_ops.h"
+#ifdef SPIN_THEN_PARK
+#include "park.h"
+#endif
 
 typedef struct mcs_qnode {
+#ifdef SPIN_THEN_PARK
+    volatile uint32_t waiting; //2 if the waiter sleeps; futexes need 32 bits
+#else
     volatile uint8_t waiting;
+#endif
     volatile struct mcs_qnode *volatile next;
 #ifdef ADD_PADDING
 #if CACHE_LINE_SIZE == 16
@@ -58,6 +65,9 @@ typedef struct mcs_qnode {
 #endif
 } mcs_qnode;
 
+//value of waiting once the waiter gave up; the node then belongs to the releaser that skips it
+#define MCS_ABANDONED 3
+
 typedef volatile mcs_qnode *mcs_qnode_ptr;
 typedef mcs_qnode_ptr mcs_lock; //initialized to NULL
 
@@ -105,4 +115,8 @@ void mcs_release(mcs_lock *the_lock, mcs_qnode_ptr I);
 int is_free_mcs(mcs_lock *L );
 
 int mcs_trylock(mcs_lock *L, mcs_qnode_ptr I);
+
+//waits at most timeout cycles; returns 0 on success, 1 otherwise;
+//a waiter that gives up leaves its node in the queue and gets a new one in *I
+int mcs_acquire_timeout(mcs_lock *L, mcs_qnode** I, ticks timeout);
 #endif
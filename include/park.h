@@ -0,0 +1,122 @@
+/*
+ * File: park.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description: 
+ *      Helpers for the spin-then-park mode of the locks (SPIN_THEN_PARK):
+ *      futex wait and wake, and a per thread spin budget in cycles that
+ *      adapts to how long the waits that ended while spinning took.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _PARK_H_
+#define _PARK_H_
+
+#include <stdint.h>
+#include <limits.h>
+#include <sched.h>
+#if defined(__linux__)
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#endif
+#include "utils.h"
+
+//bounds and initial value of the spin budget, in cycles
+#ifndef PARK_SPIN_MIN
+#  define PARK_SPIN_MIN  1000
+#endif
+#ifndef PARK_SPIN_MAX
+#  define PARK_SPIN_MAX  200000
+#endif
+#ifndef PARK_SPIN_INIT
+#  define PARK_SPIN_INIT 20000
+#endif
+
+//a waiter polls the clock once every PARK_CHECK_EVERY spins
+#define PARK_CHECK_EVERY 64
+
+/*
+ *  futex wrappers; without futexes the waiters yield instead of sleeping
+ */
+
+//sleeps while *addr == val
+static inline void park_wait(volatile uint32_t* addr, uint32_t val) {
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t*) addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+}
+
+//wakes at most num threads sleeping on addr
+static inline void park_wake(volatile uint32_t* addr, int num) {
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t*) addr, FUTEX_WAKE_PRIVATE, num, NULL, NULL, 0);
+#endif
+}
+
+//sleeps while *addr == val, until woken with a bitset that shares a bit with mask
+static inline void park_wait_bitset(volatile uint32_t* addr, uint32_t val, uint32_t mask) {
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t*) addr, FUTEX_WAIT_BITSET_PRIVATE, val, NULL, NULL, mask);
+#else
+    sched_yield();
+#endif
+}
+
+static inline void park_wake_bitset(volatile uint32_t* addr, uint32_t mask) {
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t*) addr, FUTEX_WAKE_BITSET_PRIVATE, INT_MAX, NULL, NULL, mask);
+#endif
+}
+
+/*
+ *  Spin budget
+ */
+
+//whether a waiter that started spinning at start is out of budget; checks the clock every PARK_CHECK_EVERY calls
+static inline int park_spin_done(ticks start, ticks budget, uint32_t* spins) {
+    if ((++(*spins) % PARK_CHECK_EVERY) != 0) return 0;
+    return (getticks() - start) > budget;
+}
+
+//the wait ended while spinning, after spent cycles: aim at twice the average wait
+static inline void park_budget_spun(ticks* budget, ticks spent) {
+    ticks target = 2 * spent;
+    if (target > *budget) {
+        *budget += (target - *budget) / 8;
+    } else {
+        *budget -= (*budget - target) / 8;
+    }
+    if (*budget < PARK_SPIN_MIN) *budget = PARK_SPIN_MIN;
+    if (*budget > PARK_SPIN_MAX) *budget = PARK_SPIN_MAX;
+}
+
+//the waiter had to sleep: the spinning was wasted, spin less next time
+static inline void park_budget_parked(ticks* budget) {
+    *budget -= *budget / 8;
+    if (*budget < PARK_SPIN_MIN) *budget = PARK_SPIN_MIN;
+}
+
+#endif
@@ -44,22 +44,19 @@ extern "C" {
      *  NOP_DURATION: the duration in cycles of a noop instruction (generally 1 cycle on most small machines)
      *  the_cores - a mapping from the core ids as configured in the OS to physical cores (the OS might not alwas be configured corrrectly)
      *  get_cluster - a function that given a core id returns the socket number ot belongs to
+     *  MAX_SOCKETS: upper bound of NUMBER_OF_SOCKETS, for statically sized arrays (defaults to NUMBER_OF_SOCKETS)
      */
 
 
 #ifdef DEFAULT
-#  define NUMBER_OF_SOCKETS 1
-#  define CORES_PER_SOCKET CORE_NUM
+    //the topology is read from /sys/devices/system at startup (topology.h)
+#  include "topology.h"
+#  define NUMBER_OF_SOCKETS (topology.num_sockets)
+#  define CORES_PER_SOCKET (topology.cpus_per_socket)
+#  define MAX_SOCKETS TOPOLOGY_MAX_SOCKETS
 #  define CACHE_LINE_SIZE 64
 # define NOP_DURATION 2
-  static uint8_t  __attribute__ ((unused)) the_cores[] = {
-        0, 1, 2, 3, 4, 5, 6, 7, 
-        8, 9, 10, 11, 12, 13, 14, 15, 
-        16, 17, 18, 19, 20, 21, 22, 23, 
-        24, 25, 26, 27, 28, 29, 30, 31, 
-        32, 33, 34, 35, 36, 37, 38, 39, 
-        40, 41, 42, 43, 44, 45, 46, 47  
-    };
+#  define the_cores (topology.cores)
 #endif
 
 #ifdef SPARC
@@ -171,6 +168,10 @@ extern "C" {
 
 #endif
 
+#ifndef MAX_SOCKETS
+#  define MAX_SOCKETS NUMBER_OF_SOCKETS
+#endif
+
 #if defined(OPTERON)
 #  define PREFETCHW(x)		     asm volatile("prefetchw %0" :: "m" (*(unsigned long *)x))
 #elif defined(__sparc__)
@@ -196,11 +197,31 @@ extern "C" {
         return the_sockets[thread_id];    
 #elif defined(__tile__)
         return 0;
+#elif defined(DEFAULT)
+        return topology_socket(thread_id);
 #else
         return thread_id/CORES_PER_SOCKET;
 #endif
     }
 
+    //the NUMA node of a core
+    static inline int get_numa_node(int thread_id) {
+#ifdef DEFAULT
+        return topology_node(thread_id);
+#else
+        return get_cluster(thread_id);
+#endif
+    }
+
+    //the NUMA node holding the memory of a cluster
+    static inline int get_cluster_node(int cluster) {
+#ifdef DEFAULT
+        return topology_socket_node(cluster);
+#else
+        return cluster;
+#endif
+    }
+
 #ifdef __cplusplus
 }
 
@@ -0,0 +1,362 @@
+/*
+ * File: qnode_pool.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Per-thread pool of queue nodes for the MCS, CLH, HCLH and array locks
+ *      (QNODE_POOL): a thread takes an entry of its pool when it starts to
+ *      acquire a lock and returns it at the release, so it needs no local
+ *      data per lock; the pool only has to cover the locks that a thread
+ *      holds or waits for at the same time.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _QNODE_POOL_H_
+#define _QNODE_POOL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//max number of locks held or waited for at the same time by a thread
+#ifndef QNODE_POOL_SIZE
+#  define QNODE_POOL_SIZE 16
+#endif
+
+typedef struct qnode_pool_entry {
+    void* lock;     //lock acquired with this entry; NULL if the entry is free
+    void* node;     //queue node of the entry, allocated at its first use
+    void* pred;     //CLH and HCLH: node of the predecessor
+    uint32_t index; //array lock: slot of the thread
+} qnode_pool_entry_t;
+
+//entries in use are kept at the beginning of the pool
+extern __thread qnode_pool_entry_t qnode_pool[QNODE_POOL_SIZE];
+extern __thread uint32_t qnode_pool_depth;
+
+//called when a thread uses more than QNODE_POOL_SIZE entries; exits
+void qnode_pool_overflow();
+
+//allocates a queue node for an entry
+void* qnode_pool_alloc(size_t size);
+
+static inline qnode_pool_entry_t* qnode_pool_push(void* lock) {
+    if (qnode_pool_depth >= QNODE_POOL_SIZE) {
+        qnode_pool_overflow();
+    }
+    qnode_pool_entry_t* e = &qnode_pool[qnode_pool_depth++];
+    e->lock = lock;
+    return e;
+}
+
+//the entry of a lock held or waited for by the thread
+static inline qnode_pool_entry_t* qnode_pool_find(void* lock) {
+    int i;
+    for (i = (int) qnode_pool_depth - 1; i >= 0; i--) {
+        if (qnode_pool[i].lock == lock) {
+            return &qnode_pool[i];
+        }
+    }
+    return NULL;
+}
+
+//frees an entry; the last entry in use takes its place, with its node
+static inline void qnode_pool_pop(qnode_pool_entry_t* e) {
+    qnode_pool_entry_t* last = &qnode_pool[--qnode_pool_depth];
+    if (e != last) {
+        qnode_pool_entry_t tmp = *e;
+        *e = *last;
+        *last = tmp;
+    }
+    last->lock = NULL;
+}
+
+/*
+ *  Pooled version of the selected lock, used by lock_if.h;
+ *  qpool_global_t is the global data of the lock
+ */
+
+#if defined(POOLED_MCS)
+#include "mcs.h"
+
+typedef mcs_global_params qpool_global_t;
+
+static inline mcs_qnode* qpool_node(qnode_pool_entry_t* e) {
+    if (e->node == NULL) {
+        e->node = qnode_pool_alloc(sizeof(mcs_qnode));
+    }
+    return (mcs_qnode*) e->node;
+}
+
+static inline void qpool_thread_init(uint32_t thread_num) {
+    set_cpu(thread_num);
+}
+
+static inline qpool_global_t* qpool_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_mcs_array_global(num_locks);
+}
+
+static inline int qpool_init_global(uint32_t num_threads, qpool_global_t* g) {
+    return init_mcs_global(g);
+}
+
+static inline void qpool_end_array_global(qpool_global_t* g, uint32_t num_locks) {
+    end_mcs_array_global(g, num_locks);
+}
+
+static inline void qpool_end_global(qpool_global_t* g) {
+    end_mcs_global(*g);
+}
+
+static inline void qpool_acquire(qpool_global_t* g) {
+    mcs_acquire(g->the_lock, qpool_node(qnode_pool_push(g)));
+}
+
+static inline void qpool_release(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_find(g);
+    mcs_release(g->the_lock, (mcs_qnode*) e->node);
+    qnode_pool_pop(e);
+}
+
+static inline int qpool_trylock(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_push(g);
+    if (mcs_trylock(g->the_lock, qpool_node(e)) != 0) {
+        qnode_pool_pop(e);
+        return 1;
+    }
+    return 0;
+}
+
+static inline int qpool_acquire_timeout(qpool_global_t* g, ticks timeout) {
+    qnode_pool_entry_t* e = qnode_pool_push(g);
+    qpool_node(e);
+    //a waiter that gives up gets a new node
+    if (mcs_acquire_timeout(g->the_lock, (mcs_qnode**) &e->node, timeout) != 0) {
+        qnode_pool_pop(e);
+        return 1;
+    }
+    return 0;
+}
+
+static inline uint32_t qpool_queue_length(qpool_global_t* g) {
+    return !is_free_mcs(g->the_lock);
+}
+
+#elif defined(POOLED_CLH)
+#include "clh.h"
+
+typedef clh_global_params qpool_global_t;
+
+static inline clh_qnode* qpool_node(qnode_pool_entry_t* e) {
+    if (e->node == NULL) {
+        clh_qnode* n = (clh_qnode*) qnode_pool_alloc(sizeof(clh_qnode));
+        n->locked = 0;
+        e->node = n;
+    }
+    return (clh_qnode*) e->node;
+}
+
+static inline void qpool_thread_init(uint32_t thread_num) {
+    set_cpu(thread_num);
+}
+
+static inline qpool_global_t* qpool_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_clh_array_global(num_locks);
+}
+
+static inline int qpool_init_global(uint32_t num_threads, qpool_global_t* g) {
+    return init_clh_global(g);
+}
+
+static inline void qpool_end_array_global(qpool_global_t* g, uint32_t num_locks) {
+    end_clh_array_global(g, num_locks);
+}
+
+static inline void qpool_end_global(qpool_global_t* g) {
+    end_clh_global(*g);
+}
+
+static inline void qpool_acquire(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_push(g);
+    e->pred = (clh_qnode*) clh_acquire(g->the_lock, qpool_node(e));
+}
+
+//the node of the predecessor replaces the node of the entry
+static inline void qpool_release(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_find(g);
+    e->node = clh_release((clh_qnode*) e->node, (clh_qnode*) e->pred);
+    qnode_pool_pop(e);
+}
+
+static inline int qpool_trylock(qpool_global_t* g) {
+    perror("trylock not supported for clh locks");
+    return 1;
+}
+
+static inline int qpool_acquire_timeout(qpool_global_t* g, ticks timeout) {
+    qnode_pool_entry_t* e = qnode_pool_push(g);
+    qpool_node(e);
+    if (clh_acquire_timeout(g->the_lock, (clh_qnode**) &e->node, (clh_qnode**) &e->pred, timeout) != 0) {
+        qnode_pool_pop(e);
+        return 1;
+    }
+    return 0;
+}
+
+static inline uint32_t qpool_queue_length(qpool_global_t* g) {
+    return (*g->the_lock)->locked != 0;
+}
+
+#elif defined(POOLED_HCLH)
+#include "hclh.h"
+
+typedef hclh_global_params qpool_global_t;
+
+static inline qnode* qpool_node(qnode_pool_entry_t* e) {
+    if (e->node == NULL) {
+        qnode* n = (qnode*) qnode_pool_alloc(sizeof(qnode));
+        n->data = 0;
+        n->fields.cluster_id = hclh_node_mine;
+        n->fields.successor_must_wait = 1;
+        e->node = n;
+    }
+    return (qnode*) e->node;
+}
+
+static inline void qpool_thread_init(uint32_t thread_num) {
+    init_hclh_thread(thread_num);
+}
+
+static inline qpool_global_t* qpool_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_hclh_array_global(num_locks);
+}
+
+static inline int qpool_init_global(uint32_t num_threads, qpool_global_t* g) {
+    return init_hclh_global(g);
+}
+
+static inline void qpool_end_array_global(qpool_global_t* g, uint32_t num_locks) {
+    end_hclh_array_global(g, num_locks);
+}
+
+static inline void qpool_end_global(qpool_global_t* g) {
+    end_hclh_global(*g);
+}
+
+static inline void qpool_acquire(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_push(g);
+    e->pred = (qnode*) hclh_acquire(g->local_queues[hclh_node_mine], g->shared_queue, qpool_node(e));
+}
+
+//the node of the predecessor replaces the node of the entry
+static inline void qpool_release(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_find(g);
+    e->node = hclh_release((qnode*) e->node, (qnode*) e->pred);
+    qnode_pool_pop(e);
+}
+
+static inline int qpool_trylock(qpool_global_t* g) {
+    perror("trylock not supported for hclh locks");
+    return 1;
+}
+
+static inline int qpool_acquire_timeout(qpool_global_t* g, ticks timeout) {
+    return hclh_acquire_timeout_unsupported();
+}
+
+static inline uint32_t qpool_queue_length(qpool_global_t* g) {
+    qnode me;
+    me.data = 0;
+    me.fields.cluster_id = hclh_node_mine;
+    return !is_free_hclh(g->local_queues[hclh_node_mine], g->shared_queue, &me);
+}
+
+#elif defined(POOLED_ARRAY)
+#include "alock.h"
+
+//the array lock has no queue node: the entry keeps the slot of the thread
+typedef lock_shared_t qpool_global_t;
+
+static inline void qpool_thread_init(uint32_t thread_num) {
+    set_cpu(thread_num);
+}
+
+static inline qpool_global_t* qpool_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_alock_array_global(num_locks, num_threads);
+}
+
+static inline int qpool_init_global(uint32_t num_threads, qpool_global_t* g) {
+    return init_alock_global(num_threads, g);
+}
+
+static inline void qpool_end_array_global(qpool_global_t* g, uint32_t num_locks) {
+    end_alock_array_global(g, num_locks);
+}
+
+static inline void qpool_end_global(qpool_global_t* g) {
+    //method not needed
+}
+
+static inline void qpool_acquire(qpool_global_t* g) {
+    array_lock_t l;
+    l.shared_data = g;
+    alock_lock(&l);
+    qnode_pool_push(g)->index = l.my_index;
+}
+
+static inline void qpool_release(qpool_global_t* g) {
+    qnode_pool_entry_t* e = qnode_pool_find(g);
+    array_lock_t l;
+    l.shared_data = g;
+    l.my_index = e->index;
+    qnode_pool_pop(e);
+    alock_unlock(&l);
+}
+
+static inline int qpool_trylock(qpool_global_t* g) {
+    array_lock_t l;
+    l.shared_data = g;
+    if (alock_trylock(&l) != 0) {
+        return 1;
+    }
+    qnode_pool_push(g)->index = l.my_index;
+    return 0;
+}
+
+static inline int qpool_acquire_timeout(qpool_global_t* g, ticks timeout) {
+    ticks start = getticks();
+    while (qpool_trylock(g) != 0) {
+        if ((getticks() - start) > timeout) return 1;
+        PAUSE;
+    }
+    return 0;
+}
+
+static inline uint32_t qpool_queue_length(qpool_global_t* g) {
+    return !is_free_alock(g);
+}
+#endif
+
+#endif
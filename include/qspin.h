@@ -0,0 +1,124 @@
+/*
+ * File: qspin.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Queued spinlock in 32 bits, after the qspinlock of the Linux kernel:
+ *      a locked byte, a pending byte, and the tail of an MCS queue encoded as
+ *      (thread, nesting index) into a per-thread array of queue nodes. The
+ *      first waiter only sets the pending bit and spins on the lock word;
+ *      the next ones queue. There is no per-lock local data.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _QSPIN_H_
+#define _QSPIN_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+#include "qtail.h"
+
+
+//layout of the lock word
+#define QSPIN_LOCKED        0x1U
+#define QSPIN_LOCKED_MASK   0xffU
+#define QSPIN_PENDING       0x100U
+#define QSPIN_TAIL_MASK     QTAIL_MASK
+
+//spins of a new waiter while the pending waiter takes the lock
+#define QSPIN_PENDING_LOOPS 1
+
+typedef struct qspin_lock {
+    union {
+        volatile uint32_t val;
+        struct {
+#ifdef __sparc__
+            volatile uint16_t tail;
+            volatile uint8_t pending;
+            volatile uint8_t locked;
+#else
+            volatile uint8_t locked;
+            volatile uint8_t pending;
+            volatile uint16_t tail;
+#endif
+        };
+    };
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 4];
+#endif
+} qspin_lock_t;
+
+typedef struct qspin_node {
+    struct qspin_node* volatile next;
+    volatile uint32_t locked; //set by the predecessor when this node is at the head of the queue
+    uint8_t padding[CACHE_LINE_SIZE - 12];
+} qspin_node_t;
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+qspin_lock_t* init_qspin_array_global(uint32_t num_locks);
+
+void init_qspin_array_local(uint32_t thread_num);
+
+//returns the thread id (qtail.h)
+void end_qspin_array_local();
+
+void end_qspin_array_global(qspin_lock_t* the_locks);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_qspin_global(qspin_lock_t* the_lock);
+
+int init_qspin_local(uint32_t thread_num);
+
+//returns the thread id (qtail.h)
+void end_qspin_local();
+
+void end_qspin_global(qspin_lock_t the_lock);
+
+/*
+ *  Acquire and release methods
+ */
+
+void qspin_acquire(qspin_lock_t* lock);
+
+void qspin_release(qspin_lock_t* lock);
+
+//returns 0 on success, 1 otherwise
+int qspin_trylock(qspin_lock_t* lock);
+
+int is_free_qspin(qspin_lock_t* lock);
+
+//0 if the lock is free, 1 if it is held, up to 3 if a thread is pending or queued
+uint32_t qspin_queue_length(qspin_lock_t* lock);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * File: qtail.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Queue nodes and thread ids of the 32-bit queue locks (qspin, shfl),
+ *      whose tail names a thread and one of its nodes instead of a pointer.
+ *      The nodes of a thread serve all of these locks. A thread claims the
+ *      lowest free id the first time it needs one, and returns it when it
+ *      ends its lock data or exits, so any number of threads can be
+ *      created over the life of a process, as long as at most
+ *      QTAIL_MAX_THREADS hold an id at once.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _QTAIL_H_
+#define _QTAIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//max number of threads holding an id at the same time; the tail keeps 14 bits for the thread
+#ifndef QTAIL_MAX_THREADS
+#  define QTAIL_MAX_THREADS 1024
+#endif
+#if QTAIL_MAX_THREADS > 16383
+#  error "QTAIL_MAX_THREADS does not fit in the 14 bits of the tail"
+#endif
+//queue nodes of a thread, i.e. number of queue locks it can wait for at the same time
+#define QTAIL_MAX_NESTING 4
+
+//layout of the tail, in the upper half of the lock word
+#define QTAIL_IDX_SHIFT 16
+#define QTAIL_TID_SHIFT 18
+#define QTAIL_MASK      0xffff0000U
+
+//room for the queue node of any of these locks (qspin_node_t, shfl_node_t)
+typedef struct ALIGNED(CACHE_LINE_SIZE) qtail_node {
+    uint8_t data[CACHE_LINE_SIZE];
+} qtail_node_t;
+
+//queue nodes of all the threads, by thread id and nesting index
+extern qtail_node_t qtail_nodes[QTAIL_MAX_THREADS][QTAIL_MAX_NESTING];
+
+extern __thread uint32_t qtail_tid;     //id of the thread plus 1; 0 if none
+extern __thread uint32_t qtail_nesting; //nodes of the thread in use
+
+//claims an id for the calling thread; 0 if all of them are taken
+uint32_t qtail_claim_tid();
+
+//returns the id of the calling thread, which must not be queued; also done when it exits
+void qtail_release_tid();
+
+//id of the calling thread plus 1, claimed if needed; 0 if there is none left
+static inline uint32_t qtail_thread_init() {
+    if (qtail_tid == 0) {
+        return qtail_claim_tid();
+    }
+    return qtail_tid;
+}
+
+static inline uint32_t qtail_encode(uint32_t tid, uint32_t idx) {
+    return (tid << QTAIL_TID_SHIFT) | (idx << QTAIL_IDX_SHIFT);
+}
+
+//node idx of the thread with id tid (plus 1)
+static inline void* qtail_node(uint32_t tid, uint32_t idx) {
+    return &qtail_nodes[tid - 1][idx];
+}
+
+static inline void* qtail_decode(uint32_t tail) {
+    return qtail_node(tail >> QTAIL_TID_SHIFT, (tail >> QTAIL_IDX_SHIFT) & (QTAIL_MAX_NESTING - 1));
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * File: rw_numa.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      NUMA-aware reader-writer lock: every socket has its own reader
+ *      counter, in its own cache line, so that readers of different sockets
+ *      do not write the same line; a writer sets the writer flag and waits
+ *      for the counters of all sockets to drop to zero. With the
+ *      writer-preference policy a waiting writer goes before the readers
+ *      that arrive after it; with the neutral policy the readers blocked by
+ *      a writer enter before the next writer.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _RW_NUMA_H_
+#define _RW_NUMA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+#define RW_NUMA_WRITER_PREF 0
+#define RW_NUMA_NEUTRAL 1
+
+//policy of new locks
+#ifndef RW_NUMA_POLICY
+#  define RW_NUMA_POLICY RW_NUMA_NEUTRAL
+#endif
+
+//reader counter of a socket
+typedef struct rw_numa_readers {
+    volatile uint32_t count;
+    uint8_t padding[CACHE_LINE_SIZE - 4];
+} rw_numa_readers_t;
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) rw_numa_lock {
+    volatile uint32_t writer;       //a writer holds the lock, or waits for the readers to leave
+    volatile uint32_t read_waiters; //readers blocked by a writer
+    uint32_t policy;
+    uint8_t padding[CACHE_LINE_SIZE - 12];
+    rw_numa_readers_t readers[MAX_SOCKETS];
+} rw_numa_lock_t;
+
+//the socket of the thread
+typedef uint32_t rw_numa_local_params;
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+rw_numa_lock_t* init_rw_numa_array_global(uint32_t num_locks);
+
+rw_numa_local_params* init_rw_numa_array_local(uint32_t thread_num, uint32_t num_locks);
+
+void end_rw_numa_array_local(rw_numa_local_params* local_params);
+
+void end_rw_numa_array_global(rw_numa_lock_t* the_locks);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_rw_numa_global(rw_numa_lock_t* the_lock);
+
+int init_rw_numa_local(uint32_t thread_num, rw_numa_local_params* local_d);
+
+void end_rw_numa_local(rw_numa_local_params local_d);
+
+void end_rw_numa_global(rw_numa_lock_t the_lock);
+
+//RW_NUMA_WRITER_PREF or RW_NUMA_NEUTRAL
+void rw_numa_set_policy(rw_numa_lock_t* the_lock, uint32_t policy);
+
+/*
+ *  Acquire and release methods
+ */
+
+void rw_numa_read_acquire(rw_numa_lock_t* lock, rw_numa_local_params* local_d);
+
+void rw_numa_read_release(rw_numa_lock_t* lock, rw_numa_local_params* local_d);
+
+void rw_numa_write_acquire(rw_numa_lock_t* lock);
+
+void rw_numa_write_release(rw_numa_lock_t* lock);
+
+//write lock; returns 0 on success, 1 otherwise
+int rw_numa_write_trylock(rw_numa_lock_t* lock);
+
+int is_free_rw_numa(rw_numa_lock_t* lock);
+
+#endif
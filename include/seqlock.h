@@ -0,0 +1,101 @@
+/*
+ * File: seqlock.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Sequence lock: a counter that is odd while a writer updates the
+ *      protected data. Readers do not write anything: they read the counter,
+ *      read the data, and retry if the counter changed in between. The
+ *      writers must be serialized by another lock, e.g. any lock of
+ *      lock_if.h through acquire_seq_write/release_seq_write.
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _SEQLOCK_H_
+#define _SEQLOCK_H_
+
+#include <stdint.h>
+#include "utils.h"
+#include "atomic_ops.h"
+
+//orders the accesses to the counter and to the data; loads are not reordered
+//with loads, nor stores with stores on x86, so the compiler barrier suffices there
+#if defined(__sparc__) || defined(__tile__)
+#  define SEQLOCK_BARRIER MEM_BARRIER
+#else
+#  define SEQLOCK_BARRIER COMPILER_BARRIER
+#endif
+
+typedef struct seqlock {
+    volatile uint32_t seq;
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 4];
+#endif
+} seqlock_t;
+
+static inline void seqlock_init(seqlock_t* sl) {
+    sl->seq = 0;
+    MEM_BARRIER;
+}
+
+/*
+ *  Readers: the copy made between read_begin and read_retry may be
+ *  inconsistent, and can only be used once read_retry returned 0, e.g.
+ *
+ *      do {
+ *          seq = seqlock_read_begin(&sl);
+ *          copy = data;
+ *      } while (seqlock_read_retry(&sl, seq));
+ */
+
+//waits until no writer is active and returns the counter
+static inline uint32_t seqlock_read_begin(seqlock_t* sl) {
+    uint32_t seq;
+    while ((seq = sl->seq) & 1) {
+        PAUSE;
+    }
+    SEQLOCK_BARRIER;
+    return seq;
+}
+
+//returns 1 if a writer started since seqlock_read_begin returned seq
+static inline int seqlock_read_retry(seqlock_t* sl, uint32_t seq) {
+    SEQLOCK_BARRIER;
+    return sl->seq != seq;
+}
+
+/*
+ *  Writers, serialized by the caller
+ */
+
+static inline void seqlock_write_begin(seqlock_t* sl) {
+    sl->seq++;
+    SEQLOCK_BARRIER;
+}
+
+static inline void seqlock_write_end(seqlock_t* sl) {
+    SEQLOCK_BARRIER;
+    sl->seq++;
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * File: shfl.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Shuffling lock (ShflLock, Kashyap et al., SOSP 2019) in 32 bits: a
+ *      locked byte and the tail of an MCS queue of per-thread nodes, as in
+ *      qspin.h. The waiters reorder the queue while they wait, off the
+ *      critical path: one of them, the shuffler, moves the waiters that a
+ *      policy groups with it (same socket by default, or same priority or
+ *      class) right behind itself, and hands the role to the last one it
+ *      moved. At most SHFL_MAX_BATCH waiters pass the others before the
+ *      role is reset. There is no per-lock local data.
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _SHFL_H_
+#define _SHFL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <assert.h>
+#include "utils.h"
+#include "atomic_ops.h"
+#include "qtail.h"
+
+//waiters moved ahead of the others before the shuffler role starts over
+#ifndef SHFL_MAX_BATCH
+#  define SHFL_MAX_BATCH 64
+#endif
+#define SHFL_POLICY_ENV "LIBSLOCK_SHFL_POLICY"
+
+//layout of the lock word
+#define SHFL_LOCKED        0x1U
+#define SHFL_LOCKED_MASK   0xffU
+#define SHFL_TAIL_MASK     QTAIL_MASK
+
+//status of a queue node
+#define SHFL_WAIT 0
+#define SHFL_HEAD 1
+
+typedef struct shfl_lock {
+    union {
+        volatile uint32_t val;
+        struct {
+#ifdef __sparc__
+            volatile uint16_t tail;
+            volatile uint8_t unused;
+            volatile uint8_t locked;
+#else
+            volatile uint8_t locked;
+            volatile uint8_t unused;
+            volatile uint16_t tail;
+#endif
+        };
+    };
+#ifdef ADD_PADDING
+    uint8_t padding[CACHE_LINE_SIZE - 4];
+#endif
+} shfl_lock_t;
+
+typedef struct shfl_node {
+    struct shfl_node* volatile next;
+    volatile uint32_t status;   //SHFL_HEAD once the predecessor left the queue
+    volatile uint32_t shuffler; //set on the one waiter that may reorder the queue
+    volatile uint32_t batch;    //waiters moved ahead of the others so far
+    uint32_t socket;
+    uint32_t key;               //priority or class of the thread
+    uint8_t padding[CACHE_LINE_SIZE - 28];
+} shfl_node_t;
+
+//returns 1 if waiter should be moved behind shuffler
+typedef int (*shfl_policy_t)(shfl_node_t* shuffler, shfl_node_t* waiter);
+
+//same socket
+int shfl_policy_numa(shfl_node_t* shuffler, shfl_node_t* waiter);
+//key at least that of the shuffler
+int shfl_policy_priority(shfl_node_t* shuffler, shfl_node_t* waiter);
+//same key
+int shfl_policy_class(shfl_node_t* shuffler, shfl_node_t* waiter);
+
+//policy of all the shfl locks; numa by default, or LIBSLOCK_SHFL_POLICY=numa|priority|class
+void shfl_set_policy(shfl_policy_t policy);
+//priority or class of the calling thread (0 by default)
+void shfl_set_key(uint32_t key);
+
+/*
+ *  Methods for easy lock array manipulation
+ */
+
+shfl_lock_t* init_shfl_array_global(uint32_t num_locks);
+
+void init_shfl_array_local(uint32_t thread_num);
+
+//returns the thread id (qtail.h)
+void end_shfl_array_local();
+
+void end_shfl_array_global(shfl_lock_t* the_locks);
+
+/*
+ *  Single lock manipulation
+ */
+
+int init_shfl_global(shfl_lock_t* the_lock);
+
+int init_shfl_local(uint32_t thread_num);
+
+//returns the thread id (qtail.h)
+void end_shfl_local();
+
+void end_shfl_global(shfl_lock_t the_lock);
+
+/*
+ *  Acquire and release methods
+ */
+
+void shfl_acquire(shfl_lock_t* lock);
+
+void shfl_release(shfl_lock_t* lock);
+
+//returns 0 on success, 1 otherwise
+int shfl_trylock(shfl_lock_t* lock);
+
+int is_free_shfl(shfl_lock_t* lock);
+
+//0 if the lock is free, 1 if it is held, 2 if threads are queued
+uint32_t shfl_queue_length(shfl_lock_t* lock);
+
+#endif
@@ -47,12 +47,26 @@
 #include <pthread.h>
 #include "utils.h"
 #include "atomic_ops.h"
+#ifdef SPIN_THEN_PARK
+#include "park.h"
+#endif
 
 /* setting of the back-off based on the length of the queue */
 #define TICKET_BASE_WAIT 512
 #define TICKET_MAX_WAIT  4095
 #define TICKET_WAIT_NEXT 128
 
+/* on x86 the back-off is a number of cycles (the nops above, on a machine whose nop
+   takes NOP_DURATION cycles), converted to nops with the nop duration measured at startup */
+#ifndef TICKET_BASE_WAIT_CYCLES
+#  define TICKET_BASE_WAIT_CYCLES (TICKET_BASE_WAIT * NOP_DURATION)
+#endif
+#ifndef TICKET_WAIT_NEXT_CYCLES
+#  define TICKET_WAIT_NEXT_CYCLES (TICKET_WAIT_NEXT * NOP_DURATION)
+#endif
+/* environment variable overriding TICKET_BASE_WAIT_CYCLES; 0 spins without back-off */
+#define TICKET_BACKOFF_ENV "LIBSLOCK_TICKET_BACKOFF"
+
 #define TICKET_ON_TW0_CLS 0	/* Put the head and the tail on separate 
                                cache lines (O: not, 1: do)*/
 typedef struct ticketlock_t 
@@ -62,8 +76,15 @@ typedef struct ticketlock_t
     uint8_t padding0[CACHE_LINE_SIZE - 4];
 #endif
     volatile uint32_t tail;
+#ifdef SPIN_THEN_PARK
+    volatile uint32_t parked; //number of sleeping waiters
+#endif
 #ifdef ADD_PADDING
+#  ifdef SPIN_THEN_PARK
+    uint8_t padding1[CACHE_LINE_SIZE - 12];
+#  else
     uint8_t padding1[CACHE_LINE_SIZE - 8];
+#  endif
 #  if TICKET_ON_TW0_CLS == 1
     uint8_t padding2[4];
 #  endif
@@ -82,6 +103,11 @@ ticketlock_t* init_ticketlocks(uint32_t num_locks);
 void init_thread_ticketlocks(uint32_t thread_num);
 void free_ticketlocks(ticketlock_t* the_locks);
 
+/* measures the duration of a nop and sets the x86 back-off; called once by the init functions */
+void ticket_calibrate();
+/* back-off per waiter ahead, in cycles (the next waiter waits base_cycles / 4); 0 disables it */
+void ticket_set_backoff(ticks base_cycles);
+
 #if defined(MEASURE_CONTENTION)
 extern void ticket_print_contention_stats(void);
 double ticket_avg_queue(void);
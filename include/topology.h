@@ -0,0 +1,100 @@
+/*
+ * File: topology.h
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Topology of the machine (sockets, NUMA nodes, last level caches,
+ *      hardware threads), discovered at startup from /sys/devices/system;
+ *      used by the DEFAULT platform instead of hard-coded tables
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TOPOLOGY_H_
+#define _TOPOLOGY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOPOLOGY_MAX_CPUS 1024
+//sockets beyond this number share the cluster of socket (id % TOPOLOGY_MAX_SOCKETS)
+#define TOPOLOGY_MAX_SOCKETS 16
+
+typedef struct topology {
+    uint32_t num_cpus;        //number of hardware threads
+    uint32_t num_sockets;
+    uint32_t num_nodes;       //highest NUMA node id + 1
+    uint32_t num_llcs;
+    uint32_t num_cores;       //number of physical cores
+    uint32_t cpus_per_socket; //hardware threads of the largest socket
+    int16_t cpu_socket[TOPOLOGY_MAX_CPUS];  //dense socket index of each cpu
+    int16_t cpu_node[TOPOLOGY_MAX_CPUS];    //NUMA node of each cpu
+    int16_t cpu_llc[TOPOLOGY_MAX_CPUS];     //dense last level cache index of each cpu
+    int16_t cpu_core[TOPOLOGY_MAX_CPUS];    //dense physical core index of each cpu
+    uint8_t cpu_smt[TOPOLOGY_MAX_CPUS];     //index of the cpu among its SMT siblings
+    int16_t socket_node[TOPOLOGY_MAX_SOCKETS]; //NUMA node holding the memory of a socket
+    //thread placement: sockets one after the other, SMT siblings after all the cores;
+    //entries beyond num_cpus wrap around
+    uint16_t cores[TOPOLOGY_MAX_CPUS];
+} topology_t;
+
+extern topology_t topology;
+
+//reads the topology; called automatically at startup, further calls do nothing
+void topology_init();
+
+//prints the detected topology
+void topology_print(FILE* f);
+
+static inline int topology_socket(int cpu) {
+    return topology.cpu_socket[cpu % TOPOLOGY_MAX_CPUS];
+}
+
+static inline int topology_node(int cpu) {
+    return topology.cpu_node[cpu % TOPOLOGY_MAX_CPUS];
+}
+
+static inline int topology_llc(int cpu) {
+    return topology.cpu_llc[cpu % TOPOLOGY_MAX_CPUS];
+}
+
+static inline int topology_core(int cpu) {
+    return topology.cpu_core[cpu % TOPOLOGY_MAX_CPUS];
+}
+
+static inline int topology_smt(int cpu) {
+    return topology.cpu_smt[cpu % TOPOLOGY_MAX_CPUS];
+}
+
+static inline int topology_socket_node(int socket) {
+    return topology.socket_node[socket % TOPOLOGY_MAX_SOCKETS];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -44,25 +44,42 @@
 #include <pthread.h>
 #include "atomic_ops.h"
 #include "utils.h"
+#ifdef SPIN_THEN_PARK
+#include "park.h"
+#endif
 
 
 #define MIN_DELAY 100
 #define MAX_DELAY 1000
 
 typedef volatile uint32_t ttas_index_t;
-#ifdef __tile__
-typedef uint32_t ttas_lock_data_t;
+#if defined(__tile__) || defined(SPIN_THEN_PARK)
+typedef uint32_t ttas_lock_data_t; //futexes need 32 bits
 #else
 typedef uint8_t ttas_lock_data_t;
 #endif
 
+//the contention estimate of a lock is the average number of failed attempts per
+//acquisition, in 1/(1 << TTAS_EST_SHIFT); a new acquisition weighs 1/(1 << TTAS_EST_WEIGHT)
+#define TTAS_EST_SHIFT 4
+#define TTAS_EST_WEIGHT 3
+#define TTAS_EST_MAX 0xffff
+
+//4 bytes without ADD_PADDING (8 with a 32-bit lock word), so arrays of locks stay compact.
+//The estimate shares the line of the lock word: an acquisition that changes it costs
+//the holder one more store on the line the waiters spin on (ttas_learn skips the
+//store when the estimate is unchanged, as it is under a steady load).
 typedef struct ttas_lock_t {
     union {
-        ttas_lock_data_t lock;
+        struct {
+            ttas_lock_data_t lock;
+#if !defined(__tile__) && !defined(SPIN_THEN_PARK)
+            uint8_t unused;
+#endif
+            volatile uint16_t contention; //written by the holder only
+        };
 #ifdef ADD_PADDING
         uint8_t padding[CACHE_LINE_SIZE];
-#else
-        uint8_t padding;
 #endif
     };
 }ttas_lock_t;
@@ -76,10 +93,31 @@ static inline uint32_t backoff(uint32_t limit) {
 
 }
 
+//first back-off bound of an acquisition: a waiter expecting k failed attempts
+//starts where k doublings would have taken it
+static inline uint32_t ttas_start_limit(ttas_lock_t* the_lock) {
+    uint32_t k = the_lock->contention >> TTAS_EST_SHIFT;
+    if (k >= 10) return MAX_DELAY;
+    uint32_t limit = 1U << k;
+    return limit < MAX_DELAY ? limit : MAX_DELAY;
+}
+
+//called by the holder with the number of failed attempts of its acquisition
+static inline void ttas_learn(ttas_lock_t* the_lock, uint32_t failures) {
+    int32_t est = the_lock->contention;
+    int32_t sample = (failures > (TTAS_EST_MAX >> TTAS_EST_SHIFT)) ? TTAS_EST_MAX : (int32_t) (failures << TTAS_EST_SHIFT);
+    int32_t next = est + ((sample - est) >> TTAS_EST_WEIGHT);
+    if (next != est) {
+        the_lock->contention = (uint16_t) next;
+    }
+}
+
 /*
  *  Lock acquire and release methods
  */
 
+//the back-off adapts to the contention of the lock (ttas_start_limit);
+//limit is kept for compatibility and not used
 void ttas_lock(ttas_lock_t* the_lock, uint32_t* limit);
 
 int ttas_trylock(ttas_lock_t* the_lock, uint32_t* limit);
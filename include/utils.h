@@ -137,7 +137,7 @@ extern "C" {
         cpu_set_t mask;
         CPU_ZERO(&mask);
         CPU_SET(cpu, &mask);
-        numa_set_preferred(get_cluster(cpu));
+        numa_set_preferred(get_numa_node(cpu));
         pthread_t thread = pthread_self();
         if (pthread_setaffinity_np(thread, sizeof(cpu_set_t), &mask) != 0) {
             fprintf(stderr, "Error setting thread affinity\n");
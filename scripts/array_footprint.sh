@@ -0,0 +1,36 @@
+#!/bin/sh
+
+# compares the memory used by the array locks with fixed slots (ARRAY), with a
+# growing ring of slots (ARRAY_DYN), and by the array locks with pooled nodes
+# (ARRAY, POOL=1), as reported by test_array_alloc
+# usage: ./scripts/array_footprint.sh [num locks] [num threads], e.g. 10000 8
+
+NUM_LOCKS=${1:-10000}
+NUM_THREADS=${2:-8}
+DURATION=500
+
+MAKE="";
+UNAME=`uname`;
+if [ $UNAME = "Linux" ];
+then
+    MAKE=make;
+else
+    MAKE=gmake;
+fi;
+
+run()
+{
+    touch Makefile;
+    $MAKE test_array_alloc LOCK_VERSION=-DUSE_$1_LOCKS POOL=$2 > /dev/null 2>&1;
+    out=`./test_array_alloc -l $NUM_LOCKS -n $NUM_THREADS -d $DURATION 2> /dev/null`;
+    global=`echo "$out" | grep "^Global data" | awk '{print $4}'`;
+    global_end=`echo "$out" | grep "^Global data" | awk '{print $9}'`;
+    local=`echo "$out" | grep "^Local data" | awk '{print $4}'`;
+    printf "%-14s %16s %16s %16s\n" $3 $global $global_end $local;
+}
+
+printf "#%d locks, %d threads\n" $NUM_LOCKS $NUM_THREADS;
+printf "%-14s %16s %16s %16s\n" "#lock" "global bytes" "after the run" "local bytes";
+run ARRAY 0 ARRAY;
+run ARRAY_DYN 0 ARRAY_DYN;
+run ARRAY 1 ARRAY_POOL;
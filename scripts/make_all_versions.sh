@@ -1,6 +1,6 @@
 #!/bin/sh
 
-LOCKS="USE_HCLH_LOCKS USE_SPINLOCK_LOCKS USE_TTAS_LOCKS USE_MCS_LOCKS USE_CLH_LOCKS USE_ARRAY_LOCKS USE_RW_LOCKS USE_TICKET_LOCKS USE_MUTEX_LOCKS USE_HTICKET_LOCKS"
+LOCKS="USE_HCLH_LOCKS USE_SPINLOCK_LOCKS USE_TTAS_LOCKS USE_MCS_LOCKS USE_CNA_LOCKS USE_HMCS_LOCKS USE_CLH_LOCKS USE_ARRAY_LOCKS USE_ARRAY_DYN_LOCKS USE_RW_LOCKS USE_RW_NUMA_LOCKS USE_TICKET_LOCKS USE_QSPIN_LOCKS USE_SHFL_LOCKS USE_MUTEX_LOCKS USE_HTICKET_LOCKS USE_COHORT_BO_MCS_LOCKS USE_COHORT_TKT_TKT_LOCKS USE_COHORT_MCS_MCS_LOCKS"
 
 MAKE="";
 UNAME=`uname`;
@@ -0,0 +1,34 @@
+#!/bin/sh
+
+# response time of stress_latency in the open loop (-r) against the offered
+# load, for a few locks: the median and the 99th percentile (in cycles) stay
+# flat until the load approaches what the lock can serve, then climb
+# usage: ./scripts/open_loop.sh [threads] [rates per thread] [locks], e.g. 16 "10000 100000 1000000" "TICKET MCS"
+
+NUM_THREADS=${1:-`nproc`}
+RATES=${2:-"10000 50000 100000 200000 500000 1000000"}
+LOCKS=${3:-"TICKET MCS"}
+DURATION=1000
+
+MAKE="";
+UNAME=`uname`;
+if [ $UNAME = "Linux" ];
+then
+    MAKE=make;
+else
+    MAKE=gmake;
+fi;
+
+printf "%-10s %12s %12s %12s %12s\n" "#lock" "offered/s" "completed/s" "resp_p50" "resp_p99";
+for lock in $LOCKS
+do
+    touch Makefile;
+    $MAKE stress_latency LOCK_VERSION=-DUSE_${lock}_LOCKS > /dev/null 2>&1;
+    for rate in $RATES
+    do
+        out=`./stress_latency -n $NUM_THREADS -d $DURATION -l 1 -r $rate 2> /dev/null`;
+        resp=`echo "$out" | grep "^response" | sed -e "s/.*p50=\([0-9]*\).*p99=\([0-9]*\).*/\1 \2/"`;
+        load=`echo "$out" | grep "^open loop" | sed -e "s/.*offered \([0-9]*\).*completed \([0-9]*\).*/\1 \2/"`;
+        printf "%-10s %12s %12s %12s %12s\n" $lock $load $resp;
+    done;
+done;
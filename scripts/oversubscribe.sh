@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# compares the throughput of the spinning locks, the same locks built with
+# PARK=1 (spin-then-park) and the pthread mutex when there are more threads
+# than hardware contexts
+# usage: ./scripts/oversubscribe.sh [threads per hw context...], e.g. 1 2 4
+
+LOCKS="TTAS TICKET MCS"
+FACTORS=${@:-"1 2 4"}
+DURATION=2000
+
+MAKE="";
+UNAME=`uname`;
+if [ $UNAME = "Linux" ];
+then
+    MAKE=make;
+else
+    MAKE=gmake;
+fi;
+
+build()
+{
+    touch Makefile;
+    $MAKE stress_test LOCK_VERSION=-DUSE_$1_LOCKS PARK=$2 > /dev/null 2>&1;
+    mv stress_test stress_test_$3;
+}
+
+BINS="mutex";
+build MUTEX 0 mutex;
+for lock in $LOCKS
+do
+    name=`echo $lock | tr "[:upper:]" "[:lower:]"`;
+    build $lock 0 $name;
+    build $lock 1 ${name}_park;
+    BINS="$BINS $name ${name}_park";
+done;
+
+printf "%-6s" "#x";
+for bin in $BINS
+do
+    printf " %12s" $bin;
+done;
+printf "\n";
+
+for f in $FACTORS
+do
+    printf "%-6s" $f;
+    for bin in $BINS
+    do
+        tp=`./stress_test_$bin -o $f -d $DURATION 2> /dev/null | tail -n1 | awk '{print $5}'`;
+        printf " %12s" $tp;
+    done;
+    printf "\n";
+done;
+
+for bin in $BINS
+do
+    rm -f stress_test_$bin;
+done;
@@ -0,0 +1,30 @@
+#!/bin/sh
+
+# compares the uncontended acquire/release latency of the statically selected
+# locks (uncontended) with the runtime selected ones (uncontended_rt)
+# usage: ./scripts/rt_overhead.sh [uncontended parameters], e.g. -r1 -d1000
+
+# every lock of the runtime name table (lock_rt_names in src/lock_rt.c)
+LOCKS=`sed -n '/lock_rt_names\[\] = {/,/};/p' src/lock_rt.c | grep -o '"[A-Z_]*"' | tr -d '"'`
+
+MAKE="";
+UNAME=`uname`;
+if [ $UNAME = "Linux" ];
+then
+    MAKE=make;
+else
+    MAKE=gmake;
+fi;
+
+touch Makefile;
+$MAKE uncontended_rt > /dev/null 2>&1;
+
+printf "%-16s %18s %18s\n" "#lock" "static acq/rel" "runtime acq/rel";
+for lock in $LOCKS
+do
+    touch Makefile;
+    $MAKE uncontended LOCK_VERSION=-DUSE_${lock}_LOCKS > /dev/null 2>&1;
+    st=`./uncontended $@ 2> /dev/null | tail -n1 | awk '{print $2"/"$3}'`;
+    rt=`LIBSLOCK_LOCK=$lock ./uncontended_rt $@ 2> /dev/null | tail -n1 | awk '{print $2"/"$3}'`;
+    printf "%-16s %18s %18s\n" $lock $st $rt;
+done;
@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# throughput (acquires/s) of the ticket lock from 1 to nproc threads, with the
+# calibrated proportional back-off, without back-off (LIBSLOCK_TICKET_BACKOFF=0),
+# and of the MCS lock for reference
+# usage: ./scripts/ticket_sweep.sh [max threads] [step], e.g. 64 4
+
+MAX_THREADS=${1:-`nproc`}
+STEP=${2:-1}
+DURATION=1000
+
+MAKE="";
+UNAME=`uname`;
+if [ $UNAME = "Linux" ];
+then
+    MAKE=make;
+else
+    MAKE=gmake;
+fi;
+
+build()
+{
+    touch Makefile;
+    $MAKE stress_test LOCK_VERSION=-DUSE_$1_LOCKS > /dev/null 2>&1;
+    mv stress_test stress_test_$2;
+}
+
+build TICKET ticket;
+build MCS mcs;
+
+printf "%-8s %12s %12s %12s\n" "#threads" "ticket" "no_backoff" "mcs";
+for n in `seq 1 $STEP $MAX_THREADS`
+do
+    tk=`./stress_test_ticket -n $n -d $DURATION 2> /dev/null | tail -n1 | awk '{print $5}'`;
+    nb=`LIBSLOCK_TICKET_BACKOFF=0 ./stress_test_ticket -n $n -d $DURATION 2> /dev/null | tail -n1 | awk '{print $5}'`;
+    mcs=`./stress_test_mcs -n $n -d $DURATION 2> /dev/null | tail -n1 | awk '{print $5}'`;
+    printf "%-8s %12s %12s %12s\n" $n $tk $nb $mcs;
+done;
+
+rm -f stress_test_ticket stress_test_mcs;
@@ -0,0 +1,210 @@
+/*
+ * File: alock_dyn.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ *      Implementation of the array lock with a growing ring of slots
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "alock_dyn.h"
+
+static inline size_t alock_dyn_ring_bytes(uint32_t size) {
+    return sizeof(alock_dyn_ring_t) + size * sizeof(alock_dyn_slot_t);
+}
+
+//a ring whose slots all hold grant
+static alock_dyn_ring_t* alock_dyn_ring_alloc(uint32_t size, uint32_t grant) {
+    alock_dyn_ring_t* ring;
+    size_t bytes = alock_dyn_ring_bytes(size);
+#if defined(PLATFORM_NUMA)
+    //the slots of a ring are used by the threads of every socket: spread its pages
+    //over the nodes rather than keeping them on the node of the thread growing it
+    if (bytes >= (size_t) numa_pagesize()) {
+        ring = (alock_dyn_ring_t*) numa_alloc_interleaved(bytes);
+        assert(ring != NULL);
+        ring->interleaved = 1;
+    } else
+#endif
+    {
+        ring = (alock_dyn_ring_t*) memalign(CACHE_LINE_SIZE, bytes);
+        assert(ring != NULL);
+        ring->interleaved = 0;
+    }
+    ring->size = size;
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        ring->slots[i].grant = grant;
+    }
+    return ring;
+}
+
+static void alock_dyn_ring_free(alock_dyn_ring_t* ring) {
+#if defined(PLATFORM_NUMA)
+    if (ring->interleaved) {
+        numa_free(ring, alock_dyn_ring_bytes(ring->size));
+        return;
+    }
+#endif
+    free(ring);
+}
+
+//called by the holder; the waiters that took their ticket before the new ring
+//was published may spin on the old one, so the releases write to both until
+//these waiters are served, and the last of them frees the old ring
+static void alock_dyn_grow(alock_dyn_lock_t* lock, alock_dyn_ring_t* ring, uint32_t ticket) {
+    //the slots only hold tickets already served, so no waiter enters by mistake
+    alock_dyn_ring_t* bigger = alock_dyn_ring_alloc(ring->size * 2, ticket);
+    lock->old_ring = ring;
+    MEM_BARRIER;
+    lock->ring = bigger;
+    MEM_BARRIER;
+    //a waiter reads the ring after taking its ticket
+    lock->old_until = lock->tail;
+}
+
+/*
+ *  Acquire and release methods
+ */
+
+void alock_dyn_acquire(alock_dyn_lock_t* lock) {
+    uint32_t ticket = FAI_U32(&lock->tail);
+    alock_dyn_ring_t* ring = lock->ring;
+    volatile uint32_t* grant = &ring->slots[ticket & (ring->size - 1)].grant;
+    while (*grant != ticket) {
+        PAUSE;
+    }
+    //more waiters than slots: they share slots, grow the ring
+    if ((lock->tail - ticket) > ring->size && ring->size < ALOCK_DYN_MAX_SLOTS && lock->old_ring == NULL) {
+        alock_dyn_grow(lock, ring, ticket);
+    }
+}
+
+void alock_dyn_release(alock_dyn_lock_t* lock) {
+    uint32_t next = lock->head + 1;
+    alock_dyn_ring_t* old = lock->old_ring;
+    if (old != NULL) {
+        if ((int32_t) (next - lock->old_until) < 0) {
+            old->slots[next & (old->size - 1)].grant = next;
+        } else {
+            //all the waiters of the old ring got the lock
+            lock->old_ring = NULL;
+            alock_dyn_ring_free(old);
+        }
+    }
+    alock_dyn_ring_t* ring = lock->ring;
+    lock->head = next;
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    COMPILER_BARRIER;
+    ring->slots[next & (ring->size - 1)].grant = next;
+}
+
+int alock_dyn_trylock(alock_dyn_lock_t* lock) {
+    uint32_t tail = lock->tail;
+    if (lock->head == tail) {
+        if (CAS_U32(&lock->tail, tail, tail + 1) == tail) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int is_free_alock_dyn(alock_dyn_lock_t* lock) {
+    if (lock->head == lock->tail) return 1;
+    return 0;
+}
+
+uint32_t alock_dyn_queue_length(alock_dyn_lock_t* lock) {
+    return lock->tail - lock->head;
+}
+
+uint32_t alock_dyn_size(alock_dyn_lock_t* lock) {
+    return lock->ring->size;
+}
+
+/*
+ *  Initialization
+ */
+
+static void alock_dyn_init(alock_dyn_lock_t* lock) {
+    lock->tail = 0;
+    lock->head = 0;
+    //ticket 0 enters by slot 0; the tickets of the other slots are not 0
+    lock->ring = alock_dyn_ring_alloc(ALOCK_DYN_INIT_SLOTS, 0);
+    lock->old_ring = NULL;
+    lock->old_until = 0;
+}
+
+alock_dyn_lock_t* init_alock_dyn_array_global(uint32_t num_locks) {
+    alock_dyn_lock_t* the_locks;
+    the_locks = (alock_dyn_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(alock_dyn_lock_t));
+    assert(the_locks != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        alock_dyn_init(&the_locks[i]);
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+void init_alock_dyn_array_local(uint32_t thread_num) {
+    set_cpu(thread_num);
+    MEM_BARRIER;
+}
+
+void end_alock_dyn_array_local() {
+    //method not needed
+}
+
+void end_alock_dyn_array_global(alock_dyn_lock_t* the_locks, uint32_t num_locks) {
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        end_alock_dyn_global(the_locks[i]);
+    }
+    free(the_locks);
+}
+
+int init_alock_dyn_global(alock_dyn_lock_t* the_lock) {
+    alock_dyn_init(the_lock);
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_alock_dyn_local(uint32_t thread_num) {
+    set_cpu(thread_num);
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_alock_dyn_local() {
+    //method not needed
+}
+
+void end_alock_dyn_global(alock_dyn_lock_t the_lock) {
+    if (the_lock.old_ring != NULL) {
+        alock_dyn_ring_free(the_lock.old_ring);
+    }
+    alock_dyn_ring_free(the_lock.ring);
+}
@@ -0,0 +1,142 @@
+/*
+ * File: bench.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of the benchmark harness
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "bench.h"
+
+void barrier_init(barrier_t *b, int n) {
+    b->crossing = 0;
+    b->episode = 0;
+    b->count = n;
+    MEM_BARRIER;
+}
+
+void barrier_cross(barrier_t *b) {
+    //the episode cannot change before this thread arrives
+    uint32_t episode = b->episode;
+    if (IAF_U32(&b->crossing) == b->count) {
+        b->crossing = 0;
+        MEM_BARRIER;
+        b->episode = episode + 1;
+        return;
+    }
+    uint32_t spins = 0;
+    while (b->episode == episode) {
+        if (++spins < BENCH_BARRIER_SPINS) {
+            PAUSE;
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+typedef struct bench_thread {
+    void* (*fn)(void*);
+    void* arg;
+    uint32_t core;
+} bench_thread_t;
+
+static void* bench_thread_start(void* data) {
+    bench_thread_t t = *(bench_thread_t*) data;
+    free(data);
+    set_cpu(t.core);
+    return t.fn(t.arg);
+}
+
+void bench_start_thread(pthread_t* thread, uint32_t core, void* (*fn)(void*), void* arg) {
+    bench_thread_t* t = (bench_thread_t*) malloc(sizeof(bench_thread_t));
+    t->fn = fn;
+    t->arg = arg;
+    t->core = core;
+    if (pthread_create(thread, NULL, bench_thread_start, t) != 0) {
+        fprintf(stderr, "Error creating thread\n");
+        exit(1);
+    }
+}
+
+void bench_join_threads(pthread_t* threads, uint32_t num_threads) {
+    uint32_t i;
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_join(threads[i], NULL) != 0) {
+            fprintf(stderr, "Error waiting for thread completion\n");
+            exit(1);
+        }
+    }
+}
+
+void* bench_alloc_slots(uint32_t num, size_t size) {
+    void* slots;
+    if (posix_memalign(&slots, CACHE_LINE_SIZE, num * size) != 0) {
+        return NULL;
+    }
+    memset(slots, 0, num * size);
+    return slots;
+}
+
+static void bench_catcher(int sig) {
+    static int nb = 0;
+    printf("CAUGHT SIGNAL %d\n", sig);
+    if (++nb >= 3)
+        exit(1);
+}
+
+void bench_catch_signals() {
+    if (signal(SIGHUP, bench_catcher) == SIG_ERR ||
+            signal(SIGINT, bench_catcher) == SIG_ERR ||
+            signal(SIGTERM, bench_catcher) == SIG_ERR) {
+        perror("signal");
+        exit(1);
+    }
+}
+
+int bench_run(barrier_t* start, int duration) {
+    struct timeval begin, end;
+    if (start != NULL) {
+        barrier_cross(start);
+    }
+    gettimeofday(&begin, NULL);
+    if (duration > 0) {
+        struct timespec timeout;
+        timeout.tv_sec = duration / 1000;
+        timeout.tv_nsec = (duration % 1000) * 1000000;
+        nanosleep(&timeout, NULL);
+    } else {
+        sigset_t block_set;
+        sigemptyset(&block_set);
+        sigsuspend(&block_set);
+    }
+    gettimeofday(&end, NULL);
+    return (end.tv_sec * 1000 + end.tv_usec / 1000) - (begin.tv_sec * 1000 + begin.tv_usec / 1000);
+}
@@ -0,0 +1,51 @@
+/*
+ * File: bravo.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Tables of the reader bias
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bravo.h"
+
+void* volatile bravo_vrt[BRAVO_VRT_SIZE];
+bravo_state_t bravo_states[BRAVO_LOCKS];
+
+__thread void* bravo_held_lock[BRAVO_MAX_NESTED];
+__thread uint32_t bravo_held_slot[BRAVO_MAX_NESTED];
+__thread uint32_t bravo_held = 0;
+__thread uint32_t bravo_thread_id = 0;
+
+static volatile uint32_t bravo_num_threads = 0;
+static volatile uint32_t bravo_full_reported = 0;
+
+uint32_t bravo_new_thread_id() {
+    return IAF_U32(&bravo_num_threads);
+}
+
+void bravo_table_full(void* lock) {
+    if (bravo_full_reported == 0 && CAS_U32(&bravo_full_reported, 0, 1) == 0) {
+        fprintf(stderr, "bravo: no free entry for lock %p, its readers take the slow path (BRAVO_LOCKS = %d)\n", lock, BRAVO_LOCKS);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * File: ccsynch.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of the CC-Synch combining lock
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ccsynch.h"
+
+void* ccsynch_execute(ccsynch_lock* L, ccsynch_local_params* my_qnode, ccsynch_fn fn, void* arg)
+{
+    ccsynch_qnode* next_node = *my_qnode;
+    next_node->next = NULL;
+    next_node->wait = 1;
+    next_node->completed = 0;
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    //our node becomes the tail; the request goes into the node of our predecessor
+    ccsynch_qnode* cur = (ccsynch_qnode*) SWAP_PTR((volatile void*) L, (void*) next_node);
+    cur->fn = fn;
+    cur->arg = arg;
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    cur->next = next_node;
+    *my_qnode = cur;
+
+    while (cur->wait) {
+        PAUSE;
+    }
+    if (cur->completed) {
+        //a combiner ran the request
+        return cur->ret;
+    }
+
+    //we are the combiner: run the requests announced behind us, ours first
+    ccsynch_qnode* tmp = cur;
+    ccsynch_qnode* tmp_next;
+    uint32_t counter = 0;
+    while ((tmp_next = (ccsynch_qnode*) tmp->next) != NULL && counter < CCSYNCH_MAX_COMBINE) {
+        counter++;
+#if defined(OPTERON_OPTIMIZE)
+        PREFETCHW(tmp_next);
+#endif
+        tmp->ret = tmp->fn(tmp->arg);
+        tmp->completed = 1;
+#ifdef __tile__
+        MEM_BARRIER;
+#endif
+        tmp->wait = 0;
+        tmp = tmp_next;
+    }
+    //the owner of tmp is the next combiner; if tmp is the tail, the next thread to queue is
+    tmp->wait = 0;
+    return cur->ret;
+}
+
+int is_free_ccsynch(ccsynch_lock* L)
+{
+    //the tail node is the only one not announcing a request
+    if ((*L)->wait == 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  Initialization
+ */
+
+static ccsynch_qnode* alloc_ccsynch_qnode()
+{
+    ccsynch_qnode* a_node = (ccsynch_qnode*) memalign(CACHE_LINE_SIZE, sizeof(ccsynch_qnode));
+    a_node->fn = NULL;
+    a_node->arg = NULL;
+    a_node->ret = NULL;
+    a_node->wait = 0;
+    a_node->completed = 0;
+    a_node->next = NULL;
+    return a_node;
+}
+
+ccsynch_global_params* init_ccsynch_array_global(uint32_t num_locks) {
+    ccsynch_global_params* the_params;
+    the_params = (ccsynch_global_params*) malloc(num_locks * sizeof(ccsynch_global_params));
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        the_params[i].the_lock = (ccsynch_lock*) malloc(sizeof(ccsynch_lock));
+        *(the_params[i].the_lock) = alloc_ccsynch_qnode();
+    }
+    MEM_BARRIER;
+    return the_params;
+}
+
+ccsynch_local_params* init_ccsynch_array_local(uint32_t thread_num, uint32_t num_locks) {
+    set_cpu(thread_num);
+
+    uint32_t i;
+    ccsynch_local_params* local_params = (ccsynch_local_params*) malloc(num_locks * sizeof(ccsynch_local_params));
+    for (i = 0; i < num_locks; i++) {
+        local_params[i] = alloc_ccsynch_qnode();
+    }
+    MEM_BARRIER;
+    return local_params;
+}
+
+void end_ccsynch_array_local(ccsynch_local_params* the_params, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free(the_params[i]);
+    }
+    free(the_params);
+}
+
+void end_ccsynch_array_global(ccsynch_global_params* the_locks, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free((void*) *(the_locks[i].the_lock));
+        free(the_locks[i].the_lock);
+    }
+    free(the_locks);
+}
+
+int init_ccsynch_global(ccsynch_global_params* the_params) {
+    the_params->the_lock = (ccsynch_lock*) malloc(sizeof(ccsynch_lock));
+    *(the_params->the_lock) = alloc_ccsynch_qnode();
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_ccsynch_local(uint32_t thread_num, ccsynch_local_params* local_params) {
+    set_cpu(thread_num);
+    *local_params = alloc_ccsynch_qnode();
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_ccsynch_local(ccsynch_local_params the_params) {
+    free(the_params);
+}
+
+void end_ccsynch_global(ccsynch_global_params the_lock) {
+    //the tail node belongs to the lock once no request is pending
+    free((void*) *(the_lock.the_lock));
+    free(the_lock.the_lock);
+}
@@ -50,8 +50,16 @@ volatile clh_qnode* clh_acquire(clh_lock *L, clh_qnode* I )
 #if defined(OPTERON_OPTIMIZE)
     PREFETCHW(pred);
 #endif	/* OPTERON_OPTIMIZE */
-    while (pred->locked != 0) 
+    uint8_t state;
+    while ((state = pred->locked) != 0) 
     {
+        if (state == CLH_ABANDONED) {
+            /* the waiter of pred gave up: wait on its predecessor */
+            clh_qnode_ptr pred_pred = pred->pred;
+            free((void*) pred);
+            pred = pred_pred;
+            continue;
+        }
         PAUSE;
 #if defined(OPTERON_OPTIMIZE)
         pause_rep(23);
@@ -62,6 +70,43 @@ volatile clh_qnode* clh_acquire(clh_lock *L, clh_qnode* I )
     return pred;
 }
 
+int clh_acquire_timeout(clh_lock* L, clh_qnode** my_qnode, clh_qnode** my_pred, ticks timeout)
+{
+    clh_qnode* I = *my_qnode;
+    I->locked=1;
+#ifdef  __tile__
+    MEM_BARRIER;
+#endif
+    clh_qnode_ptr pred = (clh_qnode*) SWAP_PTR((volatile void*) (L), (void*) I);
+    ticks start = getticks();
+    uint8_t state;
+    while ((state = pred->locked) != 0) 
+    {
+        if (state == CLH_ABANDONED) {
+            clh_qnode_ptr pred_pred = pred->pred;
+            free((void*) pred);
+            pred = pred_pred;
+            continue;
+        }
+        if ((getticks() - start) > timeout) {
+            I->pred = pred;
+            if (CAS_PTR(L, I, pred) == I) {
+                /* nobody queued behind us: the node is still ours */
+                I->locked = 0;
+                return 1;
+            }
+            /* the successor takes over pred and the node */
+            I->locked = CLH_ABANDONED;
+            *my_qnode = (clh_qnode*) malloc(sizeof(clh_qnode));
+            (*my_qnode)->locked = 0;
+            return 1;
+        }
+        PAUSE;
+    }
+    *my_pred = (clh_qnode*) pred;
+    return 0;
+}
+
 clh_qnode* clh_release(clh_qnode *my_qnode, clh_qnode * my_pred) {
     COMPILER_BARRIER;
 #ifdef __tile__
@@ -0,0 +1,238 @@
+/*
+ * File: cna.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description: 
+ *      CNA lock implementation
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+
+#include "cna.h"
+
+int cna_trylock(cna_lock *L, cna_qnode_ptr I) {
+    I->next = NULL;
+    I->spin = CNA_WAITING;
+#ifdef  __tile__
+    MEM_BARRIER;
+#endif
+    if (CAS_PTR(L, NULL, I) != NULL) return 1;
+    I->handoffs = 0;
+    I->spin = CNA_GRANTED;
+    return 0;
+}
+
+void cna_acquire(cna_lock *L, cna_qnode_ptr I) 
+{
+    I->next = NULL;
+    I->spin = CNA_WAITING; // word on which to spin; nobody sees I before the swap
+#ifdef  __tile__
+    MEM_BARRIER;
+#endif
+    cna_qnode_ptr pred = (cna_qnode*) SWAP_PTR((volatile void*) L, (void*) I);
+    if (pred == NULL) {		/* lock was free */
+        I->handoffs = 0;
+        I->spin = CNA_GRANTED;
+        return;
+    }
+    pred->next = I; // make pred point to me
+
+#if defined(OPTERON_OPTIMIZE)
+    PREFETCHW(I);
+#endif	/* OPTERON_OPTIMIZE */
+    while (I->spin == CNA_WAITING) 
+    {
+        PAUSE;
+#if defined(OPTERON_OPTIMIZE)
+        pause_rep(23);
+        PREFETCHW(I);
+#endif	/* OPTERON_OPTIMIZE */
+    }
+}
+
+//looks for a waiter of the socket of I, starting at next; the remote waiters
+//in front of it are moved to the tail of the secondary queue of I
+static inline cna_qnode_ptr cna_find_successor(cna_qnode_ptr I, cna_qnode_ptr next) {
+    uint32_t my_socket = I->socket;
+    if (next->socket == my_socket) return next;
+
+    cna_qnode_ptr sec_head = next;
+    cna_qnode_ptr sec_tail = next;
+    cna_qnode_ptr cur = next->next;
+    while (cur != NULL) {
+        if (cur->socket == my_socket) {
+            if (I->spin != CNA_GRANTED) {
+                cna_qnode_ptr old_head = (cna_qnode_ptr) I->spin;
+                old_head->sec_tail->next = sec_head;
+                old_head->sec_tail = sec_tail;
+            } else {
+                sec_head->sec_tail = sec_tail;
+                I->spin = (uintptr_t) sec_head;
+            }
+            sec_tail->next = NULL; // sec_tail is before cur, so not the tail of the main queue
+            return cur;
+        }
+        sec_tail = cur;
+        cur = cur->next;
+    }
+    return NULL;
+}
+
+void cna_release(cna_lock *L, cna_qnode_ptr I) 
+{
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+
+    cna_qnode_ptr succ;
+#if defined(OPTERON_OPTIMIZE)
+    PREFETCHW(I);
+#endif	/* OPTERON_OPTIMIZE */
+    if (!(succ = I->next)) /* I seem to have no succ. */
+    { 
+        if (I->spin == CNA_GRANTED) {
+            /* try to fix global pointer */
+            if (CAS_PTR(L, I, NULL) == I) 
+                return;
+        } else {
+            /* the secondary queue becomes the main queue */
+            cna_qnode_ptr sec_head = (cna_qnode_ptr) I->spin;
+            if (CAS_PTR(L, I, sec_head->sec_tail) == I) {
+                sec_head->handoffs = 0;
+                sec_head->spin = CNA_GRANTED;
+                return;
+            }
+        }
+        do {
+            succ = I->next;
+            PAUSE;
+        } while (!succ); // wait for successor
+    }
+
+    if (I->handoffs < CNA_MAX_HANDOFFS) {
+        cna_qnode_ptr local = cna_find_successor(I, succ);
+        if (local != NULL) {
+            local->handoffs = I->handoffs + 1;
+            local->spin = I->spin; // pass the secondary queue along
+            return;
+        }
+    }
+
+    if (I->spin != CNA_GRANTED) {
+        /* no local waiter left, or too many local hand-offs: the secondary queue goes first */
+        cna_qnode_ptr sec_head = (cna_qnode_ptr) I->spin;
+        sec_head->sec_tail->next = succ;
+        succ = sec_head;
+    }
+    succ->handoffs = 0;
+    succ->spin = CNA_GRANTED;
+}
+
+int is_free_cna(cna_lock *L ){
+    if ((*L) == NULL) return 1;
+    return 0;
+}
+
+/*
+   Methods for easy lock array manipulation
+   */
+
+cna_global_params* init_cna_array_global(uint32_t num_locks) {
+    uint32_t i;
+    cna_global_params* the_locks = (cna_global_params*)malloc(num_locks * sizeof(cna_global_params));
+    for (i=0;i<num_locks;i++) {
+        the_locks[i].the_lock=(cna_lock*)malloc(sizeof(cna_lock));
+        *(the_locks[i].the_lock)=0;
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+static cna_qnode* alloc_cna_qnode(uint32_t socket) {
+    cna_qnode* the_qnode = (cna_qnode*)malloc(sizeof(cna_qnode));
+    the_qnode->spin = CNA_WAITING;
+    the_qnode->next = NULL;
+    the_qnode->sec_tail = NULL;
+    the_qnode->handoffs = 0;
+    the_qnode->socket = socket;
+    return the_qnode;
+}
+
+cna_qnode** init_cna_array_local(uint32_t thread_num, uint32_t num_locks) {
+    set_cpu(thread_num);
+
+    //init its qnodes
+    uint32_t i;
+    uint32_t socket = get_cluster(thread_num);
+    cna_qnode** the_qnodes = (cna_qnode**)malloc(num_locks * sizeof(cna_qnode*));
+    for (i=0;i<num_locks;i++) {
+        the_qnodes[i]=alloc_cna_qnode(socket);
+    }
+    MEM_BARRIER;
+    return the_qnodes;
+
+}
+
+void end_cna_array_local(cna_qnode** the_qnodes, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free(the_qnodes[i]);
+    }
+    free(the_qnodes);
+}
+
+void end_cna_array_global(cna_global_params* the_locks, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free(the_locks[i].the_lock);
+    }
+    free(the_locks); 
+}
+
+int init_cna_global(cna_global_params* the_lock) {
+    the_lock->the_lock=(cna_lock*)malloc(sizeof(cna_lock));
+    *(the_lock->the_lock)=0;
+    MEM_BARRIER;
+    return 0;
+}
+
+
+int init_cna_local(uint32_t thread_num, cna_qnode** the_qnode) {
+    set_cpu(thread_num);
+
+    (*the_qnode)=alloc_cna_qnode(get_cluster(thread_num));
+
+    MEM_BARRIER;
+    return 0;
+
+}
+
+void end_cna_local(cna_qnode* the_qnodes) {
+    free(the_qnodes);
+}
+
+void end_cna_global(cna_global_params the_locks) {
+    free(the_locks.the_lock);
+}
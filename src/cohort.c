@@ -0,0 +1,298 @@
+/*
+ * File: cohort.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of cohort locks on top of the ttas, ticket and mcs locks
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cohort.h"
+
+__thread uint32_t cohort_node_mine;
+
+/*
+ *  Global lock; any thread of the socket holding it may release it
+ */
+
+static inline void cohort_global_acquire(cohort_lock_t* the_lock, cohort_local_t* local, uint32_t* limit) {
+    switch (the_lock->global_type) {
+        case COHORT_GLOBAL_BO:
+            ttas_lock(&the_lock->global.bo, limit);
+            break;
+        case COHORT_GLOBAL_TKT:
+            ticket_acquire(&the_lock->global.ticket);
+            break;
+        default:
+            mcs_acquire(&the_lock->global.mcs, &local->global_qnode);
+            break;
+    }
+}
+
+static inline int cohort_global_trylock(cohort_lock_t* the_lock, cohort_local_t* local, uint32_t* limit) {
+    switch (the_lock->global_type) {
+        case COHORT_GLOBAL_BO:
+            return ttas_trylock(&the_lock->global.bo, limit);
+        case COHORT_GLOBAL_TKT:
+            return ticket_trylock(&the_lock->global.ticket);
+        default:
+            return mcs_trylock(&the_lock->global.mcs, &local->global_qnode);
+    }
+}
+
+static inline void cohort_global_release(cohort_lock_t* the_lock, cohort_local_t* local) {
+    switch (the_lock->global_type) {
+        case COHORT_GLOBAL_BO:
+            ttas_unlock(&the_lock->global.bo);
+            break;
+        case COHORT_GLOBAL_TKT:
+            ticket_release(&the_lock->global.ticket);
+            break;
+        default:
+            mcs_release(&the_lock->global.mcs, &local->global_qnode);
+            break;
+    }
+}
+
+/*
+ *  Local lock of a socket
+ */
+
+static inline void cohort_local_acquire(cohort_lock_t* the_lock, cohort_local_t* local, mcs_qnode* my_qnode) {
+    if (the_lock->local_type == COHORT_LOCAL_MCS) {
+        mcs_acquire(&local->mcs, my_qnode);
+    } else {
+        ticket_acquire(&local->ticket);
+    }
+}
+
+static inline int cohort_local_trylock(cohort_lock_t* the_lock, cohort_local_t* local, mcs_qnode* my_qnode) {
+    if (the_lock->local_type == COHORT_LOCAL_MCS) {
+        return mcs_trylock(&local->mcs, my_qnode);
+    }
+    return ticket_trylock(&local->ticket);
+}
+
+static inline void cohort_local_release(cohort_lock_t* the_lock, cohort_local_t* local, mcs_qnode* my_qnode) {
+    if (the_lock->local_type == COHORT_LOCAL_MCS) {
+        mcs_release(&local->mcs, my_qnode);
+    } else {
+        ticket_release(&local->ticket);
+    }
+}
+
+//whether other threads of the socket wait for the local lock
+static inline int cohort_local_waiters(cohort_lock_t* the_lock, cohort_local_t* local, mcs_qnode* my_qnode) {
+    if (the_lock->local_type == COHORT_LOCAL_MCS) {
+        return (my_qnode->next != NULL) || (local->mcs != my_qnode);
+    }
+    return local->ticket.tail != local->ticket.head;
+}
+
+/*
+ *  Acquire and release methods
+ */
+
+void cohort_acquire(cohort_lock_t* the_lock, cohort_local_params* local_d) {
+    cohort_local_t* local = the_lock->local[cohort_node_mine];
+    cohort_local_acquire(the_lock, local, local_d->my_qnode);
+    if (local->top_granted) {
+        //the global lock was passed by the previous owner from this socket
+        local->top_granted = 0;
+        return;
+    }
+    cohort_global_acquire(the_lock, local, &local_d->limit);
+}
+
+void cohort_release(cohort_lock_t* the_lock, cohort_local_params* local_d) {
+    cohort_local_t* local = the_lock->local[cohort_node_mine];
+    if (local->handoffs < the_lock->max_handoffs &&
+            cohort_local_waiters(the_lock, local, local_d->my_qnode)) {
+        local->handoffs++;
+        local->top_granted = 1;
+        COMPILER_BARRIER;
+    } else {
+        local->handoffs = 0;
+        cohort_global_release(the_lock, local);
+    }
+    cohort_local_release(the_lock, local, local_d->my_qnode);
+}
+
+int cohort_trylock(cohort_lock_t* the_lock, cohort_local_params* local_d) {
+    cohort_local_t* local = the_lock->local[cohort_node_mine];
+    if (cohort_local_trylock(the_lock, local, local_d->my_qnode) != 0) {
+        return 1;
+    }
+    //the local lock was free, so the global lock was not passed to us
+    if (cohort_global_trylock(the_lock, local, &local_d->limit) != 0) {
+        cohort_local_release(the_lock, local, local_d->my_qnode);
+        return 1;
+    }
+    local->handoffs = 0;
+    return 0;
+}
+
+int is_free_cohort(cohort_lock_t* the_lock) {
+    switch (the_lock->global_type) {
+        case COHORT_GLOBAL_BO:
+            return is_free_ttas(&the_lock->global.bo);
+        case COHORT_GLOBAL_TKT:
+            return is_free_ticket(&the_lock->global.ticket);
+        default:
+            return is_free_mcs(&the_lock->global.mcs);
+    }
+}
+
+/*
+ *  Initialization
+ */
+
+static void init_cohort_local_part(cohort_local_t* local, uint8_t local_type) {
+    memset(local, 0, sizeof(cohort_local_t));
+    if (local_type == COHORT_LOCAL_MCS) {
+        local->mcs = NULL;
+    } else {
+        create_ticketlock(&local->ticket);
+    }
+    local->top_granted = 0;
+    local->handoffs = 0;
+}
+
+static void init_cohort_global_part(cohort_lock_t* the_lock, uint8_t global_type, uint8_t local_type) {
+    memset(&the_lock->global, 0, sizeof(the_lock->global));
+    switch (global_type) {
+        case COHORT_GLOBAL_BO:
+            init_ttas_global(&the_lock->global.bo);
+            break;
+        case COHORT_GLOBAL_TKT:
+            create_ticketlock(&the_lock->global.ticket);
+            break;
+        default:
+            the_lock->global.mcs = NULL;
+            break;
+    }
+    the_lock->global_type = global_type;
+    the_lock->local_type = local_type;
+    the_lock->max_handoffs = COHORT_MAX_HANDOFFS;
+}
+
+//allocates the per socket parts of num_locks locks; the parts of a socket are allocated on its node
+static void alloc_cohort_locals(cohort_lock_t* the_locks, uint32_t num_locks) {
+    uint32_t s, i;
+    for (s = 0; s < NUMBER_OF_SOCKETS; s++) {
+        cohort_local_t* locals;
+#if defined(PLATFORM_NUMA)
+        locals = (cohort_local_t*) numa_alloc_onnode(num_locks * sizeof(cohort_local_t), get_cluster_node(s));
+#else
+        locals = (cohort_local_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(cohort_local_t));
+#endif
+        assert(locals != NULL);
+        for (i = 0; i < num_locks; i++) {
+            init_cohort_local_part(&locals[i], the_locks[i].local_type);
+            the_locks[i].local[s] = &locals[i];
+        }
+    }
+}
+
+static void free_cohort_locals(cohort_lock_t* the_locks, uint32_t num_locks) {
+    uint32_t s;
+    for (s = 0; s < NUMBER_OF_SOCKETS; s++) {
+#if defined(PLATFORM_NUMA)
+        numa_free(the_locks[0].local[s], num_locks * sizeof(cohort_local_t));
+#else
+        free(the_locks[0].local[s]);
+#endif
+    }
+}
+
+cohort_lock_t* init_cohort_array_global(uint32_t num_locks, uint8_t global_type, uint8_t local_type) {
+    cohort_lock_t* the_locks;
+    the_locks = (cohort_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(cohort_lock_t));
+    assert(the_locks != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        init_cohort_global_part(&the_locks[i], global_type, local_type);
+    }
+    alloc_cohort_locals(the_locks, num_locks);
+    MEM_BARRIER;
+    return the_locks;
+}
+
+cohort_local_params* init_cohort_array_local(uint32_t thread_num, uint32_t num_locks) {
+    uint32_t limit;
+    //assign the thread to the correct core; also seeds the ttas backoff
+    init_ttas_local(thread_num, &limit);
+    cohort_node_mine = get_cluster(thread_num);
+
+    cohort_local_params* local_params;
+    local_params = (cohort_local_params*) malloc(num_locks * sizeof(cohort_local_params));
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        local_params[i].my_qnode = (mcs_qnode*) memalign(CACHE_LINE_SIZE, sizeof(mcs_qnode));
+        local_params[i].limit = limit;
+    }
+    MEM_BARRIER;
+    return local_params;
+}
+
+void end_cohort_array_local(cohort_local_params* local_params, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free(local_params[i].my_qnode);
+    }
+    free(local_params);
+}
+
+void end_cohort_array_global(cohort_lock_t* the_locks, uint32_t size) {
+    free_cohort_locals(the_locks, size);
+    free(the_locks);
+}
+
+int init_cohort_global(cohort_lock_t* the_lock, uint8_t global_type, uint8_t local_type) {
+    init_cohort_global_part(the_lock, global_type, local_type);
+    alloc_cohort_locals(the_lock, 1);
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_cohort_local(uint32_t thread_num, cohort_local_params* local_d) {
+    //assign the thread to the correct core; also seeds the ttas backoff
+    init_ttas_local(thread_num, &local_d->limit);
+    cohort_node_mine = get_cluster(thread_num);
+    local_d->my_qnode = (mcs_qnode*) memalign(CACHE_LINE_SIZE, sizeof(mcs_qnode));
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_cohort_local(cohort_local_params local_d) {
+    free(local_d.my_qnode);
+}
+
+void end_cohort_global(cohort_lock_t the_lock) {
+    free_cohort_locals(&the_lock, 1);
+}
+
+void cohort_set_max_handoffs(cohort_lock_t* the_lock, uint32_t max_handoffs) {
+    the_lock->max_handoffs = max_handoffs;
+    MEM_BARRIER;
+}
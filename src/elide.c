@@ -0,0 +1,105 @@
+/*
+ * File: elide.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      RTM detection and abort statistics of the lock elision
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "elide.h"
+
+int elide_enabled = 0;
+__thread elide_stats_t elide_stats;
+__thread void* elide_held_lock[ELIDE_MAX_NESTED];
+__thread uint32_t elide_held = 0;
+
+static pthread_once_t elide_initialized = PTHREAD_ONCE_INIT;
+static pthread_mutex_t elide_totals_lock = PTHREAD_MUTEX_INITIALIZER;
+static elide_stats_t elide_totals;
+
+int elide_rtm_supported() {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ __volatile__("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (0), "c" (0));
+    if (eax < 7) {
+        return 0;
+    }
+    __asm__ __volatile__("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (7), "c" (0));
+    //leaf 7, ebx bit 11: RTM
+    return (ebx >> 11) & 1;
+#else
+    return 0;
+#endif
+}
+
+static void elide_do_init() {
+    int enable = elide_rtm_supported();
+    char* env = getenv(ELIDE_ENV);
+    if (env != NULL && atoi(env) == 0) {
+        enable = 0;
+    }
+    elide_enabled = enable;
+    MEM_BARRIER;
+}
+
+void elide_init() {
+    pthread_once(&elide_initialized, elide_do_init);
+}
+
+void elide_stats_flush() {
+    pthread_mutex_lock(&elide_totals_lock);
+    elide_totals.attempts += elide_stats.attempts;
+    elide_totals.commits += elide_stats.commits;
+    elide_totals.busy += elide_stats.busy;
+    elide_totals.conflict += elide_stats.conflict;
+    elide_totals.capacity += elide_stats.capacity;
+    elide_totals.other += elide_stats.other;
+    elide_totals.fallbacks += elide_stats.fallbacks;
+    pthread_mutex_unlock(&elide_totals_lock);
+    memset(&elide_stats, 0, sizeof(elide_stats_t));
+}
+
+void elide_stats_get(elide_stats_t* totals) {
+    pthread_mutex_lock(&elide_totals_lock);
+    *totals = elide_totals;
+    pthread_mutex_unlock(&elide_totals_lock);
+}
+
+void elide_stats_print() {
+    elide_stats_t t;
+    elide_stats_get(&t);
+    printf("Elision       : %s\n", elide_enabled ? "rtm" : (elide_rtm_supported() ? "disabled" : "no rtm, lock taken"));
+    printf("  tx started  : %llu\n", (unsigned long long) t.attempts);
+    printf("  tx committed: %llu\n", (unsigned long long) t.commits);
+    printf("  abort busy  : %llu\n", (unsigned long long) t.busy);
+    printf("  abort confl.: %llu\n", (unsigned long long) t.conflict);
+    printf("  abort capac.: %llu\n", (unsigned long long) t.capacity);
+    printf("  abort other : %llu\n", (unsigned long long) t.other);
+    printf("  lock taken  : %llu\n", (unsigned long long) t.fallbacks);
+}
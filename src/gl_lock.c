@@ -3,7 +3,7 @@
  * Author: Tudor David <tudor.david@epfl.ch>
  *
  * Description: 
- *      Global read-write lock implementation
+ *      Two-level read-write lock: per-partition local counters plus a global word
  *
  * The MIT License (MIT)
  *
@@ -27,50 +27,90 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include "gl_lock.h"
 
+static volatile uint32_t gl_num_threads = 0;
+__thread int gl_my_partition = -1;
 
-#include "gl_lock.h"
+static inline gl_partition* gl_partition_of_thread(global_lock* gl) {
+    if (gl_my_partition < 0) {
+        gl_my_partition = FAI_U32(&gl_num_threads) % GL_PARTITIONS;
+    }
+    return &gl->partitions[gl_my_partition];
+}
+
+void global_lock_init(global_lock* gl) {
+    int i;
+    gl->lock_data = 0;
+    for (i = 0; i < GL_PARTITIONS; i++) {
+        gl->partitions[i].local_read = 0;
+        gl->partitions[i].local_write = 0;
+    }
+    MEM_BARRIER;
+}
+
+/*
+ *  Local operations: announce themselves in their partition, then back off
+ *  if a global operation they conflict with started meanwhile
+ */
 
 void local_lock_write(global_lock* gl) {
+    gl_partition* p = gl_partition_of_thread(gl);
     while(1) {
-        while (gl->lock_short.global_lock != 0) {}
-        unsigned int aux = (unsigned int) gl->lock_short.local_lock;
-        if (__sync_val_compare_and_swap(&gl->lock_data, aux,aux+0x100) == (aux)) {
+        while (gl->lock_data != 0) {
+            PAUSE;
+        }
+        FAI_U32(&p->local_write);
+        if (gl->lock_data == 0) {
             return;
         }
+        FAD_U32(&p->local_write);
     }
 }
 
 void local_unlock_write(global_lock* gl){
-    __sync_sub_and_fetch(&(gl->lock.local_write),1);
+    FAD_U32(&gl_partition_of_thread(gl)->local_write);
 }
 
 void local_lock_read(global_lock* gl) {
+    gl_partition* p = gl_partition_of_thread(gl);
     while(1) {
-        while (gl->lock.global_write != 0) {}
-        unsigned int aux = (unsigned int) gl->lock_data & 0x00ffffff;
-        if (__sync_val_compare_and_swap(&gl->lock_data, aux,aux+1) == (aux)) {
+        while (gl->lock_data & GL_GLOBAL_WRITE) {
+            PAUSE;
+        }
+        FAI_U32(&p->local_read);
+        if ((gl->lock_data & GL_GLOBAL_WRITE) == 0) {
             return;
         }
+        FAD_U32(&p->local_read);
     }
 }
 
 void local_unlock_read(global_lock* gl){
-    __sync_sub_and_fetch(&(gl->lock.local_read),1);
+    FAD_U32(&gl_partition_of_thread(gl)->local_read);
 }
 
+/*
+ *  Global operations: mark the global word, then wait for the partitions
+ */
 
 void global_acquire_write(global_lock* gl) {
     while(1) {
-        while (gl->lock_data != 0) {}
-        unsigned short aux = (unsigned short) 0x1000000;
-        if (__sync_val_compare_and_swap(&gl->lock_data, 0, aux) == 0) {
-            return;
+        while (gl->lock_data != 0) {
+            PAUSE;
+        }
+        if (CAS_U32(&gl->lock_data, 0, GL_GLOBAL_WRITE) == 0) {
+            break;
+        }
+    }
+    int i;
+    for (i = 0; i < GL_PARTITIONS; i++) {
+        while (gl->partitions[i].local_read != 0 || gl->partitions[i].local_write != 0) {
+            PAUSE;
         }
     }
 }
 
-
 void global_unlock_write(global_lock* gl) {
     COMPILER_BARRIER;
 #ifdef __tile__
@@ -81,16 +121,23 @@ void global_unlock_write(global_lock* gl) {
 
 void global_acquire_read(global_lock* gl) {
     while(1) {
-        while ((gl->lock.global_write != 0) || (gl->lock.local_write != 0)) {}
-        unsigned int aux = (unsigned int) gl->lock_data & 0x00ff00ff;
-        if (__sync_val_compare_and_swap(&gl->lock_data, aux,aux+0x10000) == (aux)) {
-            return;
+        uint32_t val = gl->lock_data;
+        if (val & GL_GLOBAL_WRITE) {
+            PAUSE;
+            continue;
+        }
+        if (CAS_U32(&gl->lock_data, val, val + 1) == val) {
+            break;
+        }
+    }
+    int i;
+    for (i = 0; i < GL_PARTITIONS; i++) {
+        while (gl->partitions[i].local_write != 0) {
+            PAUSE;
         }
     }
 }
 
 void global_unlock_read(global_lock* gl){
-    __sync_sub_and_fetch(&(gl->lock.global_read),1);
+    FAD_U32(&gl->lock_data);
 }
-
-
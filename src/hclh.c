@@ -136,21 +136,56 @@ qnode* hclh_release(qnode *my_qnode, qnode * my_pred) {
  *  Methods aiding with array of locks manipulation
  */
 
-#define INIT_VAL 123
+//the local queues of all the clusters are created together with the lock, so
+//that a thread does not depend on another thread of its cluster to initialize them
+static void init_hclh_queues(hclh_global_params* the_params) {
+    uint32_t s;
+    the_params->local_queues = (local_queue**)malloc(MAX_SOCKETS*sizeof(local_queue*));
+    for (s = 0; s < NUMBER_OF_SOCKETS; s++) {
+        the_params->local_queues[s] = (local_queue*)malloc(sizeof(local_queue));
+        *(the_params->local_queues[s]) = NULL;
+    }
+    the_params->shared_queue = (global_queue*)malloc(sizeof(global_queue));
+    qnode * a_node = (qnode *) malloc(sizeof(qnode));
+    a_node->data=0;
+    a_node->fields.cluster_id = NUMBER_OF_SOCKETS+1;
+    *(the_params->shared_queue) = a_node;
+}
+
+static void end_hclh_queues(hclh_global_params* the_params) {
+    uint32_t s;
+    free(the_params->shared_queue);
+    for (s = 0; s < NUMBER_OF_SOCKETS; s++) {
+        free(the_params->local_queues[s]);
+    }
+    free(the_params->local_queues);
+}
+
+//the cluster a thread belongs to
+static uint32_t hclh_cluster(uint32_t phys_core) {
+#ifdef XEON
+    MEM_BARRIER;
+    uint32_t real_core_num = 0;
+    uint32_t i;
+    for (i = 0; i < (NUMBER_OF_SOCKETS * CORES_PER_SOCKET); i++) {
+        if (the_cores[i]==phys_core) {
+            real_core_num = i;
+            break;
+        }
+    }
+    MEM_BARRIER;
+    return real_core_num/CORES_PER_SOCKET;
+#else
+    return get_cluster(phys_core);
+#endif
+}
 
 hclh_global_params* init_hclh_array_global(uint32_t num_locks) {
     hclh_global_params* the_params;
     the_params = (hclh_global_params*)malloc(num_locks * sizeof(hclh_global_params));
     uint32_t i;
     for (i=0;i<num_locks;i++) {
-        //the_params[i]=(hclh_global_params*)malloc(sizeof(hclh_global_params));
-        the_params[i].local_queues = (local_queue**)malloc(NUMBER_OF_SOCKETS*sizeof(local_queue*));
-        the_params[i].init_done=(uint32_t*)malloc(NUMBER_OF_SOCKETS * sizeof(uint32_t));
-        the_params[i].shared_queue = (global_queue*)malloc(sizeof(global_queue));
-        qnode * a_node = (qnode *) malloc(sizeof(qnode));
-        a_node->data=0;
-        a_node->fields.cluster_id = NUMBER_OF_SOCKETS+1;
-        *(the_params[i].shared_queue) = a_node;
+        init_hclh_queues(&the_params[i]);
     }
     MEM_BARRIER;
     return the_params;
@@ -163,36 +198,16 @@ hclh_local_params* init_hclh_array_local(uint32_t phys_core, uint32_t num_locks,
     hclh_local_params* local_params;
     local_params = (hclh_local_params*)malloc(num_locks * sizeof(hclh_local_params));
     uint32_t i;
-#ifdef XEON
-    MEM_BARRIER;
-    uint32_t real_core_num = 0;
-    for (i = 0; i < (NUMBER_OF_SOCKETS * CORES_PER_SOCKET); i++) {
-        if (the_cores[i]==phys_core) {
-            real_core_num = i;
-            break;
-        }
-    }
-    phys_core=real_core_num;
-    MEM_BARRIER;
-#endif
-    hclh_node_mine = phys_core/CORES_PER_SOCKET;
+    uint32_t cluster = hclh_cluster(phys_core);
+    hclh_node_mine = cluster;
     for (i = 0; i < num_locks; i++) {
         //local_params[i]=(hclh_local_params*) malloc(sizeof(hclh_local_params));
         local_params[i].my_qnode = (qnode*) malloc(sizeof(qnode));
         local_params[i].my_qnode->data = 0;
-        local_params[i].my_qnode->fields.cluster_id  = phys_core/CORES_PER_SOCKET;
+        local_params[i].my_qnode->fields.cluster_id  = cluster;
         local_params[i].my_qnode->fields.successor_must_wait=1;
         local_params[i].my_pred = NULL;
-        if (phys_core%CORES_PER_SOCKET==0) {
-            the_params[i].local_queues[phys_core/CORES_PER_SOCKET] = (local_queue*)malloc(sizeof(local_queue));
-            *(the_params[i].local_queues[phys_core/CORES_PER_SOCKET]) = NULL;
-#ifdef __tile__
-        MEM_BARRIER;
-#endif
-            the_params[i].init_done[phys_core/CORES_PER_SOCKET]=INIT_VAL;
-        }
-        while(the_params[i].init_done[phys_core/CORES_PER_SOCKET]!=INIT_VAL) {}
-        local_params[i].my_queue = the_params[i].local_queues[phys_core/CORES_PER_SOCKET];
+        local_params[i].my_queue = the_params[i].local_queues[cluster];
     }
     MEM_BARRIER;
     return local_params;
@@ -209,22 +224,13 @@ void end_hclh_array_local(hclh_local_params* local_params, uint32_t size) {
 void end_hclh_array_global(hclh_global_params* global_params, uint32_t size) {
     uint32_t i;
     for (i = 0; i < size; i++) {
-        free(global_params[i].shared_queue);
-        free(global_params[i].local_queues);
+        end_hclh_queues(&global_params[i]);
     }
     free(global_params); 
 }
 
 int init_hclh_global(hclh_global_params* the_params) {
-   // hclh_global_params* the_params;
-   // the_params=(hclh_global_params*)malloc(sizeof(hclh_global_params));
-    the_params->local_queues = (local_queue**)malloc(NUMBER_OF_SOCKETS*sizeof(local_queue*));
-    the_params->init_done=(uint32_t*)malloc(NUMBER_OF_SOCKETS * sizeof(uint32_t));
-    the_params->shared_queue = (global_queue*)malloc(sizeof(global_queue));
-    qnode * a_node = (qnode *) malloc(sizeof(qnode));
-    a_node->data=0;
-    a_node->fields.cluster_id = NUMBER_OF_SOCKETS+1;
-    *(the_params->shared_queue) = a_node;
+    init_hclh_queues(the_params);
     MEM_BARRIER;
     return 0;
 }
@@ -233,51 +239,28 @@ int init_hclh_global(hclh_global_params* the_params) {
 int init_hclh_local(uint32_t phys_core, hclh_global_params* the_params, hclh_local_params* local_params) {
     //assign the thread to the correct core
     set_cpu(phys_core);
-#ifdef XEON
-    MEM_BARRIER;
-    uint32_t real_core_num = 0;
-    int i;
-    for (i = 0; i < (NUMBER_OF_SOCKETS * CORES_PER_SOCKET); i++) {
-        if (the_cores[i]==phys_core) {
-            real_core_num = i;
-            break;
-        }
-    }
-    phys_core=real_core_num;
-    MEM_BARRIER;
-#endif
-
-    hclh_node_mine = phys_core/CORES_PER_SOCKET;
-//    local_params=(hclh_local_params*) malloc(sizeof(hclh_local_params));
+    uint32_t cluster = hclh_cluster(phys_core);
+    hclh_node_mine = cluster;
     local_params->my_qnode = (qnode*) malloc(sizeof(qnode));
     local_params->my_qnode->data = 0;
-    local_params->my_qnode->fields.cluster_id  = phys_core/CORES_PER_SOCKET;
+    local_params->my_qnode->fields.cluster_id  = cluster;
     local_params->my_qnode->fields.successor_must_wait=1;
     local_params->my_pred = NULL;
-    if (phys_core%CORES_PER_SOCKET==0) {
-        the_params->local_queues[phys_core/CORES_PER_SOCKET] = (local_queue*)malloc(sizeof(local_queue));
-        *(the_params->local_queues[phys_core/CORES_PER_SOCKET]) = NULL;
-#ifdef __tile__
-        MEM_BARRIER;
-#endif
-        the_params->init_done[phys_core/CORES_PER_SOCKET]=INIT_VAL;
-    }
-    while(the_params->init_done[phys_core/CORES_PER_SOCKET]!=INIT_VAL) {}
-    local_params->my_queue = the_params->local_queues[phys_core/CORES_PER_SOCKET];
+    local_params->my_queue = the_params->local_queues[cluster];
     MEM_BARRIER;
     return 0;
 }
 
+void init_hclh_thread(uint32_t phys_core) {
+    set_cpu(phys_core);
+    hclh_node_mine = hclh_cluster(phys_core);
+    MEM_BARRIER;
+}
+
 void end_hclh_local(hclh_local_params local_params) {
     free(local_params.my_qnode);
 }
 
 void end_hclh_global(hclh_global_params global_params) {
-    free(global_params.shared_queue);
-    int i;
-    for (i=0;i<sizeof(global_params.local_queues)/sizeof(global_params.local_queues[0]);i++) {
-       free(global_params.local_queues[i]); 
-    }
-    free(global_params.local_queues);
+    end_hclh_queues(&global_params);
 }
-
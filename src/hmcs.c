@@ -0,0 +1,355 @@
+/*
+ * File: hmcs.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ *      Implementation of the hierarchical MCS lock
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "hmcs.h"
+
+hmcs_levels_t hmcs_levels;
+static pthread_once_t hmcs_levels_once = PTHREAD_ONCE_INIT;
+
+__thread uint32_t hmcs_leaf_mine = 0; //hnode of the leaf group of the thread
+
+/*
+ *  Levels
+ */
+
+static uint32_t hmcs_num_cpus() {
+#ifdef DEFAULT
+    return topology.num_cpus;
+#else
+    return NUMBER_OF_SOCKETS * CORES_PER_SOCKET;
+#endif
+}
+
+//group of a cpu at a level of the topology
+static uint32_t hmcs_group(uint32_t kind, uint32_t cpu) {
+#ifdef DEFAULT
+    switch (kind) {
+        case HMCS_LEVEL_SMT:
+            return topology_core(cpu);
+        case HMCS_LEVEL_LLC:
+            return topology_llc(cpu);
+        case HMCS_LEVEL_SOCKET:
+            return topology_socket(cpu);
+    }
+    return 0;
+#else
+    //only the sockets are known
+    switch (kind) {
+        case HMCS_LEVEL_SMT:
+            return cpu;
+        case HMCS_LEVEL_LLC:
+        case HMCS_LEVEL_SOCKET:
+            return get_cluster(cpu);
+    }
+    return 0;
+#endif
+}
+
+static uint32_t hmcs_kind_threshold(uint32_t kind) {
+    switch (kind) {
+        case HMCS_LEVEL_SMT:
+            return HMCS_SMT_THRESHOLD;
+        case HMCS_LEVEL_LLC:
+            return HMCS_LLC_THRESHOLD;
+        case HMCS_LEVEL_SOCKET:
+            return HMCS_SOCKET_THRESHOLD;
+    }
+    return 0;
+}
+
+//group of a cpu at a level of the lock
+static uint32_t hmcs_level_group(uint32_t level, uint32_t cpu) {
+    if (hmcs_levels.kind[level] == 0) return 0;
+    return hmcs_group(hmcs_levels.kind[level], cpu);
+}
+
+static void hmcs_levels_compute() {
+    static const uint32_t kinds[] = { HMCS_LEVEL_SMT, HMCS_LEVEL_LLC, HMCS_LEVEL_SOCKET };
+    uint32_t num_cpus = hmcs_num_cpus();
+    if (num_cpus > HMCS_MAX_CPUS) num_cpus = HMCS_MAX_CPUS;
+    //group of the previous kept level of the groups of a candidate level
+    static int32_t above[HMCS_MAX_CPUS];
+    uint32_t prev_groups = num_cpus;
+    uint32_t n = 0;
+    uint32_t k, c;
+
+    for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        if ((HMCS_LEVELS & kinds[k]) == 0) continue;
+        uint32_t groups = 0;
+        int nests = 1;
+        for (c = 0; c < HMCS_MAX_CPUS; c++) above[c] = -1;
+        for (c = 0; c < num_cpus; c++) {
+            uint32_t g = hmcs_group(kinds[k], c);
+            if (g >= HMCS_MAX_CPUS) {
+                nests = 0;
+                break;
+            }
+            if (g + 1 > groups) groups = g + 1;
+            //every group of the previous level must be in a single group of this one
+            uint32_t below = (n == 0) ? c : hmcs_level_group(n - 1, c);
+            if (above[below] < 0) {
+                above[below] = g;
+            } else if (above[below] != (int32_t) g) {
+                nests = 0;
+            }
+        }
+        //a level of a single group is the root; a level with as many groups as the one below adds nothing
+        if (!nests || groups <= 1 || groups >= prev_groups) continue;
+        hmcs_levels.kind[n] = kinds[k];
+        hmcs_levels.groups[n] = groups;
+        hmcs_levels.threshold[n] = hmcs_kind_threshold(kinds[k]);
+        prev_groups = groups;
+        n++;
+    }
+    //the root
+    hmcs_levels.kind[n] = 0;
+    hmcs_levels.groups[n] = 1;
+    hmcs_levels.threshold[n] = 0;
+    n++;
+    hmcs_levels.num_levels = n;
+
+    uint32_t l, offset = 0;
+    for (l = 0; l < n; l++) {
+        hmcs_levels.offset[l] = offset;
+        offset += hmcs_levels.groups[l];
+    }
+    hmcs_levels.num_hnodes = offset;
+    for (l = 0; l + 1 < n; l++) {
+        for (c = 0; c < num_cpus; c++) {
+            hmcs_levels.parent[hmcs_levels.offset[l] + hmcs_level_group(l, c)] =
+                hmcs_levels.offset[l + 1] + hmcs_level_group(l + 1, c);
+        }
+    }
+}
+
+void hmcs_levels_init() {
+    pthread_once(&hmcs_levels_once, hmcs_levels_compute);
+}
+
+void hmcs_levels_print(FILE* f) {
+    static const char* names[] = { "machine", "core", "llc", "", "socket" };
+    hmcs_levels_init();
+    uint32_t l;
+    fprintf(f, "hmcs levels:");
+    for (l = 0; l < hmcs_levels.num_levels; l++) {
+        fprintf(f, " %s (%u groups", names[hmcs_levels.kind[l]], hmcs_levels.groups[l]);
+        if (hmcs_levels.kind[l] != 0) {
+            fprintf(f, ", threshold %u", hmcs_levels.threshold[l]);
+        }
+        fprintf(f, ")");
+    }
+    fprintf(f, "\n");
+}
+
+/*
+ *  Acquire and release methods
+ */
+
+//hands the lock of a group to the next waiter with the given status; frees it if there is none
+static inline void hmcs_pass(hmcs_hnode_t* L, hmcs_qnode_t* I, uint32_t status) {
+    hmcs_qnode_t* succ = I->next;
+    if (succ == NULL) {
+        if (CAS_PTR(&L->tail, I, NULL) == I) return;
+        while ((succ = I->next) == NULL) {
+            PAUSE;
+        }
+    }
+    succ->status = status;
+}
+
+static void hmcs_acquire_level(hmcs_hnode_t* L, hmcs_qnode_t* I) {
+    I->next = NULL;
+    I->status = HMCS_WAIT;
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    hmcs_qnode_t* pred = (hmcs_qnode_t*) SWAP_PTR((volatile void*) &L->tail, (void*) I);
+    if (pred != NULL) {
+        pred->next = I;
+        uint32_t status;
+        while ((status = I->status) == HMCS_WAIT) {
+            PAUSE;
+        }
+        //the levels above were passed along
+        if (status < HMCS_ACQUIRE_PARENT) return;
+    }
+    I->status = HMCS_COHORT_START;
+    if (L->parent != NULL) {
+        hmcs_acquire_level(L->parent, &L->node);
+    }
+}
+
+static void hmcs_release_level(hmcs_hnode_t* L, hmcs_qnode_t* I) {
+    if (L->parent == NULL) {
+        hmcs_pass(L, I, HMCS_COHORT_START);
+        return;
+    }
+    uint32_t count = I->status;
+    if (count < L->threshold) {
+        hmcs_qnode_t* succ = I->next;
+        if (succ != NULL) {
+            succ->status = count + 1;
+            return;
+        }
+    }
+    hmcs_release_level(L->parent, &L->node);
+    MEM_BARRIER;
+    hmcs_pass(L, I, HMCS_ACQUIRE_PARENT);
+}
+
+static int hmcs_trylock_level(hmcs_hnode_t* L, hmcs_qnode_t* I) {
+    I->next = NULL;
+    I->status = HMCS_COHORT_START;
+    MEM_BARRIER;
+    if (CAS_PTR(&L->tail, NULL, I) != NULL) return 1;
+    if (L->parent != NULL && hmcs_trylock_level(L->parent, &L->node) != 0) {
+        //the waiters that came meanwhile acquire the parent themselves
+        hmcs_pass(L, I, HMCS_ACQUIRE_PARENT);
+        return 1;
+    }
+    return 0;
+}
+
+void hmcs_acquire(hmcs_lock_t* the_lock, hmcs_qnode_t* I) {
+    hmcs_acquire_level(&the_lock->hnodes[hmcs_leaf_mine], I);
+}
+
+void hmcs_release(hmcs_lock_t* the_lock, hmcs_qnode_t* I) {
+    hmcs_release_level(&the_lock->hnodes[hmcs_leaf_mine], I);
+}
+
+int hmcs_trylock(hmcs_lock_t* the_lock, hmcs_qnode_t* I) {
+    return hmcs_trylock_level(&the_lock->hnodes[hmcs_leaf_mine], I);
+}
+
+int is_free_hmcs(hmcs_lock_t* the_lock) {
+    //the holder of any level also holds the root
+    if (the_lock->hnodes[hmcs_levels.num_hnodes - 1].tail == NULL) return 1;
+    return 0;
+}
+
+/*
+ *  Initialization
+ */
+
+static void init_hmcs_hnodes(hmcs_hnode_t* hnodes) {
+    uint32_t l, g;
+    for (l = 0; l < hmcs_levels.num_levels; l++) {
+        for (g = 0; g < hmcs_levels.groups[l]; g++) {
+            uint32_t i = hmcs_levels.offset[l] + g;
+            hnodes[i].tail = NULL;
+            hnodes[i].threshold = hmcs_levels.threshold[l];
+            hnodes[i].parent = (l + 1 < hmcs_levels.num_levels) ? &hnodes[hmcs_levels.parent[i]] : NULL;
+            hnodes[i].node.next = NULL;
+            hnodes[i].node.status = HMCS_WAIT;
+        }
+    }
+}
+
+static void init_hmcs_thread(uint32_t thread_num) {
+    set_cpu(thread_num);
+    hmcs_levels_init();
+    hmcs_leaf_mine = hmcs_levels.offset[0] + hmcs_level_group(0, thread_num % HMCS_MAX_CPUS);
+}
+
+hmcs_lock_t* init_hmcs_array_global(uint32_t num_locks) {
+    hmcs_levels_init();
+    hmcs_lock_t* the_locks = (hmcs_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(hmcs_lock_t));
+    assert(the_locks != NULL);
+    //the hnodes of all the locks in one block
+    uint32_t n = hmcs_levels.num_hnodes;
+    hmcs_hnode_t* hnodes = (hmcs_hnode_t*) memalign(CACHE_LINE_SIZE, num_locks * n * sizeof(hmcs_hnode_t));
+    assert(hnodes != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        the_locks[i].hnodes = &hnodes[i * n];
+        init_hmcs_hnodes(the_locks[i].hnodes);
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+hmcs_local_params* init_hmcs_array_local(uint32_t thread_num, uint32_t num_locks) {
+    init_hmcs_thread(thread_num);
+    hmcs_local_params* local_params = (hmcs_local_params*) malloc(num_locks * sizeof(hmcs_local_params));
+    assert(local_params != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        local_params[i] = (hmcs_qnode_t*) memalign(CACHE_LINE_SIZE, sizeof(hmcs_qnode_t));
+    }
+    MEM_BARRIER;
+    return local_params;
+}
+
+void end_hmcs_array_local(hmcs_local_params* local_params, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        free(local_params[i]);
+    }
+    free(local_params);
+}
+
+void end_hmcs_array_global(hmcs_lock_t* the_locks, uint32_t size) {
+    free(the_locks[0].hnodes);
+    free(the_locks);
+}
+
+int init_hmcs_global(hmcs_lock_t* the_lock) {
+    hmcs_levels_init();
+    the_lock->hnodes = (hmcs_hnode_t*) memalign(CACHE_LINE_SIZE, hmcs_levels.num_hnodes * sizeof(hmcs_hnode_t));
+    assert(the_lock->hnodes != NULL);
+    init_hmcs_hnodes(the_lock->hnodes);
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_hmcs_local(uint32_t thread_num, hmcs_local_params* local_d) {
+    init_hmcs_thread(thread_num);
+    *local_d = (hmcs_qnode_t*) memalign(CACHE_LINE_SIZE, sizeof(hmcs_qnode_t));
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_hmcs_local(hmcs_local_params local_d) {
+    free(local_d);
+}
+
+void end_hmcs_global(hmcs_lock_t the_lock) {
+    free(the_lock.hnodes);
+}
+
+void hmcs_set_threshold(hmcs_lock_t* the_lock, uint32_t level, uint32_t threshold) {
+    if (level + 1 >= hmcs_levels.num_levels) return;
+    if (threshold >= HMCS_ACQUIRE_PARENT - 1) threshold = HMCS_ACQUIRE_PARENT - 2;
+    uint32_t g;
+    for (g = 0; g < hmcs_levels.groups[level]; g++) {
+        the_lock->hnodes[hmcs_levels.offset[level] + g].threshold = threshold;
+    }
+    MEM_BARRIER;
+}
@@ -59,8 +59,8 @@ int create_htlock(htlock_t* htl)
     for (s = 0; s < NUMBER_OF_SOCKETS; s++)
     {
 #if defined(PLATFORM_NUMA)
-        numa_set_preferred(s);
-        htl->local[s] = (htlock_local_t*) numa_alloc_onnode(sizeof(htlock_local_t), s);
+        numa_set_preferred(get_cluster_node(s));
+        htl->local[s] = (htlock_local_t*) numa_alloc_onnode(sizeof(htlock_local_t), get_cluster_node(s));
 #else
         htl->local[s] = (htlock_local_t*) malloc(sizeof(htlock_local_t));
 #endif
@@ -70,7 +70,7 @@ int create_htlock(htlock_t* htl)
     }
 
 #if defined(PLATFORM_NUMA)
-    numa_set_preferred(htlock_node_mine);
+    numa_set_preferred(get_cluster_node(htlock_node_mine));
 #endif
 
     htl->global->cur = 0;
@@ -137,7 +137,7 @@ is_free_hticket(htlock_t* htl)
 }
 
     static htlock_t* 
-create_htlock_no_alloc(htlock_t* htl, htlock_local_t* locals[NUMBER_OF_SOCKETS], size_t offset)
+create_htlock_no_alloc(htlock_t* htl, htlock_local_t* locals[MAX_SOCKETS], size_t offset)
 {
     htl->global = memalign(CACHE_LINE_SIZE, sizeof(htlock_global_t));
     if (htl == NULL) 
@@ -179,12 +179,12 @@ init_htlocks(uint32_t num_locks)
 
     size_t alloc_locks = (num_locks < 64) ? 64 : num_locks;
 
-    htlock_local_t* locals[NUMBER_OF_SOCKETS];
+    htlock_local_t* locals[MAX_SOCKETS];
     uint32_t n;
     for (n = 0; n < NUMBER_OF_SOCKETS; n++)
     {
 #if defined(PLATFORM_NUMA)
-        numa_set_preferred(n);
+        numa_set_preferred(get_cluster_node(n));
 #endif
         locals[n] = (htlock_local_t*) calloc(alloc_locks, sizeof(htlock_local_t));
         *((volatile int*) locals[n]) = 33;
@@ -192,7 +192,7 @@ init_htlocks(uint32_t num_locks)
     }
 
 #if defined(OPTERON) || defined(XEON)
-    numa_set_preferred(htlock_node_mine);
+    numa_set_preferred(get_cluster_node(htlock_node_mine));
 #endif
 
     uint32_t i;
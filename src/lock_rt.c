@@ -0,0 +1,1184 @@
+/*
+ * File: lock_rt.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Runtime selection of the locking algorithm
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <malloc.h>
+#include "lock_rt.h"
+
+/*
+ *  MCS
+ */
+
+static void rt_mcs_acquire(void* local_d, void* global_d) {
+    mcs_acquire(((mcs_global_params*) global_d)->the_lock, *(mcs_local_params*) local_d);
+}
+
+static void rt_mcs_release(void* local_d, void* global_d) {
+    mcs_release(((mcs_global_params*) global_d)->the_lock, *(mcs_local_params*) local_d);
+}
+
+static int rt_mcs_trylock(void* local_d, void* global_d) {
+    return mcs_trylock(((mcs_global_params*) global_d)->the_lock, *(mcs_local_params*) local_d);
+}
+
+static int rt_mcs_acquire_timeout(void* local_d, void* global_d, ticks timeout) {
+    return mcs_acquire_timeout(((mcs_global_params*) global_d)->the_lock, (mcs_qnode**) local_d, timeout);
+}
+
+static void* rt_mcs_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_mcs_array_global(num_locks);
+}
+
+static void* rt_mcs_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_mcs_array_local(thread_num, num_locks);
+}
+
+static void rt_mcs_end_array_local(void* local_d, uint32_t num_locks) {
+    end_mcs_array_local((mcs_qnode**) local_d, num_locks);
+}
+
+static void rt_mcs_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_mcs_array_global((mcs_global_params*) the_locks, num_locks);
+}
+
+static int rt_mcs_init_global(uint32_t num_threads, void* the_lock) {
+    return init_mcs_global((mcs_global_params*) the_lock);
+}
+
+static int rt_mcs_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_mcs_local(thread_num, (mcs_qnode**) local_d);
+}
+
+static void rt_mcs_end_local(void* local_d) {
+    end_mcs_local(*(mcs_local_params*) local_d);
+}
+
+static void rt_mcs_end_global(void* the_lock) {
+    end_mcs_global(*(mcs_global_params*) the_lock);
+}
+
+/*
+ *  CNA
+ */
+
+static void rt_cna_acquire(void* local_d, void* global_d) {
+    cna_acquire(((cna_global_params*) global_d)->the_lock, *(cna_local_params*) local_d);
+}
+
+static void rt_cna_release(void* local_d, void* global_d) {
+    cna_release(((cna_global_params*) global_d)->the_lock, *(cna_local_params*) local_d);
+}
+
+static int rt_cna_trylock(void* local_d, void* global_d) {
+    return cna_trylock(((cna_global_params*) global_d)->the_lock, *(cna_local_params*) local_d);
+}
+
+static void* rt_cna_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_cna_array_global(num_locks);
+}
+
+static void* rt_cna_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_cna_array_local(thread_num, num_locks);
+}
+
+static void rt_cna_end_array_local(void* local_d, uint32_t num_locks) {
+    end_cna_array_local((cna_qnode**) local_d, num_locks);
+}
+
+static void rt_cna_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_cna_array_global((cna_global_params*) the_locks, num_locks);
+}
+
+static int rt_cna_init_global(uint32_t num_threads, void* the_lock) {
+    return init_cna_global((cna_global_params*) the_lock);
+}
+
+static int rt_cna_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_cna_local(thread_num, (cna_qnode**) local_d);
+}
+
+static void rt_cna_end_local(void* local_d) {
+    end_cna_local(*(cna_local_params*) local_d);
+}
+
+static void rt_cna_end_global(void* the_lock) {
+    end_cna_global(*(cna_global_params*) the_lock);
+}
+
+/*
+ *  HMCS
+ */
+
+static void rt_hmcs_acquire(void* local_d, void* global_d) {
+    hmcs_acquire((hmcs_lock_t*) global_d, *(hmcs_local_params*) local_d);
+}
+
+static void rt_hmcs_release(void* local_d, void* global_d) {
+    hmcs_release((hmcs_lock_t*) global_d, *(hmcs_local_params*) local_d);
+}
+
+static int rt_hmcs_trylock(void* local_d, void* global_d) {
+    return hmcs_trylock((hmcs_lock_t*) global_d, *(hmcs_local_params*) local_d);
+}
+
+static void* rt_hmcs_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_hmcs_array_global(num_locks);
+}
+
+static void* rt_hmcs_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_hmcs_array_local(thread_num, num_locks);
+}
+
+static void rt_hmcs_end_array_local(void* local_d, uint32_t num_locks) {
+    end_hmcs_array_local((hmcs_local_params*) local_d, num_locks);
+}
+
+static void rt_hmcs_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_hmcs_array_global((hmcs_lock_t*) the_locks, num_locks);
+}
+
+static int rt_hmcs_init_global(uint32_t num_threads, void* the_lock) {
+    return init_hmcs_global((hmcs_lock_t*) the_lock);
+}
+
+static int rt_hmcs_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_hmcs_local(thread_num, (hmcs_local_params*) local_d);
+}
+
+static void rt_hmcs_end_local(void* local_d) {
+    end_hmcs_local(*(hmcs_local_params*) local_d);
+}
+
+static void rt_hmcs_end_global(void* the_lock) {
+    end_hmcs_global(*(hmcs_lock_t*) the_lock);
+}
+
+/*
+ *  HCLH
+ */
+
+static void rt_hclh_acquire(void* local_d, void* global_d) {
+    hclh_local_params* l = (hclh_local_params*) local_d;
+    l->my_pred = (qnode*) hclh_acquire(l->my_queue, ((hclh_global_params*) global_d)->shared_queue, l->my_qnode);
+}
+
+static void rt_hclh_release(void* local_d, void* global_d) {
+    hclh_local_params* l = (hclh_local_params*) local_d;
+    l->my_qnode = hclh_release(l->my_qnode, l->my_pred);
+}
+
+static int rt_hclh_trylock(void* local_d, void* global_d) {
+    perror("trylock not supported for hclh locks");
+    return 1;
+}
+
+//the wait of an HCLH waiter cannot be bounded (hclh.h): fail like the trylock
+static int rt_hclh_acquire_timeout(void* local_d, void* global_d, ticks timeout) {
+    perror("timeout not supported for hclh locks");
+    return 1;
+}
+
+static void* rt_hclh_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_hclh_array_global(num_locks);
+}
+
+static void* rt_hclh_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_hclh_array_local(thread_num, num_locks, (hclh_global_params*) the_locks);
+}
+
+static void rt_hclh_end_array_local(void* local_d, uint32_t num_locks) {
+    end_hclh_array_local((hclh_local_params*) local_d, num_locks);
+}
+
+static void rt_hclh_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_hclh_array_global((hclh_global_params*) the_locks, num_locks);
+}
+
+static int rt_hclh_init_global(uint32_t num_threads, void* the_lock) {
+    return init_hclh_global((hclh_global_params*) the_lock);
+}
+
+static int rt_hclh_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_hclh_local(thread_num, (hclh_global_params*) the_lock, (hclh_local_params*) local_d);
+}
+
+static void rt_hclh_end_local(void* local_d) {
+    end_hclh_local(*(hclh_local_params*) local_d);
+}
+
+static void rt_hclh_end_global(void* the_lock) {
+    end_hclh_global(*(hclh_global_params*) the_lock);
+}
+
+/*
+ *  TTAS
+ */
+
+static void rt_ttas_acquire(void* local_d, void* global_d) {
+    ttas_lock((ttas_lock_t*) global_d, (uint32_t*) local_d);
+}
+
+static void rt_ttas_release(void* local_d, void* global_d) {
+    ttas_unlock((ttas_lock_t*) global_d);
+}
+
+static int rt_ttas_trylock(void* local_d, void* global_d) {
+    return ttas_trylock((ttas_lock_t*) global_d, (uint32_t*) local_d);
+}
+
+static void* rt_ttas_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_ttas_array_global(num_locks);
+}
+
+static void* rt_ttas_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_ttas_array_local(thread_num, num_locks);
+}
+
+static void rt_ttas_end_array_local(void* local_d, uint32_t num_locks) {
+    end_ttas_array_local((uint32_t*) local_d);
+}
+
+static void rt_ttas_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_ttas_array_global((ttas_lock_t*) the_locks);
+}
+
+static int rt_ttas_init_global(uint32_t num_threads, void* the_lock) {
+    return init_ttas_global((ttas_lock_t*) the_lock);
+}
+
+static int rt_ttas_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_ttas_local(thread_num, (uint32_t*) local_d);
+}
+
+/*
+ *  SPINLOCK
+ */
+
+static void rt_spinlock_acquire(void* local_d, void* global_d) {
+    spinlock_lock((spinlock_lock_t*) global_d, (uint32_t*) local_d);
+}
+
+static void rt_spinlock_release(void* local_d, void* global_d) {
+    spinlock_unlock((spinlock_lock_t*) global_d);
+}
+
+static int rt_spinlock_trylock(void* local_d, void* global_d) {
+    return spinlock_trylock((spinlock_lock_t*) global_d, (uint32_t*) local_d);
+}
+
+static void* rt_spinlock_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_spinlock_array_global(num_locks);
+}
+
+static void* rt_spinlock_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_spinlock_array_local(thread_num, num_locks);
+}
+
+static void rt_spinlock_end_array_local(void* local_d, uint32_t num_locks) {
+    end_spinlock_array_local((uint32_t*) local_d);
+}
+
+static void rt_spinlock_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_spinlock_array_global((spinlock_lock_t*) the_locks);
+}
+
+static int rt_spinlock_init_global(uint32_t num_threads, void* the_lock) {
+    return init_spinlock_global((spinlock_lock_t*) the_lock);
+}
+
+static int rt_spinlock_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_spinlock_local(thread_num, (uint32_t*) local_d);
+}
+
+/*
+ *  ARRAY
+ */
+
+static void rt_alock_acquire(void* local_d, void* global_d) {
+    alock_lock((array_lock_t*) local_d);
+}
+
+static void rt_alock_release(void* local_d, void* global_d) {
+    alock_unlock((array_lock_t*) local_d);
+}
+
+static int rt_alock_trylock(void* local_d, void* global_d) {
+    return alock_trylock((array_lock_t*) local_d);
+}
+
+static void* rt_alock_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_alock_array_global(num_locks, num_threads);
+}
+
+static void* rt_alock_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_alock_array_local(thread_num, num_locks, (lock_shared_t*) the_locks);
+}
+
+static void rt_alock_end_array_local(void* local_d, uint32_t num_locks) {
+    end_alock_array_local((array_lock_t*) local_d, num_locks);
+}
+
+static void rt_alock_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_alock_array_global((lock_shared_t*) the_locks, num_locks);
+}
+
+static int rt_alock_init_global(uint32_t num_threads, void* the_lock) {
+    //the number of threads is not known when called through init_lock_global
+    if (num_threads == 0) num_threads = MAX_NUM_PROCESSES;
+    return init_alock_global(num_threads, (lock_shared_t*) the_lock);
+}
+
+static int rt_alock_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_alock_local(thread_num, (lock_shared_t*) the_lock, (array_lock_t*) local_d);
+}
+
+/*
+ *  RW
+ */
+
+static void rt_rw_acquire(void* local_d, void* global_d) {
+    write_acquire((rw_ttas*) global_d, (uint32_t*) local_d);
+}
+
+static void rt_rw_release(void* local_d, void* global_d) {
+    write_release((rw_ttas*) global_d);
+}
+
+static void rt_rw_acquire_read(void* local_d, void* global_d) {
+    read_acquire((rw_ttas*) global_d, (uint32_t*) local_d);
+}
+
+static void rt_rw_release_read(void* local_d, void* global_d) {
+    read_release((rw_ttas*) global_d);
+}
+
+static int rt_rw_trylock(void* local_d, void* global_d) {
+    return rw_trylock((rw_ttas*) global_d, (uint32_t*) local_d);
+}
+
+static void* rt_rw_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_rw_ttas_array_global(num_locks);
+}
+
+static void* rt_rw_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_rw_ttas_array_local(thread_num, num_locks);
+}
+
+static void rt_rw_end_array_local(void* local_d, uint32_t num_locks) {
+    end_rw_ttas_array_local((uint32_t*) local_d);
+}
+
+static void rt_rw_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_rw_ttas_array_global((rw_ttas*) the_locks);
+}
+
+static int rt_rw_init_global(uint32_t num_threads, void* the_lock) {
+    return init_rw_ttas_global((rw_ttas*) the_lock);
+}
+
+static int rt_rw_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_rw_ttas_local(thread_num, (uint32_t*) local_d);
+}
+
+/*
+ *  RW_NUMA
+ */
+
+static void rt_rw_numa_acquire(void* local_d, void* global_d) {
+    rw_numa_write_acquire((rw_numa_lock_t*) global_d);
+}
+
+static void rt_rw_numa_release(void* local_d, void* global_d) {
+    rw_numa_write_release((rw_numa_lock_t*) global_d);
+}
+
+static void rt_rw_numa_acquire_read(void* local_d, void* global_d) {
+    rw_numa_read_acquire((rw_numa_lock_t*) global_d, (rw_numa_local_params*) local_d);
+}
+
+static void rt_rw_numa_release_read(void* local_d, void* global_d) {
+    rw_numa_read_release((rw_numa_lock_t*) global_d, (rw_numa_local_params*) local_d);
+}
+
+static int rt_rw_numa_trylock(void* local_d, void* global_d) {
+    return rw_numa_write_trylock((rw_numa_lock_t*) global_d);
+}
+
+static void* rt_rw_numa_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_rw_numa_array_global(num_locks);
+}
+
+static void* rt_rw_numa_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_rw_numa_array_local(thread_num, num_locks);
+}
+
+static void rt_rw_numa_end_array_local(void* local_d, uint32_t num_locks) {
+    end_rw_numa_array_local((rw_numa_local_params*) local_d);
+}
+
+static void rt_rw_numa_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_rw_numa_array_global((rw_numa_lock_t*) the_locks);
+}
+
+static int rt_rw_numa_init_global(uint32_t num_threads, void* the_lock) {
+    return init_rw_numa_global((rw_numa_lock_t*) the_lock);
+}
+
+static int rt_rw_numa_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_rw_numa_local(thread_num, (rw_numa_local_params*) local_d);
+}
+
+/*
+ *  CLH
+ */
+
+static void rt_clh_acquire(void* local_d, void* global_d) {
+    clh_local_params* l = (clh_local_params*) local_d;
+    l->my_pred = (clh_qnode*) clh_acquire(((clh_global_params*) global_d)->the_lock, l->my_qnode);
+}
+
+static void rt_clh_release(void* local_d, void* global_d) {
+    clh_local_params* l = (clh_local_params*) local_d;
+    l->my_qnode = clh_release(l->my_qnode, l->my_pred);
+}
+
+static int rt_clh_trylock(void* local_d, void* global_d) {
+    perror("trylock not supported for clh locks");
+    return 1;
+}
+
+static int rt_clh_acquire_timeout(void* local_d, void* global_d, ticks timeout) {
+    clh_local_params* l = (clh_local_params*) local_d;
+    return clh_acquire_timeout(((clh_global_params*) global_d)->the_lock, &(l->my_qnode), &(l->my_pred), timeout);
+}
+
+static void* rt_clh_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_clh_array_global(num_locks);
+}
+
+static void* rt_clh_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_clh_array_local(thread_num, num_locks);
+}
+
+static void rt_clh_end_array_local(void* local_d, uint32_t num_locks) {
+    end_clh_array_local((clh_local_params*) local_d, num_locks);
+}
+
+static void rt_clh_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_clh_array_global((clh_global_params*) the_locks, num_locks);
+}
+
+static int rt_clh_init_global(uint32_t num_threads, void* the_lock) {
+    return init_clh_global((clh_global_params*) the_lock);
+}
+
+static int rt_clh_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_clh_local(thread_num, (clh_local_params*) local_d);
+}
+
+static void rt_clh_end_local(void* local_d) {
+    end_clh_local(*(clh_local_params*) local_d);
+}
+
+static void rt_clh_end_global(void* the_lock) {
+    end_clh_global(*(clh_global_params*) the_lock);
+}
+
+/*
+ *  TICKET
+ */
+
+static void rt_ticket_acquire(void* local_d, void* global_d) {
+    ticket_acquire((ticketlock_t*) global_d);
+}
+
+static void rt_ticket_release(void* local_d, void* global_d) {
+    ticket_release((ticketlock_t*) global_d);
+}
+
+static int rt_ticket_trylock(void* local_d, void* global_d) {
+    return ticket_trylock((ticketlock_t*) global_d);
+}
+
+static void* rt_ticket_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_ticketlocks(num_locks);
+}
+
+static void* rt_ticket_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    init_thread_ticketlocks(thread_num);
+    return NULL;
+}
+
+static void rt_ticket_end_array_global(void* the_locks, uint32_t num_locks) {
+    free_ticketlocks((ticketlock_t*) the_locks);
+}
+
+static int rt_ticket_init_global(uint32_t num_threads, void* the_lock) {
+    return create_ticketlock((ticketlock_t*) the_lock);
+}
+
+static int rt_ticket_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    init_thread_ticketlocks(thread_num);
+    return 0;
+}
+
+/*
+ *  QSPIN
+ */
+
+static void rt_qspin_acquire(void* local_d, void* global_d) {
+    qspin_acquire((qspin_lock_t*) global_d);
+}
+
+static void rt_qspin_release(void* local_d, void* global_d) {
+    qspin_release((qspin_lock_t*) global_d);
+}
+
+static int rt_qspin_trylock(void* local_d, void* global_d) {
+    return qspin_trylock((qspin_lock_t*) global_d);
+}
+
+static void* rt_qspin_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_qspin_array_global(num_locks);
+}
+
+static void* rt_qspin_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    init_qspin_array_local(thread_num);
+    return NULL;
+}
+
+static void rt_qspin_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_qspin_array_global((qspin_lock_t*) the_locks);
+}
+
+static int rt_qspin_init_global(uint32_t num_threads, void* the_lock) {
+    return init_qspin_global((qspin_lock_t*) the_lock);
+}
+
+static int rt_qspin_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_qspin_local(thread_num);
+}
+
+static void rt_qspin_end_array_local(void* local_d, uint32_t num_locks) {
+    end_qspin_array_local();
+}
+
+static void rt_qspin_end_local(void* local_d) {
+    end_qspin_local();
+}
+
+/*
+ *  SHFL
+ */
+
+static void rt_shfl_acquire(void* local_d, void* global_d) {
+    shfl_acquire((shfl_lock_t*) global_d);
+}
+
+static void rt_shfl_release(void* local_d, void* global_d) {
+    shfl_release((shfl_lock_t*) global_d);
+}
+
+static int rt_shfl_trylock(void* local_d, void* global_d) {
+    return shfl_trylock((shfl_lock_t*) global_d);
+}
+
+static void* rt_shfl_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_shfl_array_global(num_locks);
+}
+
+static void* rt_shfl_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    init_shfl_array_local(thread_num);
+    return NULL;
+}
+
+static void rt_shfl_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_shfl_array_global((shfl_lock_t*) the_locks);
+}
+
+static int rt_shfl_init_global(uint32_t num_threads, void* the_lock) {
+    return init_shfl_global((shfl_lock_t*) the_lock);
+}
+
+static int rt_shfl_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_shfl_local(thread_num);
+}
+
+static void rt_shfl_end_array_local(void* local_d, uint32_t num_locks) {
+    end_shfl_array_local();
+}
+
+static void rt_shfl_end_local(void* local_d) {
+    end_shfl_local();
+}
+
+/*
+ *  ARRAY_DYN
+ */
+
+static void rt_alock_dyn_acquire(void* local_d, void* global_d) {
+    alock_dyn_acquire((alock_dyn_lock_t*) global_d);
+}
+
+static void rt_alock_dyn_release(void* local_d, void* global_d) {
+    alock_dyn_release((alock_dyn_lock_t*) global_d);
+}
+
+static int rt_alock_dyn_trylock(void* local_d, void* global_d) {
+    return alock_dyn_trylock((alock_dyn_lock_t*) global_d);
+}
+
+static void* rt_alock_dyn_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_alock_dyn_array_global(num_locks);
+}
+
+static void* rt_alock_dyn_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    init_alock_dyn_array_local(thread_num);
+    return NULL;
+}
+
+static void rt_alock_dyn_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_alock_dyn_array_global((alock_dyn_lock_t*) the_locks, num_locks);
+}
+
+static int rt_alock_dyn_init_global(uint32_t num_threads, void* the_lock) {
+    return init_alock_dyn_global((alock_dyn_lock_t*) the_lock);
+}
+
+static int rt_alock_dyn_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_alock_dyn_local(thread_num);
+}
+
+static void rt_alock_dyn_end_global(void* the_lock) {
+    end_alock_dyn_global(*((alock_dyn_lock_t*) the_lock));
+}
+
+/*
+ *  MUTEX
+ */
+
+static void rt_mutex_acquire(void* local_d, void* global_d) {
+    pthread_mutex_lock((pthread_mutex_t*) global_d);
+}
+
+static void rt_mutex_release(void* local_d, void* global_d) {
+    pthread_mutex_unlock((pthread_mutex_t*) global_d);
+}
+
+static int rt_mutex_trylock(void* local_d, void* global_d) {
+    return pthread_mutex_trylock((pthread_mutex_t*) global_d);
+}
+
+static void* rt_mutex_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    pthread_mutex_t * the_locks;
+    the_locks = (pthread_mutex_t*) malloc(num_locks * sizeof(pthread_mutex_t));
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        pthread_mutex_init(&the_locks[i], NULL);
+    }
+    return the_locks;
+}
+
+static void* rt_mutex_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    //assign the thread to the correct core
+    set_cpu(thread_num);
+    return NULL;
+}
+
+static void rt_mutex_end_array_global(void* the_locks, uint32_t num_locks) {
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        pthread_mutex_destroy(&((pthread_mutex_t*) the_locks)[i]);
+    }
+    free(the_locks);
+}
+
+static int rt_mutex_init_global(uint32_t num_threads, void* the_lock) {
+    pthread_mutex_init((pthread_mutex_t*) the_lock, NULL);
+    return 0;
+}
+
+static int rt_mutex_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    //assign the thread to the correct core
+    set_cpu(thread_num);
+    return 0;
+}
+
+static void rt_mutex_end_global(void* the_lock) {
+    pthread_mutex_destroy((pthread_mutex_t*) the_lock);
+}
+
+/*
+ *  HTICKET
+ */
+
+static void rt_htlock_acquire(void* local_d, void* global_d) {
+    htlock_lock((htlock_t*) global_d);
+}
+
+static void rt_htlock_release(void* local_d, void* global_d) {
+    htlock_release((htlock_t*) global_d);
+}
+
+static int rt_htlock_trylock(void* local_d, void* global_d) {
+    if (htlock_trylock((htlock_t*) global_d)) return 0;
+    return 1;
+}
+
+static void rt_htlock_release_trylock(void* local_d, void* global_d) {
+    htlock_release_try((htlock_t*) global_d);
+}
+
+static void* rt_htlock_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_htlocks(num_locks);
+}
+
+static void* rt_htlock_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    init_thread_htlocks(thread_num);
+    return NULL;
+}
+
+static void rt_htlock_end_array_global(void* the_locks, uint32_t num_locks) {
+    free_htlocks((htlock_t*) the_locks);
+}
+
+static int rt_htlock_init_global(uint32_t num_threads, void* the_lock) {
+    return create_htlock((htlock_t*) the_lock);
+}
+
+static int rt_htlock_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    init_thread_htlocks(thread_num);
+    return 0;
+}
+
+/*
+ *  COHORT
+ */
+
+static void rt_cohort_acquire(void* local_d, void* global_d) {
+    cohort_acquire((cohort_lock_t*) global_d, (cohort_local_params*) local_d);
+}
+
+static void rt_cohort_release(void* local_d, void* global_d) {
+    cohort_release((cohort_lock_t*) global_d, (cohort_local_params*) local_d);
+}
+
+static int rt_cohort_trylock(void* local_d, void* global_d) {
+    return cohort_trylock((cohort_lock_t*) global_d, (cohort_local_params*) local_d);
+}
+
+static void* rt_cohort_bo_mcs_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_cohort_array_global(num_locks, COHORT_GLOBAL_BO, COHORT_LOCAL_MCS);
+}
+
+static void* rt_cohort_tkt_tkt_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_cohort_array_global(num_locks, COHORT_GLOBAL_TKT, COHORT_LOCAL_TKT);
+}
+
+static void* rt_cohort_mcs_mcs_init_array_global(uint32_t num_locks, uint32_t num_threads) {
+    return init_cohort_array_global(num_locks, COHORT_GLOBAL_MCS, COHORT_LOCAL_MCS);
+}
+
+static void* rt_cohort_init_array_local(uint32_t thread_num, uint32_t num_locks, void* the_locks) {
+    return init_cohort_array_local(thread_num, num_locks);
+}
+
+static void rt_cohort_end_array_local(void* local_d, uint32_t num_locks) {
+    end_cohort_array_local((cohort_local_params*) local_d, num_locks);
+}
+
+static void rt_cohort_end_array_global(void* the_locks, uint32_t num_locks) {
+    end_cohort_array_global((cohort_lock_t*) the_locks, num_locks);
+}
+
+static int rt_cohort_bo_mcs_init_global(uint32_t num_threads, void* the_lock) {
+    return init_cohort_global((cohort_lock_t*) the_lock, COHORT_GLOBAL_BO, COHORT_LOCAL_MCS);
+}
+
+static int rt_cohort_tkt_tkt_init_global(uint32_t num_threads, void* the_lock) {
+    return init_cohort_global((cohort_lock_t*) the_lock, COHORT_GLOBAL_TKT, COHORT_LOCAL_TKT);
+}
+
+static int rt_cohort_mcs_mcs_init_global(uint32_t num_threads, void* the_lock) {
+    return init_cohort_global((cohort_lock_t*) the_lock, COHORT_GLOBAL_MCS, COHORT_LOCAL_MCS);
+}
+
+static int rt_cohort_init_local(uint32_t thread_num, void* the_lock, void* local_d) {
+    return init_cohort_local(thread_num, (cohort_local_params*) local_d);
+}
+
+static void rt_cohort_end_local(void* local_d) {
+    end_cohort_local(*(cohort_local_params*) local_d);
+}
+
+static void rt_cohort_end_global(void* the_lock) {
+    end_cohort_global(*(cohort_lock_t*) the_lock);
+}
+
+/*
+ *  Nothing to be done
+ */
+
+static void rt_nop_end_array_local(void* local_d, uint32_t num_locks) {
+}
+
+static void rt_nop_end_local(void* local_d) {
+}
+
+static void rt_nop_end_global(void* the_lock) {
+}
+
+/*
+ *  Timeouts of the locks that cannot leave their queue: poll with trylock
+ */
+
+static int rt_poll_acquire_timeout(void* local_d, void* global_d, ticks timeout) {
+    ticks start = getticks();
+    while (lock_rt.trylock(local_d, global_d) != 0) {
+        if ((getticks() - start) > timeout) return 1;
+        PAUSE;
+    }
+    return 0;
+}
+
+/*
+ *  Number of threads holding or waiting for a lock, used by the lock statistics
+ */
+
+static uint32_t rt_mcs_queue_length(void* local_d, void* global_d) {
+    return !is_free_mcs(((mcs_global_params*) global_d)->the_lock);
+}
+
+static uint32_t rt_cna_queue_length(void* local_d, void* global_d) {
+    return !is_free_cna(((cna_global_params*) global_d)->the_lock);
+}
+
+static uint32_t rt_hclh_queue_length(void* local_d, void* global_d) {
+    hclh_local_params* l = (hclh_local_params*) local_d;
+    return !is_free_hclh(l->my_queue, ((hclh_global_params*) global_d)->shared_queue, l->my_qnode);
+}
+
+static uint32_t rt_ttas_queue_length(void* local_d, void* global_d) {
+    return !is_free_ttas((ttas_lock_t*) global_d);
+}
+
+static uint32_t rt_spinlock_queue_length(void* local_d, void* global_d) {
+    return !is_free_spinlock((spinlock_lock_t*) global_d);
+}
+
+static uint32_t rt_alock_queue_length(void* local_d, void* global_d) {
+    return !is_free_alock((lock_shared_t*) global_d);
+}
+
+static uint32_t rt_rw_queue_length(void* local_d, void* global_d) {
+    return !is_free_rw((rw_ttas*) global_d);
+}
+
+static uint32_t rt_rw_numa_queue_length(void* local_d, void* global_d) {
+    return !is_free_rw_numa((rw_numa_lock_t*) global_d);
+}
+
+static uint32_t rt_clh_queue_length(void* local_d, void* global_d) {
+    return (*((clh_global_params*) global_d)->the_lock)->locked != 0;
+}
+
+static uint32_t rt_ticket_queue_length(void* local_d, void* global_d) {
+    ticketlock_t* t = (ticketlock_t*) global_d;
+    return t->tail - t->head + 1;
+}
+
+static uint32_t rt_qspin_queue_length(void* local_d, void* global_d) {
+    return qspin_queue_length((qspin_lock_t*) global_d);
+}
+
+static uint32_t rt_shfl_queue_length(void* local_d, void* global_d) {
+    return shfl_queue_length((shfl_lock_t*) global_d);
+}
+
+static uint32_t rt_alock_dyn_queue_length(void* local_d, void* global_d) {
+    return alock_dyn_queue_length((alock_dyn_lock_t*) global_d);
+}
+
+static uint32_t rt_hmcs_queue_length(void* local_d, void* global_d) {
+    return !is_free_hmcs((hmcs_lock_t*) global_d);
+}
+
+static uint32_t rt_mutex_queue_length(void* local_d, void* global_d) {
+#ifdef __GLIBC__
+    return ((pthread_mutex_t*) global_d)->__data.__lock != 0;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t rt_hticket_queue_length(void* local_d, void* global_d) {
+    return !is_free_hticket((htlock_t*) global_d);
+}
+
+static uint32_t rt_cohort_queue_length(void* local_d, void* global_d) {
+    return !is_free_cohort((cohort_lock_t*) global_d);
+}
+
+/*
+ *  The table of algorithms
+ */
+
+static const lock_rt_ops lock_rt_table[] = {
+    { rt_mcs_acquire, rt_mcs_release, rt_mcs_acquire, rt_mcs_release, rt_mcs_trylock, rt_mcs_release,
+      "MCS", sizeof(mcs_global_params), sizeof(mcs_local_params),
+      rt_mcs_init_array_global, rt_mcs_init_array_local, rt_mcs_end_array_local, rt_mcs_end_array_global,
+      rt_mcs_init_global, rt_mcs_init_local, rt_mcs_end_local, rt_mcs_end_global,
+      rt_mcs_acquire_timeout,
+      rt_mcs_queue_length },
+    { rt_cna_acquire, rt_cna_release, rt_cna_acquire, rt_cna_release, rt_cna_trylock, rt_cna_release,
+      "CNA", sizeof(cna_global_params), sizeof(cna_local_params),
+      rt_cna_init_array_global, rt_cna_init_array_local, rt_cna_end_array_local, rt_cna_end_array_global,
+      rt_cna_init_global, rt_cna_init_local, rt_cna_end_local, rt_cna_end_global,
+      rt_poll_acquire_timeout,
+      rt_cna_queue_length },
+    { rt_hmcs_acquire, rt_hmcs_release, rt_hmcs_acquire, rt_hmcs_release, rt_hmcs_trylock, rt_hmcs_release,
+      "HMCS", sizeof(hmcs_lock_t), sizeof(hmcs_local_params),
+      rt_hmcs_init_array_global, rt_hmcs_init_array_local, rt_hmcs_end_array_local, rt_hmcs_end_array_global,
+      rt_hmcs_init_global, rt_hmcs_init_local, rt_hmcs_end_local, rt_hmcs_end_global,
+      rt_poll_acquire_timeout,
+      rt_hmcs_queue_length },
+    { rt_shfl_acquire, rt_shfl_release, rt_shfl_acquire, rt_shfl_release, rt_shfl_trylock, rt_shfl_release,
+      "SHFL", sizeof(shfl_lock_t), 0,
+      rt_shfl_init_array_global, rt_shfl_init_array_local, rt_shfl_end_array_local, rt_shfl_end_array_global,
+      rt_shfl_init_global, rt_shfl_init_local, rt_shfl_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_shfl_queue_length },
+    { rt_hclh_acquire, rt_hclh_release, rt_hclh_acquire, rt_hclh_release, rt_hclh_trylock, rt_hclh_release,
+      "HCLH", sizeof(hclh_global_params), sizeof(hclh_local_params),
+      rt_hclh_init_array_global, rt_hclh_init_array_local, rt_hclh_end_array_local, rt_hclh_end_array_global,
+      rt_hclh_init_global, rt_hclh_init_local, rt_hclh_end_local, rt_hclh_end_global,
+      rt_hclh_acquire_timeout,
+      rt_hclh_queue_length },
+    { rt_ttas_acquire, rt_ttas_release, rt_ttas_acquire, rt_ttas_release, rt_ttas_trylock, rt_ttas_release,
+      "TTAS", sizeof(ttas_lock_t), sizeof(uint32_t),
+      rt_ttas_init_array_global, rt_ttas_init_array_local, rt_ttas_end_array_local, rt_ttas_end_array_global,
+      rt_ttas_init_global, rt_ttas_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_ttas_queue_length },
+    { rt_spinlock_acquire, rt_spinlock_release, rt_spinlock_acquire, rt_spinlock_release, rt_spinlock_trylock, rt_spinlock_release,
+      "SPINLOCK", sizeof(spinlock_lock_t), sizeof(uint32_t),
+      rt_spinlock_init_array_global, rt_spinlock_init_array_local, rt_spinlock_end_array_local, rt_spinlock_end_array_global,
+      rt_spinlock_init_global, rt_spinlock_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_spinlock_queue_length },
+    { rt_alock_acquire, rt_alock_release, rt_alock_acquire, rt_alock_release, rt_alock_trylock, rt_alock_release,
+      "ARRAY", sizeof(lock_shared_t), sizeof(array_lock_t),
+      rt_alock_init_array_global, rt_alock_init_array_local, rt_alock_end_array_local, rt_alock_end_array_global,
+      rt_alock_init_global, rt_alock_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_alock_queue_length },
+    { rt_alock_dyn_acquire, rt_alock_dyn_release, rt_alock_dyn_acquire, rt_alock_dyn_release, rt_alock_dyn_trylock, rt_alock_dyn_release,
+      "ARRAY_DYN", sizeof(alock_dyn_lock_t), 0,
+      rt_alock_dyn_init_array_global, rt_alock_dyn_init_array_local, rt_nop_end_array_local, rt_alock_dyn_end_array_global,
+      rt_alock_dyn_init_global, rt_alock_dyn_init_local, rt_nop_end_local, rt_alock_dyn_end_global,
+      rt_poll_acquire_timeout,
+      rt_alock_dyn_queue_length },
+    { rt_rw_acquire, rt_rw_release, rt_rw_acquire_read, rt_rw_release_read, rt_rw_trylock, rt_rw_release,
+      "RW", sizeof(rw_ttas), sizeof(uint32_t),
+      rt_rw_init_array_global, rt_rw_init_array_local, rt_rw_end_array_local, rt_rw_end_array_global,
+      rt_rw_init_global, rt_rw_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_rw_queue_length },
+    { rt_rw_numa_acquire, rt_rw_numa_release, rt_rw_numa_acquire_read, rt_rw_numa_release_read, rt_rw_numa_trylock, rt_rw_numa_release,
+      "RW_NUMA", sizeof(rw_numa_lock_t), sizeof(rw_numa_local_params),
+      rt_rw_numa_init_array_global, rt_rw_numa_init_array_local, rt_rw_numa_end_array_local, rt_rw_numa_end_array_global,
+      rt_rw_numa_init_global, rt_rw_numa_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_rw_numa_queue_length },
+    { rt_clh_acquire, rt_clh_release, rt_clh_acquire, rt_clh_release, rt_clh_trylock, rt_clh_release,
+      "CLH", sizeof(clh_global_params), sizeof(clh_local_params),
+      rt_clh_init_array_global, rt_clh_init_array_local, rt_clh_end_array_local, rt_clh_end_array_global,
+      rt_clh_init_global, rt_clh_init_local, rt_clh_end_local, rt_clh_end_global,
+      rt_clh_acquire_timeout,
+      rt_clh_queue_length },
+    { rt_ticket_acquire, rt_ticket_release, rt_ticket_acquire, rt_ticket_release, rt_ticket_trylock, rt_ticket_release,
+      "TICKET", sizeof(ticketlock_t), 0,
+      rt_ticket_init_array_global, rt_ticket_init_array_local, rt_nop_end_array_local, rt_ticket_end_array_global,
+      rt_ticket_init_global, rt_ticket_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_ticket_queue_length },
+    { rt_qspin_acquire, rt_qspin_release, rt_qspin_acquire, rt_qspin_release, rt_qspin_trylock, rt_qspin_release,
+      "QSPIN", sizeof(qspin_lock_t), 0,
+      rt_qspin_init_array_global, rt_qspin_init_array_local, rt_qspin_end_array_local, rt_qspin_end_array_global,
+      rt_qspin_init_global, rt_qspin_init_local, rt_qspin_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_qspin_queue_length },
+    { rt_mutex_acquire, rt_mutex_release, rt_mutex_acquire, rt_mutex_release, rt_mutex_trylock, rt_mutex_release,
+      "MUTEX", sizeof(pthread_mutex_t), 0,
+      rt_mutex_init_array_global, rt_mutex_init_array_local, rt_nop_end_array_local, rt_mutex_end_array_global,
+      rt_mutex_init_global, rt_mutex_init_local, rt_nop_end_local, rt_mutex_end_global,
+      rt_poll_acquire_timeout,
+      rt_mutex_queue_length },
+    { rt_htlock_acquire, rt_htlock_release, rt_htlock_acquire, rt_htlock_release, rt_htlock_trylock, rt_htlock_release_trylock,
+      "HTICKET", sizeof(htlock_t), 0,
+      rt_htlock_init_array_global, rt_htlock_init_array_local, rt_nop_end_array_local, rt_htlock_end_array_global,
+      rt_htlock_init_global, rt_htlock_init_local, rt_nop_end_local, rt_nop_end_global,
+      rt_poll_acquire_timeout,
+      rt_hticket_queue_length },
+    { rt_cohort_acquire, rt_cohort_release, rt_cohort_acquire, rt_cohort_release, rt_cohort_trylock, rt_cohort_release,
+      "COHORT_BO_MCS", sizeof(cohort_lock_t), sizeof(cohort_local_params),
+      rt_cohort_bo_mcs_init_array_global, rt_cohort_init_array_local, rt_cohort_end_array_local, rt_cohort_end_array_global,
+      rt_cohort_bo_mcs_init_global, rt_cohort_init_local, rt_cohort_end_local, rt_cohort_end_global,
+      rt_poll_acquire_timeout,
+      rt_cohort_queue_length },
+    { rt_cohort_acquire, rt_cohort_release, rt_cohort_acquire, rt_cohort_release, rt_cohort_trylock, rt_cohort_release,
+      "COHORT_TKT_TKT", sizeof(cohort_lock_t), sizeof(cohort_local_params),
+      rt_cohort_tkt_tkt_init_array_global, rt_cohort_init_array_local, rt_cohort_end_array_local, rt_cohort_end_array_global,
+      rt_cohort_tkt_tkt_init_global, rt_cohort_init_local, rt_cohort_end_local, rt_cohort_end_global,
+      rt_poll_acquire_timeout,
+      rt_cohort_queue_length },
+    { rt_cohort_acquire, rt_cohort_release, rt_cohort_acquire, rt_cohort_release, rt_cohort_trylock, rt_cohort_release,
+      "COHORT_MCS_MCS", sizeof(cohort_lock_t), sizeof(cohort_local_params),
+      rt_cohort_mcs_mcs_init_array_global, rt_cohort_init_array_local, rt_cohort_end_array_local, rt_cohort_end_array_global,
+      rt_cohort_mcs_mcs_init_global, rt_cohort_init_local, rt_cohort_end_local, rt_cohort_end_global,
+      rt_poll_acquire_timeout,
+      rt_cohort_queue_length },
+};
+
+#define LOCK_RT_NUM (sizeof(lock_rt_table) / sizeof(lock_rt_table[0]))
+
+const char* lock_rt_names[] = {
+    "MCS", "HCLH", "TTAS", "SPINLOCK", "ARRAY", "RW", "CLH", "TICKET", "MUTEX", "HTICKET",
+    "COHORT_BO_MCS", "COHORT_TKT_TKT", "COHORT_MCS_MCS", "CNA", "RW_NUMA", "QSPIN", "ARRAY_DYN", "HMCS", "SHFL", NULL
+};
+
+lock_rt_ops lock_rt;
+
+int lock_rt_select(const char* name) {
+    uint32_t i;
+    if (name == NULL) return 1;
+    //accept both "mcs" and "USE_MCS_LOCKS"
+    if (strncasecmp(name, "USE_", 4) == 0) name += 4;
+    for (i = 0; i < LOCK_RT_NUM; i++) {
+        size_t len = strlen(lock_rt_table[i].name);
+        if (strncasecmp(name, lock_rt_table[i].name, len) == 0 &&
+                (name[len] == '\0' || strcasecmp(name + len, "_LOCKS") == 0)) {
+            lock_rt = lock_rt_table[i];
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const char* lock_rt_init() {
+    if (lock_rt.name != NULL) return lock_rt.name;
+    char* env = getenv(LOCK_RT_ENV);
+    if (env != NULL && lock_rt_select(env) != 0) {
+        fprintf(stderr, "Unknown lock %s in %s, using %s\n", env, LOCK_RT_ENV, LOCK_RT_DEFAULT);
+    }
+    if (lock_rt.name == NULL) {
+        lock_rt_select(LOCK_RT_DEFAULT);
+    }
+    return lock_rt.name;
+}
+
+/*
+ *  Arrays: the global array points into the array of the selected algorithm;
+ *  the local array copies the local data, the first (hidden) element keeping
+ *  the array of the selected algorithm to be able to free it
+ */
+
+rt_global_params* init_rt_array_global(uint32_t num_locks, uint32_t num_threads) {
+    lock_rt_init();
+    uint8_t* base = (uint8_t*) lock_rt.init_array_global(num_locks, num_threads);
+    rt_global_params* the_locks = (rt_global_params*) malloc(num_locks * sizeof(rt_global_params));
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        the_locks[i].the_lock = base + i * lock_rt.global_size;
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+rt_local_params* init_rt_array_local(uint32_t thread_num, uint32_t num_locks, rt_global_params* the_locks) {
+    lock_rt_init();
+    uint8_t* base = (uint8_t*) lock_rt.init_array_local(thread_num, num_locks, the_locks[0].the_lock);
+    rt_local_params* local_params = (rt_local_params*) malloc((num_locks + 1) * sizeof(rt_local_params));
+    local_params[0].base = base;
+    uint32_t i;
+    if (lock_rt.local_size > 0) {
+        for (i = 0; i < num_locks; i++) {
+            memcpy(&local_params[i + 1], base + i * lock_rt.local_size, lock_rt.local_size);
+        }
+    }
+    MEM_BARRIER;
+    return local_params + 1;
+}
+
+void end_rt_array_local(rt_local_params* local_params, uint32_t size) {
+    uint8_t* base = (uint8_t*) local_params[-1].base;
+    uint32_t i;
+    //the local data may have changed (e.g. clh recycles the qnodes)
+    if (lock_rt.local_size > 0) {
+        for (i = 0; i < size; i++) {
+            memcpy(base + i * lock_rt.local_size, &local_params[i], lock_rt.local_size);
+        }
+    }
+    lock_rt.end_array_local(base, size);
+    free(local_params - 1);
+}
+
+void end_rt_array_global(rt_global_params* the_locks, uint32_t size) {
+    lock_rt.end_array_global(the_locks[0].the_lock, size);
+    free(the_locks);
+}
+
+/*
+ *  Single locks
+ */
+
+int init_rt_global(uint32_t num_threads, rt_global_params* the_lock) {
+    lock_rt_init();
+    the_lock->the_lock = memalign(CACHE_LINE_SIZE, lock_rt.global_size);
+    if (the_lock->the_lock == NULL) {
+        fprintf(stderr, "Error @ memalign : init_rt_global\n");
+        return 1;
+    }
+    return lock_rt.init_global(num_threads, the_lock->the_lock);
+}
+
+int init_rt_local(uint32_t thread_num, rt_global_params* the_lock, rt_local_params* local_d) {
+    lock_rt_init();
+    return lock_rt.init_local(thread_num, the_lock->the_lock, local_d);
+}
+
+void end_rt_local(rt_local_params local_d) {
+    lock_rt.end_local(&local_d);
+}
+
+void end_rt_global(rt_global_params the_lock) {
+    lock_rt.end_global(the_lock.the_lock);
+    free(the_lock.the_lock);
+}
@@ -0,0 +1,182 @@
+/*
+ * File: lock_stats.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Registration and aggregation of the lock statistics
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "lock_stats.h"
+
+__thread lock_stats_t* lock_stats_mine = NULL;
+__thread uint32_t lock_stats_cluster = 0;
+__thread void* lock_stats_held_lock[LOCK_STATS_MAX_HELD];
+__thread ticks lock_stats_held_at[LOCK_STATS_MAX_HELD];
+__thread uint32_t lock_stats_held = 0;
+__thread uint32_t lock_stats_held_overflow = 0;
+
+static lock_stats_t* volatile lock_stats_threads[LOCK_STATS_MAX_THREADS];
+static volatile uint32_t lock_stats_num_threads = 0;
+
+static lock_stats_slot_t lock_stats_slots[LOCK_STATS_SLOTS];
+static volatile uint32_t lock_stats_slots_init = 0;
+
+static void lock_stats_clear_slot(lock_stats_slot_t* slot) {
+    slot->acquires = 0;
+    slot->contended = 0;
+    slot->wait_cycles = 0;
+    slot->hold_cycles = 0;
+    slot->cross_socket = 0;
+    slot->last_cluster = LOCK_STATS_NO_CLUSTER;
+}
+
+void lock_stats_thread_init(uint32_t core) {
+    lock_stats_cluster = get_cluster(core);
+    if (lock_stats_mine != NULL) {
+        return;
+    }
+    if (CAS_U32(&lock_stats_slots_init, 0, 1) == 0) {
+        uint32_t i;
+        for (i = 0; i < LOCK_STATS_SLOTS; i++) {
+            lock_stats_clear_slot(&lock_stats_slots[i]);
+        }
+        MEM_BARRIER;
+        lock_stats_slots_init = 2;
+    }
+    while (lock_stats_slots_init != 2) {
+        PAUSE;
+    }
+
+    lock_stats_t* s = (lock_stats_t*) memalign(CACHE_LINE_SIZE, sizeof(lock_stats_t));
+    assert(s != NULL);
+    memset(s, 0, sizeof(lock_stats_t));
+    uint32_t id = FAI_U32(&lock_stats_num_threads);
+    assert(id < LOCK_STATS_MAX_THREADS);
+    lock_stats_threads[id] = s;
+    lock_stats_mine = s;
+}
+
+lock_stats_slot_t* lock_stats_slot(void* lock) {
+    uintptr_t h = ((uintptr_t) lock >> 3) * 0x9E3779B97F4A7C15ULL;
+    uint32_t i;
+    for (i = 0; i < LOCK_STATS_PROBES; i++) {
+        lock_stats_slot_t* slot = &lock_stats_slots[(h + i) & (LOCK_STATS_SLOTS - 1)];
+        void* owner = slot->lock;
+        if (owner == lock) {
+            return slot;
+        }
+        if (owner == NULL && CAS_PTR(&slot->lock, NULL, lock) == NULL) {
+            return slot;
+        }
+        if (slot->lock == lock) {
+            //claimed by another thread meanwhile
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+void lock_stats_aggregate(lock_stats_t* total) {
+    memset(total, 0, sizeof(lock_stats_t));
+    uint32_t n = lock_stats_num_threads;
+    uint32_t i;
+    for (i = 0; i < n && i < LOCK_STATS_MAX_THREADS; i++) {
+        lock_stats_t* s = lock_stats_threads[i];
+        if (s == NULL) {
+            continue;
+        }
+        total->acquires += s->acquires;
+        total->exclusive += s->exclusive;
+        total->contended += s->contended;
+        total->wait_cycles += s->wait_cycles;
+        total->hold_cycles += s->hold_cycles;
+        total->queued += s->queued;
+        total->cross_socket += s->cross_socket;
+    }
+}
+
+void lock_stats_reset() {
+    uint32_t n = lock_stats_num_threads;
+    uint32_t i;
+    for (i = 0; i < n && i < LOCK_STATS_MAX_THREADS; i++) {
+        lock_stats_t* s = lock_stats_threads[i];
+        if (s != NULL) {
+            memset(s, 0, sizeof(lock_stats_t));
+        }
+    }
+    for (i = 0; i < LOCK_STATS_SLOTS; i++) {
+        lock_stats_clear_slot(&lock_stats_slots[i]);
+    }
+    MEM_BARRIER;
+}
+
+static void lock_stats_print_one(lock_stats_t* s) {
+    double acq = (s->acquires > 0) ? (double) s->acquires : 1;
+    //the hold time and the hand-offs are only measured for the exclusive acquisitions
+    double excl = (s->exclusive > 0) ? (double) s->exclusive : 1;
+    printf("#Acquires: %10llu / Exclusive: %10llu / Contended: %6.2f%% / Avg. queuing (exact for ticket only): %.3f / Avg. wait: %.0f / Avg. hold: %.0f / Cross-socket: %6.2f%%\n",
+            (long long unsigned) s->acquires, (long long unsigned) s->exclusive, 100 * s->contended / acq, lock_stats_avg_queue(s),
+            s->wait_cycles / acq, s->hold_cycles / excl, 100 * s->cross_socket / excl);
+}
+
+void lock_stats_print() {
+    lock_stats_t total;
+    lock_stats_aggregate(&total);
+    lock_stats_print_one(&total);
+}
+
+void lock_stats_print_thread() {
+    lock_stats_print_one(lock_stats_self());
+}
+
+void lock_stats_print_hot(uint32_t num_locks) {
+    //selection of the slots with the most contended acquisitions
+    uint8_t* printed = (uint8_t*) calloc(LOCK_STATS_SLOTS, 1);
+    assert(printed != NULL);
+    uint32_t n, i;
+    for (n = 0; n < num_locks; n++) {
+        lock_stats_slot_t* best = NULL;
+        uint32_t best_i = 0;
+        for (i = 0; i < LOCK_STATS_SLOTS; i++) {
+            lock_stats_slot_t* slot = &lock_stats_slots[i];
+            if (printed[i] || slot->lock == NULL || slot->acquires == 0) {
+                continue;
+            }
+            if (best == NULL || slot->contended > best->contended) {
+                best = slot;
+                best_i = i;
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+        printed[best_i] = 1;
+        //the slots only count the exclusive acquisitions
+        double acq = (double) best->acquires;
+        printf("Lock %p : acquires: %-10llu contended: %6.2f%% avg wait: %.0f avg hold: %.0f cross-socket: %6.2f%%\n",
+                best->lock, (long long unsigned) best->acquires, 100 * best->contended / acq,
+                best->wait_cycles / acq, best->hold_cycles / acq, 100 * best->cross_socket / acq);
+    }
+    free(printed);
+}
@@ -32,6 +32,15 @@
 
 #include "mcs.h"
 
+#if defined(SPIN_THEN_PARK)
+__thread ticks mcs_park_budget = PARK_SPIN_INIT;
+#  define MCS_SWAP_WAITING(q, v) SWAP_U32(&((q)->waiting), v)
+#  define MCS_CAS_WAITING(q, o, n) CAS_U32(&((q)->waiting), o, n)
+#else
+#  define MCS_SWAP_WAITING(q, v) SWAP_U8(&((q)->waiting), v)
+#  define MCS_CAS_WAITING(q, o, n) CAS_U8(&((q)->waiting), o, n)
+#endif
+
 int mcs_trylock(mcs_lock *L, mcs_qnode_ptr I) {
     I->next=NULL;
 #ifndef  __tile__
@@ -60,6 +69,25 @@ void mcs_acquire(mcs_lock *L, mcs_qnode_ptr I)
     MEM_BARRIER;
     pred->next = I; // make pred point to me
 
+#if defined(SPIN_THEN_PARK)
+    uint32_t spins = 0;
+    ticks start = getticks();
+    while (I->waiting != 0) 
+    {
+        if (park_spin_done(start, mcs_park_budget, &spins)) {
+            //out of budget: tell the predecessor to wake us, and sleep
+            park_budget_parked(&mcs_park_budget);
+            if (CAS_U32(&(I->waiting), 1, 2) == 1) {
+                while (I->waiting != 0) {
+                    park_wait(&(I->waiting), 2);
+                }
+            }
+            return;
+        }
+        PAUSE;
+    }
+    park_budget_spun(&mcs_park_budget, getticks() - start);
+#else
 #if defined(OPTERON_OPTIMIZE)
     PREFETCHW(I);
 #endif	/* OPTERON_OPTIMIZE */
@@ -71,9 +99,40 @@ void mcs_acquire(mcs_lock *L, mcs_qnode_ptr I)
         PREFETCHW(I);
 #endif	/* OPTERON_OPTIMIZE */
     }
+#endif	/* SPIN_THEN_PARK */
 
 }
 
+int mcs_acquire_timeout(mcs_lock *L, mcs_qnode** my_qnode, ticks timeout)
+{
+    mcs_qnode_ptr I = *my_qnode;
+    I->next = NULL;
+#ifdef  __tile__
+    MEM_BARRIER;
+#endif
+    mcs_qnode_ptr pred = (mcs_qnode*) SWAP_PTR((volatile void*) L, (void*) I);
+    if (pred == NULL) 		/* lock was free */
+        return 0;
+    I->waiting = 1;
+    MEM_BARRIER;
+    pred->next = I;
+
+    ticks start = getticks();
+    while (I->waiting != 0) 
+    {
+        if ((getticks() - start) > timeout) {
+            if (MCS_CAS_WAITING(I, 1, MCS_ABANDONED) != 1) {
+                return 0; //granted in the meantime
+            }
+            //the node stays in the queue until a releaser skips it and frees it
+            *my_qnode = (mcs_qnode*) malloc(sizeof(mcs_qnode));
+            return 1;
+        }
+        PAUSE;
+    }
+    return 0;
+}
+
 void mcs_release(mcs_lock *L, mcs_qnode_ptr I) 
 {
 #ifdef __tile__
@@ -94,7 +153,28 @@ void mcs_release(mcs_lock *L, mcs_qnode_ptr I)
             PAUSE;
         } while (!succ); // wait for successor
     }
-    succ->waiting = 0;
+    uint32_t old_waiting;
+    while ((old_waiting = MCS_SWAP_WAITING(succ, 0)) == MCS_ABANDONED) {
+        /* the waiter gave up: skip its node and free it */
+        mcs_qnode_ptr next = succ->next;
+        if (next == NULL) {
+            if (CAS_PTR(L, succ, NULL) == succ) {
+                free((void*) succ);
+                return;
+            }
+            do {
+                next = succ->next;
+                PAUSE;
+            } while (!next);
+        }
+        free((void*) succ);
+        succ = next;
+    }
+#if defined(SPIN_THEN_PARK)
+    if (old_waiting == 2) {
+        park_wake(&(succ->waiting), 1);
+    }
+#endif
 }
 
 int is_free_mcs(mcs_lock *L ){
@@ -0,0 +1,47 @@
+/*
+ * File: qnode_pool.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Per-thread pools of queue nodes
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qnode_pool.h"
+
+__thread qnode_pool_entry_t qnode_pool[QNODE_POOL_SIZE];
+__thread uint32_t qnode_pool_depth = 0;
+
+void qnode_pool_overflow() {
+    fprintf(stderr, "Error: more than %d locks held or waited for by a thread (QNODE_POOL_SIZE)\n", QNODE_POOL_SIZE);
+    exit(1);
+}
+
+void* qnode_pool_alloc(size_t size) {
+    void* node = memalign(CACHE_LINE_SIZE, size);
+    if (node == NULL) {
+        perror("memalign");
+        exit(1);
+    }
+    return node;
+}
@@ -0,0 +1,195 @@
+/*
+ * File: qspin.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of the 32-bit queued spinlock
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qspin.h"
+
+
+/*
+ *  Acquire and release methods
+ */
+
+int qspin_trylock(qspin_lock_t* lock) {
+    if (lock->val == 0 && CAS_U32(&lock->val, 0, QSPIN_LOCKED) == 0) {
+        return 0;
+    }
+    return 1;
+}
+
+//waits in the MCS queue; the head of the queue spins on the lock word
+static void qspin_acquire_queued(qspin_lock_t* lock) {
+    uint32_t val;
+    uint32_t tid = qtail_thread_init();
+    uint32_t idx = qtail_nesting;
+    if (idx >= QTAIL_MAX_NESTING || tid == 0) {
+        //out of nodes or of thread ids: spin on the lock word
+        while (qspin_trylock(lock) != 0) {
+            PAUSE;
+        }
+        return;
+    }
+    qtail_nesting++;
+    qspin_node_t* node = (qspin_node_t*) qtail_node(tid, idx);
+    node->locked = 0;
+    node->next = NULL;
+    COMPILER_BARRIER;
+    //the lock may have been released meanwhile
+    if (qspin_trylock(lock) == 0) {
+        qtail_nesting--;
+        return;
+    }
+
+    uint32_t tail = qtail_encode(tid, idx);
+    uint32_t old = ((uint32_t) SWAP_U16(&lock->tail, (uint16_t) (tail >> 16))) << 16;
+    if (old != 0) {
+        qspin_node_t* prev = (qspin_node_t*) qtail_decode(old);
+        prev->next = node;
+        while (node->locked == 0) {
+            PAUSE;
+        }
+    }
+
+    //head of the queue: wait for the owner and the pending waiter to leave
+    while ((val = lock->val) & (QSPIN_LOCKED_MASK | QSPIN_PENDING)) {
+        PAUSE;
+    }
+    if ((val & QSPIN_TAIL_MASK) == tail && CAS_U32(&lock->val, val, QSPIN_LOCKED) == val) {
+        //last in the queue, the tail is cleared
+        qtail_nesting--;
+        return;
+    }
+    //while the tail is set nobody else takes the lock or sets the pending bit
+    lock->locked = QSPIN_LOCKED;
+    qspin_node_t* next;
+    while ((next = node->next) == NULL) {
+        PAUSE;
+    }
+    next->locked = 1;
+    qtail_nesting--;
+}
+
+void qspin_acquire(qspin_lock_t* lock) {
+    uint32_t val = CAS_U32(&lock->val, 0, QSPIN_LOCKED);
+    if (val == 0) {
+        return;
+    }
+
+    //a pending waiter is taking the lock: let it finish
+    uint32_t loops = QSPIN_PENDING_LOOPS;
+    while (val == QSPIN_PENDING && loops-- > 0) {
+        PAUSE;
+        val = lock->val;
+    }
+
+    //become the pending waiter, unless there already is one or a queue
+    while ((val & ~QSPIN_LOCKED_MASK) == 0) {
+        uint32_t old = CAS_U32(&lock->val, val, val | QSPIN_PENDING);
+        if (old == val) {
+            while (lock->locked) {
+                PAUSE;
+            }
+            //clear the pending bit and take the lock
+            val = lock->val;
+            while ((old = CAS_U32(&lock->val, val, (val & ~QSPIN_PENDING) | QSPIN_LOCKED)) != val) {
+                val = old;
+            }
+            return;
+        }
+        val = old;
+    }
+    qspin_acquire_queued(lock);
+}
+
+void qspin_release(qspin_lock_t* lock) {
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    COMPILER_BARRIER;
+    lock->locked = 0;
+}
+
+int is_free_qspin(qspin_lock_t* lock) {
+    if ((lock->val & QSPIN_LOCKED_MASK) == 0) return 1;
+    return 0;
+}
+
+uint32_t qspin_queue_length(qspin_lock_t* lock) {
+    uint32_t val = lock->val;
+    return ((val & QSPIN_LOCKED_MASK) != 0) + ((val & QSPIN_PENDING) != 0) + ((val & QSPIN_TAIL_MASK) != 0);
+}
+
+/*
+ *  Initialization
+ */
+
+qspin_lock_t* init_qspin_array_global(uint32_t num_locks) {
+    qspin_lock_t* the_locks;
+    the_locks = (qspin_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(qspin_lock_t));
+    assert(the_locks != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        the_locks[i].val = 0;
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+void init_qspin_array_local(uint32_t thread_num) {
+    set_cpu(thread_num);
+    qtail_thread_init();
+    MEM_BARRIER;
+}
+
+void end_qspin_array_local() {
+    qtail_release_tid();
+}
+
+void end_qspin_array_global(qspin_lock_t* the_locks) {
+    free(the_locks);
+}
+
+int init_qspin_global(qspin_lock_t* the_lock) {
+    the_lock->val = 0;
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_qspin_local(uint32_t thread_num) {
+    set_cpu(thread_num);
+    qtail_thread_init();
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_qspin_local() {
+    qtail_release_tid();
+}
+
+void end_qspin_global(qspin_lock_t the_lock) {
+    //method not needed
+}
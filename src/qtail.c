@@ -0,0 +1,79 @@
+/*
+ * File: qtail.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Queue nodes and thread ids of the queue locks whose tail names a thread
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "qtail.h"
+
+qtail_node_t qtail_nodes[QTAIL_MAX_THREADS][QTAIL_MAX_NESTING];
+
+__thread uint32_t qtail_tid = 0;
+__thread uint32_t qtail_nesting = 0;
+
+static volatile uint32_t qtail_used[QTAIL_MAX_THREADS];
+static volatile uint32_t qtail_full_reported = 0;
+static pthread_key_t qtail_key;
+static pthread_once_t qtail_key_once = PTHREAD_ONCE_INIT;
+
+//destructor of the key: the id of an exiting thread goes back to the others
+static void qtail_thread_exit(void* tid) {
+    qtail_release_tid();
+}
+
+static void qtail_key_create() {
+    if (pthread_key_create(&qtail_key, qtail_thread_exit) != 0) {
+        perror("pthread_key_create");
+    }
+}
+
+uint32_t qtail_claim_tid() {
+    pthread_once(&qtail_key_once, qtail_key_create);
+    uint32_t i;
+    for (i = 0; i < QTAIL_MAX_THREADS; i++) {
+        if (qtail_used[i] == 0 && CAS_U32(&qtail_used[i], 0, 1) == 0) {
+            qtail_tid = i + 1;
+            pthread_setspecific(qtail_key, (void*) (uintptr_t) qtail_tid);
+            return qtail_tid;
+        }
+    }
+    if (qtail_full_reported == 0 && CAS_U32(&qtail_full_reported, 0, 1) == 0) {
+        fprintf(stderr, "qtail: more than %d threads queue at the same time (QTAIL_MAX_THREADS), the others spin on the lock word\n", QTAIL_MAX_THREADS);
+    }
+    return 0;
+}
+
+void qtail_release_tid() {
+    uint32_t tid = qtail_tid;
+    if (tid == 0) {
+        return;
+    }
+    qtail_tid = 0;
+    pthread_setspecific(qtail_key, NULL);
+    //the nodes of the thread are not used any more
+    MEM_BARRIER;
+    qtail_used[tid - 1] = 0;
+}
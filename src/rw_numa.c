@@ -0,0 +1,197 @@
+/*
+ * File: rw_numa.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of the NUMA-aware reader-writer lock
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "rw_numa.h"
+
+//number of reader counters in use
+static inline uint32_t rw_numa_sockets() {
+    return (NUMBER_OF_SOCKETS < MAX_SOCKETS) ? NUMBER_OF_SOCKETS : MAX_SOCKETS;
+}
+
+static inline int rw_numa_no_readers(rw_numa_lock_t* lock) {
+    uint32_t s;
+    uint32_t n = rw_numa_sockets();
+    for (s = 0; s < n; s++) {
+        if (lock->readers[s].count != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void rw_numa_read_acquire(rw_numa_lock_t* lock, rw_numa_local_params* local_d) {
+    volatile uint32_t* count = &lock->readers[*local_d].count;
+    //the increment is a full barrier: a writer setting its flag afterwards sees us
+    FAI_U32(count);
+    if (lock->writer == 0) {
+        return;
+    }
+    DAF_U32(count);
+
+    //a writer holds the lock or waits for the readers to leave
+    FAI_U32(&lock->read_waiters);
+    while (1) {
+        while (lock->writer != 0) {
+            PAUSE;
+        }
+        FAI_U32(count);
+        if (lock->writer == 0) {
+            break;
+        }
+        DAF_U32(count);
+    }
+    DAF_U32(&lock->read_waiters);
+}
+
+void rw_numa_read_release(rw_numa_lock_t* lock, rw_numa_local_params* local_d) {
+    DAF_U32(&lock->readers[*local_d].count);
+}
+
+void rw_numa_write_acquire(rw_numa_lock_t* lock) {
+    while (1) {
+        if (lock->policy == RW_NUMA_NEUTRAL) {
+            //let the readers blocked by the previous writer in first
+            while (lock->read_waiters != 0) {
+                PAUSE;
+            }
+        }
+        while (lock->writer != 0) {
+            PAUSE;
+        }
+        if (lock->policy == RW_NUMA_NEUTRAL && lock->read_waiters != 0) {
+            continue;
+        }
+        if (CAS_U32(&lock->writer, 0, 1) == 0) {
+            break;
+        }
+    }
+    //new readers back off; wait for the ones inside
+    while (!rw_numa_no_readers(lock)) {
+        PAUSE;
+    }
+}
+
+void rw_numa_write_release(rw_numa_lock_t* lock) {
+    COMPILER_BARRIER;
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    lock->writer = 0;
+}
+
+int rw_numa_write_trylock(rw_numa_lock_t* lock) {
+    if (lock->writer != 0 || CAS_U32(&lock->writer, 0, 1) != 0) {
+        return 1;
+    }
+    if (!rw_numa_no_readers(lock)) {
+        lock->writer = 0;
+        return 1;
+    }
+    return 0;
+}
+
+int is_free_rw_numa(rw_numa_lock_t* lock) {
+    if (lock->writer == 0 && rw_numa_no_readers(lock)) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  Initialization
+ */
+
+static void init_rw_numa_lock(rw_numa_lock_t* the_lock) {
+    uint32_t s;
+    the_lock->writer = 0;
+    the_lock->read_waiters = 0;
+    the_lock->policy = RW_NUMA_POLICY;
+    for (s = 0; s < MAX_SOCKETS; s++) {
+        the_lock->readers[s].count = 0;
+    }
+}
+
+rw_numa_lock_t* init_rw_numa_array_global(uint32_t num_locks) {
+    rw_numa_lock_t* the_locks;
+    the_locks = (rw_numa_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(rw_numa_lock_t));
+    assert(the_locks != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        init_rw_numa_lock(&the_locks[i]);
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+rw_numa_local_params* init_rw_numa_array_local(uint32_t thread_num, uint32_t num_locks) {
+    set_cpu(thread_num);
+    rw_numa_local_params* local_params;
+    local_params = (rw_numa_local_params*) malloc(num_locks * sizeof(rw_numa_local_params));
+    uint32_t socket = get_cluster(thread_num);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        local_params[i] = socket;
+    }
+    MEM_BARRIER;
+    return local_params;
+}
+
+void end_rw_numa_array_local(rw_numa_local_params* local_params) {
+    free(local_params);
+}
+
+void end_rw_numa_array_global(rw_numa_lock_t* the_locks) {
+    free(the_locks);
+}
+
+int init_rw_numa_global(rw_numa_lock_t* the_lock) {
+    init_rw_numa_lock(the_lock);
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_rw_numa_local(uint32_t thread_num, rw_numa_local_params* local_d) {
+    set_cpu(thread_num);
+    *local_d = get_cluster(thread_num);
+    MEM_BARRIER;
+    return 0;
+}
+
+void end_rw_numa_local(rw_numa_local_params local_d) {
+    //method not needed
+}
+
+void end_rw_numa_global(rw_numa_lock_t the_lock) {
+    //method not needed
+}
+
+void rw_numa_set_policy(rw_numa_lock_t* the_lock, uint32_t policy) {
+    the_lock->policy = policy;
+    MEM_BARRIER;
+}
@@ -0,0 +1,277 @@
+/*
+ * File: shfl.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Implementation of the shuffling lock
+ *
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+#include "shfl.h"
+
+static shfl_policy_t shfl_policy = shfl_policy_numa;
+static pthread_once_t shfl_policy_read = PTHREAD_ONCE_INIT;
+
+__thread uint32_t shfl_socket = 0;
+__thread uint32_t shfl_key = 0;
+
+/*
+ *  Policies
+ */
+
+int shfl_policy_numa(shfl_node_t* shuffler, shfl_node_t* waiter) {
+    return waiter->socket == shuffler->socket;
+}
+
+int shfl_policy_priority(shfl_node_t* shuffler, shfl_node_t* waiter) {
+    return waiter->key >= shuffler->key;
+}
+
+int shfl_policy_class(shfl_node_t* shuffler, shfl_node_t* waiter) {
+    return waiter->key == shuffler->key;
+}
+
+void shfl_set_policy(shfl_policy_t policy) {
+    shfl_policy = policy;
+    MEM_BARRIER;
+}
+
+void shfl_set_key(uint32_t key) {
+    shfl_key = key;
+}
+
+static void shfl_read_policy() {
+    char* env = getenv(SHFL_POLICY_ENV);
+    if (env == NULL) {
+        return;
+    }
+    if (strcmp(env, "numa") == 0) {
+        shfl_set_policy(shfl_policy_numa);
+    } else if (strcmp(env, "priority") == 0) {
+        shfl_set_policy(shfl_policy_priority);
+    } else if (strcmp(env, "class") == 0) {
+        shfl_set_policy(shfl_policy_class);
+    } else {
+        fprintf(stderr, "unknown %s: %s\n", SHFL_POLICY_ENV, env);
+    }
+}
+
+/*
+ *  Acquire and release methods
+ */
+
+//called by the shuffler while it waits: moves the waiters grouped with it by the
+//policy right behind it and the ones moved before, then hands the role to the last
+//of them. Only the shuffler changes the links behind itself, and the tail is never
+//moved, since its successor may be linking itself to it.
+static void shfl_shuffle(shfl_node_t* s) {
+    uint32_t batch = s->batch;
+    if (batch >= SHFL_MAX_BATCH) {
+        return;
+    }
+    shfl_policy_t policy = shfl_policy;
+    shfl_node_t* last = s; //last waiter of the group
+    shfl_node_t* prev = s;
+    shfl_node_t* cur = s->next;
+    while (cur != NULL && batch < SHFL_MAX_BATCH) {
+        shfl_node_t* next = cur->next;
+        if (next == NULL) {
+            break;
+        }
+        if (policy(s, cur)) {
+            if (prev == last) {
+                prev = cur;
+            } else {
+                prev->next = next;
+                cur->next = last->next;
+                last->next = cur;
+            }
+            last = cur;
+            batch++;
+        } else {
+            prev = cur;
+        }
+        cur = next;
+    }
+    if (last != s) {
+        MEM_BARRIER;
+        last->batch = batch;
+        s->shuffler = 0;
+        last->shuffler = 1;
+    }
+}
+
+int shfl_trylock(shfl_lock_t* lock) {
+    if (lock->val == 0 && CAS_U32(&lock->val, 0, SHFL_LOCKED) == 0) {
+        return 0;
+    }
+    return 1;
+}
+
+void shfl_acquire(shfl_lock_t* lock) {
+    uint32_t val;
+    if (CAS_U32(&lock->val, 0, SHFL_LOCKED) == 0) {
+        return;
+    }
+    uint32_t tid = qtail_thread_init();
+    uint32_t idx = qtail_nesting;
+    if (idx >= QTAIL_MAX_NESTING || tid == 0) {
+        //out of nodes or of thread ids: spin on the lock word
+        while (shfl_trylock(lock) != 0) {
+            PAUSE;
+        }
+        return;
+    }
+    qtail_nesting++;
+    shfl_node_t* node = (shfl_node_t*) qtail_node(tid, idx);
+    node->next = NULL;
+    node->status = SHFL_WAIT;
+    node->shuffler = 0;
+    node->batch = 0;
+    node->socket = shfl_socket;
+    node->key = shfl_key;
+    COMPILER_BARRIER;
+    //the lock may have been released meanwhile
+    if (shfl_trylock(lock) == 0) {
+        qtail_nesting--;
+        return;
+    }
+
+    uint32_t tail = qtail_encode(tid, idx);
+    uint32_t old = ((uint32_t) SWAP_U16(&lock->tail, (uint16_t) (tail >> 16))) << 16;
+    if (old != 0) {
+        shfl_node_t* prev = (shfl_node_t*) qtail_decode(old);
+        prev->next = node;
+        while (node->status == SHFL_WAIT) {
+            if (node->shuffler) {
+                shfl_shuffle(node);
+            }
+            PAUSE;
+        }
+    } else {
+        //the first waiter of a queue starts with the shuffler role
+        node->shuffler = 1;
+    }
+
+    //head of the queue: keep shuffling until the owner leaves
+    while ((val = lock->val) & SHFL_LOCKED_MASK) {
+        if (node->shuffler) {
+            shfl_shuffle(node);
+        }
+        PAUSE;
+    }
+    if ((val & SHFL_TAIL_MASK) == tail && CAS_U32(&lock->val, val, SHFL_LOCKED) == val) {
+        //last in the queue, the tail is cleared
+        qtail_nesting--;
+        return;
+    }
+    //while the tail is set nobody else takes the lock
+    lock->locked = SHFL_LOCKED;
+    shfl_node_t* next;
+    while ((next = node->next) == NULL) {
+        PAUSE;
+    }
+    if (node->shuffler) {
+        next->batch = 0;
+        next->shuffler = 1;
+    }
+    next->status = SHFL_HEAD;
+    qtail_nesting--;
+}
+
+void shfl_release(shfl_lock_t* lock) {
+#ifdef __tile__
+    MEM_BARRIER;
+#endif
+    COMPILER_BARRIER;
+    lock->locked = 0;
+}
+
+int is_free_shfl(shfl_lock_t* lock) {
+    if ((lock->val & SHFL_LOCKED_MASK) == 0) return 1;
+    return 0;
+}
+
+uint32_t shfl_queue_length(shfl_lock_t* lock) {
+    uint32_t val = lock->val;
+    return ((val & SHFL_LOCKED_MASK) != 0) + ((val & SHFL_TAIL_MASK) != 0);
+}
+
+/*
+ *  Initialization
+ */
+
+static inline void shfl_local_init(uint32_t thread_num) {
+    set_cpu(thread_num);
+    qtail_thread_init();
+    shfl_socket = get_cluster(thread_num);
+    MEM_BARRIER;
+}
+
+shfl_lock_t* init_shfl_array_global(uint32_t num_locks) {
+    pthread_once(&shfl_policy_read, shfl_read_policy);
+    shfl_lock_t* the_locks;
+    the_locks = (shfl_lock_t*) memalign(CACHE_LINE_SIZE, num_locks * sizeof(shfl_lock_t));
+    assert(the_locks != NULL);
+    uint32_t i;
+    for (i = 0; i < num_locks; i++) {
+        the_locks[i].val = 0;
+    }
+    MEM_BARRIER;
+    return the_locks;
+}
+
+void init_shfl_array_local(uint32_t thread_num) {
+    shfl_local_init(thread_num);
+}
+
+void end_shfl_array_local() {
+    qtail_release_tid();
+}
+
+void end_shfl_array_global(shfl_lock_t* the_locks) {
+    free(the_locks);
+}
+
+int init_shfl_global(shfl_lock_t* the_lock) {
+    pthread_once(&shfl_policy_read, shfl_read_policy);
+    the_lock->val = 0;
+    MEM_BARRIER;
+    return 0;
+}
+
+int init_shfl_local(uint32_t thread_num) {
+    shfl_local_init(thread_num);
+    return 0;
+}
+
+void end_shfl_local() {
+    qtail_release_tid();
+}
+
+void end_shfl_global(shfl_lock_t the_lock) {
+    //method not needed
+}
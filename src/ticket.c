@@ -39,6 +39,89 @@ __thread uint64_t ticket_queued_total = 0;
 __thread uint64_t ticket_acquires = 0;
 #endif
 
+#if defined(SPIN_THEN_PARK)
+__thread ticks ticket_park_budget = PARK_SPIN_INIT;
+
+/* a sleeping waiter is only woken when the head reaches its ticket */
+#  define TICKET_PARK_BIT(t) (1U << ((t) % 32))
+
+static void
+ticket_park(ticketlock_t* lock, uint32_t my_ticket)
+{
+  uint32_t cur;
+  park_budget_parked(&ticket_park_budget);
+  IAF_U32(&(lock->parked));
+  while ((cur = lock->head) != my_ticket)
+    {
+      park_wait_bitset(&(lock->head), cur, TICKET_PARK_BIT(my_ticket));
+    }
+  DAF_U32(&(lock->parked));
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+/* back-off of the waiters, in nops, until ticket_calibrate measures the nop */
+static uint32_t ticket_base_wait = TICKET_BASE_WAIT_CYCLES / NOP_DURATION;
+static uint32_t ticket_wait_next = TICKET_WAIT_NEXT_CYCLES / NOP_DURATION;
+#endif
+static double ticket_nop_cycles = NOP_DURATION;
+static pthread_once_t ticket_calibrated = PTHREAD_ONCE_INIT;
+
+#define TICKET_CALIBRATE_NOPS 1000000
+
+static void
+ticket_do_calibrate()
+{
+  /* as get_noop_duration, but keeping the fraction of a cycle; the getticks correction
+     is taken from a few reads only, getticks_correction_calc takes too long for startup */
+  ticks corr = ~0ULL;
+  int i;
+  for (i = 0; i < 16; i++)
+    {
+      ticks t0 = getticks();
+      ticks t1 = getticks();
+      if (t1 - t0 < corr)
+        {
+	  corr = t1 - t0;
+        }
+    }
+  ticks start = getticks();
+  nop_rep(TICKET_CALIBRATE_NOPS);
+  ticks end = getticks();
+  if (end - start > corr)
+    {
+      ticket_nop_cycles = (end - start - corr) / (double) TICKET_CALIBRATE_NOPS;
+    }
+  if (ticket_nop_cycles < 0.05)
+    {
+      ticket_nop_cycles = 0.05;
+    }
+
+  ticks base = TICKET_BASE_WAIT_CYCLES;
+  char* env = getenv(TICKET_BACKOFF_ENV);
+  if (env != NULL)
+    {
+      base = strtoull(env, NULL, 10);
+    }
+  ticket_set_backoff(base);
+}
+
+void
+ticket_calibrate()
+{
+  pthread_once(&ticket_calibrated, ticket_do_calibrate);
+}
+
+void
+ticket_set_backoff(ticks base_cycles)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  ticket_base_wait = (uint32_t) (base_cycles / ticket_nop_cycles);
+  ticket_wait_next = (uint32_t) (base_cycles * TICKET_WAIT_NEXT / TICKET_BASE_WAIT / ticket_nop_cycles);
+  MEM_BARRIER;
+#endif
+}
+
 static inline uint32_t
 sub_abs(const uint32_t a, const uint32_t b)
 {
@@ -73,7 +156,25 @@ ticket_acquire(ticketlock_t* lock)
   uint32_t my_ticket = IAF_U32(&(lock->tail));
 
 
-#if defined(OPTERON_OPTIMIZE)
+#if defined(SPIN_THEN_PARK)
+  if (lock->head == my_ticket)
+    {
+      return;
+    }
+  uint32_t spins = 0;
+  ticks start = getticks();
+  while (lock->head != my_ticket)
+    {
+      if (park_spin_done(start, ticket_park_budget, &spins))
+        {
+	  ticket_park(lock, my_ticket);
+	  return;
+        }
+      PAUSE;
+    }
+  park_budget_spun(&ticket_park_budget, getticks() - start);
+
+#elif defined(OPTERON_OPTIMIZE)
   uint32_t wait = TICKET_BASE_WAIT;
   uint32_t distance_prev = 1;
 #  if defined(MEASURE_CONTENTION)
@@ -126,13 +227,13 @@ ticket_acquire(ticketlock_t* lock)
   /* backoff proportional to the distance would make sense even without the PREFETCHW */
   /* however, I did some tests on the Niagara and it performed worse */
 
-#  if defined(__x86_64__)
+#  if defined(__x86_64__) || defined(__i386__)
 #    if defined(MEASURE_CONTENTION)
   uint8_t once = 1;
   ticket_acquires++;
 #    endif
 
-  uint32_t wait = TICKET_BASE_WAIT;
+  uint32_t wait = ticket_base_wait;
   uint32_t distance_prev = 1;
 
   while (1)
@@ -142,6 +243,11 @@ ticket_acquire(ticketlock_t* lock)
         {
 	  break;
         }
+      if (wait == 0)
+        {
+	  PAUSE;
+	  continue;
+        }
       uint32_t distance = sub_abs(cur, my_ticket);
 
 #  if defined(MEASURE_CONTENTION)
@@ -157,14 +263,14 @@ ticket_acquire(ticketlock_t* lock)
 	  if (distance != distance_prev)
             {
 	      distance_prev = distance;
-	      wait = TICKET_BASE_WAIT;
+	      wait = ticket_base_wait;
             }
 
 	  nop_rep(distance * wait);
         }
       else
         {
-	  nop_rep(TICKET_WAIT_NEXT);
+	  nop_rep(ticket_wait_next);
         }
 
       if (distance > 20)
@@ -191,14 +297,28 @@ ticket_release(ticketlock_t* lock)
   PREFETCHW(lock);
 #endif	/* OPTERON */
   COMPILER_BARRIER;
+#if defined(SPIN_THEN_PARK)
+  uint32_t next = lock->head + 1;
+  lock->head = next;
+  MEM_BARRIER;			/* the parked count is read after the new head is visible */
+  if (lock->parked != 0)
+    {
+      park_wake_bitset(&(lock->head), TICKET_PARK_BIT(next));
+    }
+#else
   lock->head++;
+#endif
 }
 
 
 int create_ticketlock(ticketlock_t* the_lock) 
 {
+    ticket_calibrate();
     the_lock->head=1;
     the_lock->tail=0;
+#if defined(SPIN_THEN_PARK)
+    the_lock->parked=0;
+#endif
     MEM_BARRIER;
     return 0;
 }
@@ -216,18 +336,23 @@ int is_free_ticket(ticketlock_t* t)
 void init_thread_ticketlocks(uint32_t thread_num) 
 {
   set_cpu(thread_num);
+  ticket_calibrate();
 }
 
 ticketlock_t* 
 init_ticketlocks(uint32_t num_locks) 
 {
   ticketlock_t* the_locks;
+  ticket_calibrate();
   the_locks = (ticketlock_t*) malloc(num_locks * sizeof(ticketlock_t));
   uint32_t i;
   for (i = 0; i < num_locks; i++) 
     {
       the_locks[i].head=1;
       the_locks[i].tail=0;
+#if defined(SPIN_THEN_PARK)
+      the_locks[i].parked=0;
+#endif
     }
   MEM_BARRIER;
   return the_locks;
@@ -0,0 +1,270 @@
+/*
+ * File: topology.c
+ * Author: Tudor David <tudor.david@epfl.ch>
+ *
+ * Description:
+ *      Discovery of the machine topology from /sys/devices/system
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Tudor David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "topology.h"
+
+#ifndef SYS_CPU
+#define SYS_CPU "/sys/devices/system/cpu"
+#endif
+#ifndef SYS_NODE
+#define SYS_NODE "/sys/devices/system/node"
+#endif
+#define MAX_CACHE_INDEX 10
+
+topology_t topology;
+static volatile int topology_done = 0;
+
+//reads a single integer; returns 0 on success
+static int read_int(const char* path, int* val) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return 1;
+    int ret = (fscanf(f, "%d", val) == 1) ? 0 : 1;
+    fclose(f);
+    return ret;
+}
+
+//reads a list such as "0-3,8,10-11" into mask; returns the number of cpus
+//in the list and stores the lowest one in first (-1 if the list is empty)
+static int read_cpulist(const char* path, uint8_t* mask, int* first) {
+    char buf[4096];
+    int count = 0;
+    *first = -1;
+    if (mask != NULL) memset(mask, 0, TOPOLOGY_MAX_CPUS);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return 0;
+    if (fgets(buf, sizeof(buf), f) == NULL) {
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    char* p = buf;
+    while (*p != '\0' && *p != '\n') {
+        char* end;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            p++;
+            hi = strtol(p, &end, 10);
+            p = end;
+        }
+        long c;
+        for (c = lo; c <= hi && c < TOPOLOGY_MAX_CPUS; c++) {
+            if (mask != NULL) mask[c] = 1;
+            if (*first < 0 || c < *first) *first = c;
+            count++;
+        }
+        if (*p == ',') p++;
+    }
+    return count;
+}
+
+//position of cpu among the cpus of a list
+static int cpulist_index(const char* path, int cpu) {
+    uint8_t mask[TOPOLOGY_MAX_CPUS];
+    int first;
+    if (read_cpulist(path, mask, &first) == 0) return 0;
+    int c, index = 0;
+    for (c = 0; c < cpu; c++) {
+        if (mask[c]) index++;
+    }
+    return index;
+}
+
+//the topology of a machine we know nothing about: one socket, one node
+static void topology_fallback() {
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    if (n < 1) n = 1;
+    if (n > TOPOLOGY_MAX_CPUS) n = TOPOLOGY_MAX_CPUS;
+    memset(&topology, 0, sizeof(topology));
+    topology.num_cpus = n;
+    topology.num_sockets = 1;
+    topology.num_nodes = 1;
+    topology.num_llcs = 1;
+    topology.num_cores = n;
+    topology.cpus_per_socket = n;
+    uint32_t c;
+    for (c = 0; c < TOPOLOGY_MAX_CPUS; c++) {
+        topology.cpu_core[c] = c;
+        topology.cores[c] = c % n;
+    }
+}
+
+void topology_init() {
+    char path[256];
+    uint8_t online[TOPOLOGY_MAX_CPUS];
+    int16_t package[TOPOLOGY_MAX_CPUS];
+    int16_t core_key[TOPOLOGY_MAX_CPUS];
+    int16_t llc_key[TOPOLOGY_MAX_CPUS];
+    int socket_ids[TOPOLOGY_MAX_SOCKETS];
+    uint32_t socket_cpus[TOPOLOGY_MAX_SOCKETS];
+    int first, c, i;
+
+    if (topology_done) return;
+    topology_done = 1;
+
+    int num_online = read_cpulist(SYS_CPU "/online", online, &first);
+    if (num_online == 0) {
+        topology_fallback();
+        return;
+    }
+
+    memset(&topology, 0, sizeof(topology));
+    int max_cpu = 0;
+    for (c = 0; c < TOPOLOGY_MAX_CPUS; c++) {
+        package[c] = -1;
+        core_key[c] = -1;
+        llc_key[c] = -1;
+        if (!online[c]) continue;
+        max_cpu = c;
+
+        int val;
+        snprintf(path, sizeof(path), SYS_CPU "/cpu%d/topology/physical_package_id", c);
+        package[c] = (read_int(path, &val) == 0 && val >= 0) ? val : 0;
+
+        //the hardware threads of a core are identified by the first of them
+        snprintf(path, sizeof(path), SYS_CPU "/cpu%d/topology/thread_siblings_list", c);
+        read_cpulist(path, NULL, &first);
+        core_key[c] = (first >= 0) ? first : c;
+        topology.cpu_smt[c] = cpulist_index(path, c);
+
+        //the last level cache is the highest level cache found, identified by the first cpu sharing it
+        int index, level, best_level = 0;
+        for (index = 0; index < MAX_CACHE_INDEX; index++) {
+            snprintf(path, sizeof(path), SYS_CPU "/cpu%d/cache/index%d/level", c, index);
+            if (read_int(path, &level) != 0) break;
+            if (level < best_level) continue;
+            snprintf(path, sizeof(path), SYS_CPU "/cpu%d/cache/index%d/shared_cpu_list", c, index);
+            read_cpulist(path, NULL, &first);
+            if (first >= 0) {
+                best_level = level;
+                llc_key[c] = first;
+            }
+        }
+        if (llc_key[c] < 0) llc_key[c] = package[c] + TOPOLOGY_MAX_CPUS / 2;
+    }
+    topology.num_cpus = max_cpu + 1;
+
+    //dense numbering of the sockets, cores and caches, in the order of the cpus
+    int16_t core_index[TOPOLOGY_MAX_CPUS];
+    int16_t llc_index[TOPOLOGY_MAX_CPUS];
+    for (c = 0; c < TOPOLOGY_MAX_CPUS; c++) {
+        core_index[c] = -1;
+        llc_index[c] = -1;
+    }
+    memset(socket_cpus, 0, sizeof(socket_cpus));
+    for (c = 0; c <= max_cpu; c++) {
+        if (!online[c]) continue;
+        for (i = 0; i < (int) topology.num_sockets; i++) {
+            if (socket_ids[i] == package[c]) break;
+        }
+        if (i == (int) topology.num_sockets) {
+            if (topology.num_sockets < TOPOLOGY_MAX_SOCKETS) {
+                socket_ids[topology.num_sockets++] = package[c];
+            } else {
+                fprintf(stderr, "topology: more than %d sockets, folding socket %d\n", TOPOLOGY_MAX_SOCKETS, package[c]);
+                i = package[c] % TOPOLOGY_MAX_SOCKETS;
+            }
+        }
+        topology.cpu_socket[c] = i;
+        socket_cpus[i]++;
+
+        if (core_index[core_key[c]] < 0) core_index[core_key[c]] = topology.num_cores++;
+        topology.cpu_core[c] = core_index[core_key[c]];
+        int key = llc_key[c] % TOPOLOGY_MAX_CPUS;
+        if (llc_index[key] < 0) llc_index[key] = topology.num_llcs++;
+        topology.cpu_llc[c] = llc_index[key];
+    }
+    for (i = 0; i < (int) topology.num_sockets; i++) {
+        if (socket_cpus[i] > topology.cpus_per_socket) topology.cpus_per_socket = socket_cpus[i];
+    }
+
+    //NUMA nodes; without the node directory everything is on node 0
+    uint8_t nodes[TOPOLOGY_MAX_CPUS];
+    uint8_t node_cpus[TOPOLOGY_MAX_CPUS];
+    topology.num_nodes = 1;
+    if (read_cpulist(SYS_NODE "/online", nodes, &first) > 0) {
+        int n;
+        for (n = 0; n < TOPOLOGY_MAX_CPUS; n++) {
+            if (!nodes[n]) continue;
+            topology.num_nodes = n + 1;
+            snprintf(path, sizeof(path), SYS_NODE "/node%d/cpulist", n);
+            if (read_cpulist(path, node_cpus, &first) == 0) continue;
+            for (c = 0; c <= max_cpu; c++) {
+                if (node_cpus[c]) topology.cpu_node[c] = n;
+            }
+        }
+    }
+    for (i = 0; i < TOPOLOGY_MAX_SOCKETS; i++) {
+        topology.socket_node[i] = 0;
+    }
+    for (c = max_cpu; c >= 0; c--) {
+        if (online[c]) topology.socket_node[topology.cpu_socket[c]] = topology.cpu_node[c];
+    }
+
+    //placement: one socket after the other, the SMT siblings after all the cores
+    int smt, s, pos = 0;
+    for (smt = 0; pos < num_online && smt < 256; smt++) {
+        for (s = 0; s < (int) topology.num_sockets; s++) {
+            for (c = 0; c <= max_cpu; c++) {
+                if (online[c] && topology.cpu_socket[c] == s && topology.cpu_smt[c] == smt) {
+                    topology.cores[pos++] = c;
+                }
+            }
+        }
+    }
+    for (i = pos; i < TOPOLOGY_MAX_CPUS; i++) {
+        topology.cores[i] = topology.cores[i % pos];
+    }
+}
+
+__attribute__((constructor)) static void topology_constructor() {
+    topology_init();
+}
+
+void topology_print(FILE* f) {
+    uint32_t c;
+    fprintf(f, "Topology: %u cpus, %u cores, %u sockets, %u NUMA nodes, %u LLCs\n",
+            topology.num_cpus, topology.num_cores, topology.num_sockets, topology.num_nodes, topology.num_llcs);
+    fprintf(f, "%5s %6s %6s %6s %6s %6s\n", "cpu", "socket", "node", "llc", "core", "smt");
+    for (c = 0; c < topology.num_cpus; c++) {
+        fprintf(f, "%5u %6d %6d %6d %6d %6d\n", c, topology.cpu_socket[c], topology.cpu_node[c],
+                topology.cpu_llc[c], topology.cpu_core[c], topology.cpu_smt[c]);
+    }
+    fprintf(f, "Placement:");
+    for (c = 0; c < topology.num_cpus; c++) {
+        fprintf(f, " %d", topology.cores[c]);
+    }
+    fprintf(f, "\n");
+}
@@ -32,45 +32,95 @@
 
 #define UNLOCKED 0
 #define LOCKED 1
+#define PARKED 2 //locked, and there may be sleeping waiters
 
 __thread unsigned long * ttas_seeds;
+#if defined(SPIN_THEN_PARK)
+__thread ticks ttas_park_budget = PARK_SPIN_INIT;
+#endif
 
 
 int ttas_trylock(ttas_lock_t * the_lock, uint32_t * limits) {
+#if defined(SPIN_THEN_PARK)
+    if (CAS_U32(&(the_lock->lock), UNLOCKED, LOCKED)==UNLOCKED) return 0;
+#else
     if (TAS_U8(&(the_lock->lock))==0) return 0;
+#endif
     return 1;
 }
 
 void ttas_lock(ttas_lock_t * the_lock, uint32_t* limit) {
-#if defined(OPTERON_OPTIMIZE)
+#if defined(SPIN_THEN_PARK)
     volatile ttas_lock_data_t* l = &(the_lock->lock);
+    if (CAS_U32(l, UNLOCKED, LOCKED)==UNLOCKED) {
+        ttas_learn(the_lock, 0);
+        return;
+    }
     uint32_t delay;
+    uint32_t spins = 0;
+    uint32_t failures = 1;
+    uint32_t lim = ttas_start_limit(the_lock);
+    ticks start = getticks();
+    while (!park_spin_done(start, ttas_park_budget, &spins)) {
+        if ((*l)==UNLOCKED) {
+            if (CAS_U32(l, UNLOCKED, LOCKED)==UNLOCKED) {
+                park_budget_spun(&ttas_park_budget, getticks() - start);
+                ttas_learn(the_lock, failures);
+                return;
+            }
+            //backoff
+            failures++;
+            delay = my_random(&(ttas_seeds[0]),&(ttas_seeds[1]),&(ttas_seeds[2]))%lim;
+            lim = MAX_DELAY > 2*lim ? 2*lim : MAX_DELAY;
+            cdelay(delay);
+        }
+        PAUSE;
+    }
+    //out of budget: mark the lock as having sleepers, and sleep until it is released
+    park_budget_parked(&ttas_park_budget);
+    while (SWAP_U32(l, PARKED)!=UNLOCKED) {
+        failures++;
+        park_wait(l, PARKED);
+    }
+    ttas_learn(the_lock, failures);
+
+#elif defined(OPTERON_OPTIMIZE)
+    volatile ttas_lock_data_t* l = &(the_lock->lock);
+    uint32_t delay;
+    uint32_t failures = 0;
+    uint32_t lim = ttas_start_limit(the_lock);
     while (1){
         PREFETCHW(l);
         while ((*l)==1) {
             PREFETCHW(l);
         }
         if (TAS_U8(&(the_lock->lock))==UNLOCKED) {
+            ttas_learn(the_lock, failures);
             return;
         } else {
             //backoff
-            delay = my_random(&(ttas_seeds[0]),&(ttas_seeds[1]),&(ttas_seeds[2]))%(*limit);
-            *limit = MAX_DELAY > 2*(*limit) ? 2*(*limit) : MAX_DELAY;
+            failures++;
+            delay = my_random(&(ttas_seeds[0]),&(ttas_seeds[1]),&(ttas_seeds[2]))%lim;
+            lim = MAX_DELAY > 2*lim ? 2*lim : MAX_DELAY;
             cdelay(delay);
         }
     }
 
 #else  /* !OPTERON_OPTIMIZE */
     uint32_t delay;
+    uint32_t failures = 0;
+    uint32_t lim = ttas_start_limit(the_lock);
     volatile ttas_lock_data_t* l = &(the_lock->lock);
     while (1){
         while ((*l)==1) {}
         if (TAS_U8(l)==UNLOCKED) {
+            ttas_learn(the_lock, failures);
             return;
         } else {
             //backoff
-            delay = my_random(&(ttas_seeds[0]),&(ttas_seeds[1]),&(ttas_seeds[2]))%(*limit);
-            *limit = MAX_DELAY > 2*(*limit) ? 2*(*limit) : MAX_DELAY;
+            failures++;
+            delay = my_random(&(ttas_seeds[0]),&(ttas_seeds[1]),&(ttas_seeds[2]))%lim;
+            lim = MAX_DELAY > 2*lim ? 2*lim : MAX_DELAY;
             cdelay(delay);
         }
     }
@@ -89,7 +139,13 @@ void ttas_unlock(ttas_lock_t *the_lock)
     MEM_BARRIER;
 #endif
     COMPILER_BARRIER;
+#if defined(SPIN_THEN_PARK)
+    if (SWAP_U32(&(the_lock->lock), UNLOCKED)==PARKED) {
+        park_wake(&(the_lock->lock), 1);
+    }
+#else
     the_lock->lock=0;
+#endif
 }
 
 
@@ -106,6 +162,7 @@ ttas_lock_t* init_ttas_array_global(uint32_t num_locks) {
     uint32_t i;
     for (i = 0; i < num_locks; i++) {
         the_locks[i].lock=0;
+        the_locks[i].contention=0;
     }
     MEM_BARRIER;
     return the_locks;
@@ -136,6 +193,7 @@ void end_ttas_array_global(ttas_lock_t* the_locks) {
 
 int init_ttas_global(ttas_lock_t* the_lock) {
     the_lock->lock=0;
+    the_lock->contention=0;
     MEM_BARRIER;
     return 0;
 }